@@ -137,6 +137,9 @@ static std::future<MBErrPair> createFutureForFile(std::string path) {
   auto strategy = std::launch::deferred;
 #endif
   return std::async(strategy, [=]() {
+    if (Optional<MemoryBufferRef> mbref = findInMemoryFile(path))
+      return MBErrPair{MemoryBuffer::getMemBuffer(*mbref, false),
+                       std::error_code()};
     auto mbOrErr = MemoryBuffer::getFile(path,
                                          /*FileSize*/ -1,
                                          /*RequiresNullTerminator*/ false);
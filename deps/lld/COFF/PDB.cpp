@@ -57,6 +57,7 @@
 #include "llvm/Support/JamCRC.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ScopedPrinter.h"
+#include <atomic>
 #include <memory>
 
 using namespace lld;
@@ -123,6 +124,13 @@ public:
   Expected<const CVIndexMap &> mergeDebugT(ObjFile *file,
                                            CVIndexMap *objectIndexMap);
 
+  /// With /DEBUG:GHASH, merge the type and item records of all object files
+  /// at once, deduplicating them by their global hashes in parallel. The
+  /// resulting index maps are stored in ghashIndexMaps. Returns false if some
+  /// object uses a type server PDB or precompiled headers; those are merged
+  /// one object at a time by mergeDebugT.
+  bool mergeDebugTInParallel();
+
   /// Reads and makes available a PDB.
   Expected<const CVIndexMap &> maybeMergeTypeServerPDB(ObjFile *file);
 
@@ -184,6 +192,11 @@ private:
   /// far.
   std::map<uint32_t, CVIndexMap> precompTypeIndexMappings;
 
+  /// Type index mappings of each object in ObjFile::instances, if the types
+  /// were merged by mergeDebugTInParallel.
+  std::vector<CVIndexMap> ghashIndexMaps;
+  bool typesMergedInParallel = false;
+
   // For statistics
   uint64_t globalSymbols = 0;
   uint64_t moduleSymbols = 0;
@@ -336,8 +349,8 @@ Expected<const CVIndexMap &>
 PDBLinker::mergeDebugT(ObjFile *file, CVIndexMap *objectIndexMap) {
   ScopedTimer t(typeMergingTimer);
 
-  if (!file->debugTypesObj)
-    return *objectIndexMap; // no Types stream
+  if (!file->debugTypesObj || typesMergedInParallel)
+    return *objectIndexMap; // no Types stream, or already merged
 
   // Precompiled headers objects need to save the index map for further
   // reference by other objects which use the precompiled headers.
@@ -587,6 +600,238 @@ static bool remapTypeIndex(TypeIndex &ti, ArrayRef<TypeIndex> typeIndexMap) {
   return true;
 }
 
+namespace {
+/// The type stream of an object file, prepared for mergeDebugTInParallel.
+struct GHashSource {
+  ObjFile *file;
+  CVIndexMap *indexMap;
+  std::vector<CVType> records;
+  ArrayRef<GloballyHashedType> hashes;
+  std::vector<GloballyHashedType> ownedHashes;
+
+  /// The PDB type or item index of each record that is the first occurrence
+  /// of its global hash. Other entries are unused.
+  std::vector<TypeIndex> uniqueIndices;
+};
+
+/// A lock-free open addressing hash table of type records, keyed by global
+/// hash. A cell names a record by its source and its position in that
+/// source's type stream, so it fits in a 64-bit word and can be inserted with
+/// a single compare-and-swap. Item records have the top bit set, so that they
+/// sort after type records.
+///
+/// When several sources insert the same record, the lowest cell wins. Cells
+/// are ordered by source, i.e. by command line order, so the table contents
+/// do not depend on thread scheduling.
+class GHashTable {
+public:
+  GHashTable(ArrayRef<GHashSource> sources, size_t numRecords)
+      : sources(sources), mask(PowerOf2Ceil(numRecords * 2) - 1),
+        table(mask + 1) {}
+
+  static uint64_t makeCell(bool isItem, uint32_t sourceIdx, uint32_t recIdx) {
+    return uint64_t(isItem) << 63 | uint64_t(sourceIdx + 1) << 32 | recIdx;
+  }
+  static bool isItem(uint64_t cell) { return cell >> 63; }
+  static uint32_t getSourceIndex(uint64_t cell) {
+    return ((cell >> 32) & 0x7fffffff) - 1;
+  }
+  static uint32_t getRecordIndex(uint64_t cell) { return uint32_t(cell); }
+
+  void insert(uint64_t newCell);
+  uint64_t lookup(const GloballyHashedType &hash) const;
+  std::vector<uint64_t> getCells() const;
+
+private:
+  const GloballyHashedType &getHash(uint64_t cell) const {
+    return sources[getSourceIndex(cell)].hashes[getRecordIndex(cell)];
+  }
+  size_t getBucket(const GloballyHashedType &hash) const {
+    return support::endian::read64le(hash.Hash.data()) & mask;
+  }
+
+  ArrayRef<GHashSource> sources;
+  size_t mask;
+  std::vector<std::atomic<uint64_t>> table;
+};
+} // namespace
+
+void GHashTable::insert(uint64_t newCell) {
+  const GloballyHashedType &hash = getHash(newCell);
+  for (size_t i = getBucket(hash);; i = (i + 1) & mask) {
+    uint64_t oldCell = table[i].load(std::memory_order_relaxed);
+    while (oldCell == 0 || getHash(oldCell) == hash) {
+      if (oldCell != 0 && oldCell <= newCell)
+        return;
+      // On failure, oldCell is updated to the current value of the slot.
+      if (table[i].compare_exchange_weak(oldCell, newCell))
+        return;
+    }
+  }
+}
+
+uint64_t GHashTable::lookup(const GloballyHashedType &hash) const {
+  for (size_t i = getBucket(hash);; i = (i + 1) & mask) {
+    uint64_t cell = table[i].load(std::memory_order_relaxed);
+    assert(cell != 0 && "global hash was not inserted");
+    if (getHash(cell) == hash)
+      return cell;
+  }
+}
+
+std::vector<uint64_t> GHashTable::getCells() const {
+  std::vector<uint64_t> cells;
+  for (const std::atomic<uint64_t> &cell : table)
+    if (uint64_t c = cell.load(std::memory_order_relaxed))
+      cells.push_back(c);
+  return cells;
+}
+
+// This is the set of records that TypeStreamMerger puts in the IPI stream.
+static bool isIdRecord(TypeLeafKind kind) {
+  switch (kind) {
+  case LF_FUNC_ID:
+  case LF_MFUNC_ID:
+  case LF_STRING_ID:
+  case LF_SUBSTR_LIST:
+  case LF_BUILDINFO:
+  case LF_UDT_SRC_LINE:
+  case LF_UDT_MOD_SRC_LINE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Copy a type record of an object file to dest, rewriting its type and item
+// indices with indexMap. dest may be larger than the record, in which case
+// the record is padded like TypeStreamMerger does.
+static void remapTypeRecord(ObjFile *file, const CVType &type,
+                            MutableArrayRef<uint8_t> dest,
+                            ArrayRef<TypeIndex> indexMap) {
+  ArrayRef<uint8_t> src = type.RecordData;
+  memcpy(dest.data(), src.data(), src.size());
+
+  SmallVector<TiReference, 4> refs;
+  discoverTypeIndices(type, refs);
+  MutableArrayRef<uint8_t> contents = dest.drop_front(sizeof(RecordPrefix));
+  for (const TiReference &ref : refs) {
+    if (src.size() - sizeof(RecordPrefix) <
+        ref.Offset + ref.Count * sizeof(TypeIndex))
+      fatal("type record too short in " + toString(file));
+
+    MutableArrayRef<TypeIndex> tIs(
+        reinterpret_cast<TypeIndex *>(contents.data() + ref.Offset), ref.Count);
+    for (TypeIndex &ti : tIs)
+      if (!remapTypeIndex(ti, indexMap))
+        fatal("codeview::mergeTypeAndIdRecords failed: bad type index 0x" +
+              utohexstr(ti.getIndex()) + " in " + toString(file));
+  }
+
+  if (dest.size() == src.size())
+    return;
+  auto *prefix = reinterpret_cast<RecordPrefix *>(dest.data());
+  prefix->RecordLen += dest.size() - src.size();
+  for (size_t i = src.size(), e = dest.size(); i != e; ++i)
+    dest[i] = LF_PAD0 + (e - i);
+}
+
+bool PDBLinker::mergeDebugTInParallel() {
+  ScopedTimer t(typeMergingTimer);
+
+  // Type servers and precompiled headers refer to records outside of the
+  // object file, so they need mergeDebugT.
+  for (ObjFile *file : ObjFile::instances)
+    if (file->debugTypesObj && file->debugTypesObj->kind != TpiSource::Regular)
+      return false;
+
+  ghashIndexMaps.resize(ObjFile::instances.size());
+  typesMergedInParallel = true;
+
+  std::vector<GHashSource> sources;
+  for (size_t i = 0, e = ObjFile::instances.size(); i != e; ++i) {
+    ObjFile *file = ObjFile::instances[i];
+    if (file->debugTypesObj)
+      sources.push_back({file, &ghashIndexMaps[i], {}, {}, {}, {}});
+  }
+
+  // Read the global hashes from .debug$H, or compute them if the object does
+  // not have usable ones.
+  parallelForEach(sources, [](GHashSource &src) {
+    for (const CVType &type : *src.file->debugTypes)
+      src.records.push_back(type);
+    if (Optional<ArrayRef<uint8_t>> debugH = getDebugH(src.file))
+      src.hashes = getHashesFromDebugH(*debugH);
+    if (src.hashes.size() != src.records.size()) {
+      src.ownedHashes = GloballyHashedType::hashTypes(*src.file->debugTypes);
+      src.hashes = src.ownedHashes;
+    }
+    src.uniqueIndices.resize(src.records.size());
+  });
+
+  size_t numRecords = 0;
+  for (GHashSource &src : sources)
+    numRecords += src.records.size();
+  if (numRecords == 0)
+    return true;
+
+  // Find the first occurrence of each record.
+  GHashTable table(sources, numRecords);
+  parallelForEachN(0, sources.size(), [&](size_t i) {
+    ArrayRef<CVType> records = sources[i].records;
+    for (uint32_t j = 0, e = records.size(); j != e; ++j)
+      table.insert(
+          GHashTable::makeCell(isIdRecord(records[j].kind()), i, j));
+  });
+
+  // Number the unique records in the order in which they first appear, which
+  // is the order that a serial merge would produce. Types come before items,
+  // and each group is numbered from the first non-simple index.
+  std::vector<uint64_t> cells = table.getCells();
+  parallelSort(cells, std::less<uint64_t>());
+  size_t numTypes =
+      std::partition_point(cells.begin(), cells.end(),
+                           [](uint64_t c) { return !GHashTable::isItem(c); }) -
+      cells.begin();
+  parallelForEachN(0, cells.size(), [&](size_t i) {
+    uint64_t c = cells[i];
+    sources[GHashTable::getSourceIndex(c)]
+        .uniqueIndices[GHashTable::getRecordIndex(c)] =
+        TypeIndex::fromArrayIndex(i < numTypes ? i : i - numTypes);
+  });
+
+  // Map each record of each object to the index of its first occurrence.
+  parallelForEach(sources, [&](GHashSource &src) {
+    SmallVectorImpl<TypeIndex> &tpiMap = src.indexMap->tpiMap;
+    tpiMap.resize(src.records.size());
+    for (size_t i = 0, e = src.records.size(); i != e; ++i) {
+      uint64_t c = table.lookup(src.hashes[i]);
+      tpiMap[i] = sources[GHashTable::getSourceIndex(c)]
+                      .uniqueIndices[GHashTable::getRecordIndex(c)];
+    }
+  });
+
+  // Copy the unique records to the output tables. Since they are visited in
+  // index order, the tables assign the indices computed above.
+  for (uint64_t c : cells) {
+    GHashSource &src = sources[GHashTable::getSourceIndex(c)];
+    uint32_t i = GHashTable::getRecordIndex(c);
+    const CVType &type = src.records[i];
+    GlobalTypeTableBuilder &dest = GHashTable::isItem(c)
+                                       ? tMerger.globalIDTable
+                                       : tMerger.globalTypeTable;
+    TypeIndex ti = dest.insertRecordAs(
+        src.hashes[i], alignTo(type.RecordData.size(), 4),
+        [&](MutableArrayRef<uint8_t> data) {
+          remapTypeRecord(src.file, type, data, src.indexMap->tpiMap);
+          return data;
+        });
+    (void)ti;
+    assert(ti == src.uniqueIndices[i] && "type merging order mismatch");
+  }
+  return true;
+}
+
 static void remapTypesInSymbolRecord(ObjFile *file, SymbolKind symKind,
                                      MutableArrayRef<uint8_t> recordBytes,
                                      const CVIndexMap &indexMap,
@@ -1282,8 +1527,13 @@ void PDBLinker::addObjectsToPDB() {
 
   createModuleDBI(builder);
 
-  for (ObjFile *file : ObjFile::instances)
-    addObjFile(file);
+  if (config->debugGHashes && mergeDebugTInParallel()) {
+    for (size_t i = 0, e = ObjFile::instances.size(); i != e; ++i)
+      addObjFile(ObjFile::instances[i], &ghashIndexMaps[i]);
+  } else {
+    for (ObjFile *file : ObjFile::instances)
+      addObjFile(file);
+  }
 
   builder.getStringTableBuilder().setStrings(pdbStrTab);
   t1.stop();
@@ -12,12 +12,15 @@
 
 #include "lld/Common/Filesystem.h"
 #include "lld/Common/Threads.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #if LLVM_ON_UNIX
 #include <unistd.h>
 #endif
+#include <mutex>
 #include <thread>
 
 using namespace llvm;
@@ -97,3 +100,29 @@ std::error_code lld::tryCreateFile(StringRef path) {
     return std::error_code();
   return errorToErrorCode(FileOutputBuffer::create(path, 1).takeError());
 }
+
+// Buffers registered with addInMemoryFile, keyed by the exact path string
+// the embedder passes on the command line. Readers may run on worker
+// threads, so every access goes through the mutex.
+static std::mutex inMemoryFilesMutex;
+static StringMap<std::unique_ptr<MemoryBuffer>> inMemoryFiles;
+
+void lld::addInMemoryFile(StringRef path, std::unique_ptr<MemoryBuffer> mb) {
+  std::lock_guard<std::mutex> lock(inMemoryFilesMutex);
+  inMemoryFiles[path] = std::move(mb);
+}
+
+void lld::removeInMemoryFile(StringRef path) {
+  std::lock_guard<std::mutex> lock(inMemoryFilesMutex);
+  inMemoryFiles.erase(path);
+}
+
+// The returned reference stays valid until the path is removed, which the
+// embedder only does once the link that consumes it has finished.
+Optional<MemoryBufferRef> lld::findInMemoryFile(StringRef path) {
+  std::lock_guard<std::mutex> lock(inMemoryFilesMutex);
+  auto it = inMemoryFiles.find(path);
+  if (it == inMemoryFiles.end())
+    return None;
+  return it->second->getMemBufferRef();
+}
@@ -90,6 +90,7 @@ struct Configuration {
   llvm::StringRef entry;
   llvm::StringRef emulation;
   llvm::StringRef fini;
+  llvm::StringRef incrementalState;
   llvm::StringRef init;
   llvm::StringRef ltoAAPipeline;
   llvm::StringRef ltoCSProfileFile;
@@ -151,6 +152,7 @@ struct Configuration {
   bool formatBinary = false;
   bool requireCET;
   bool gcSections;
+  bool gcSectionsThreads;
   bool gdbIndex;
   bool gnuHash = false;
   bool gnuUnique;
@@ -158,6 +160,7 @@ struct Configuration {
   bool hasDynSymTab;
   bool ignoreDataAddressEquality;
   bool ignoreFunctionAddressEquality;
+  bool incremental;
   bool ltoCSProfileGenerate;
   bool ltoDebugPassManager;
   bool ltoNewPassManager;
@@ -227,6 +230,7 @@ struct Configuration {
   uint16_t emachine = llvm::ELF::EM_NONE;
   llvm::Optional<uint64_t> imageBase;
   uint64_t commonPageSize;
+  uint64_t incrementalArgsHash;
   uint64_t maxPageSize;
   uint64_t mipsGotSize;
   uint64_t zStackSize;
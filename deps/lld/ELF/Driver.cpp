@@ -56,6 +56,7 @@
 #include "llvm/Support/TarWriter.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <cstdlib>
 #include <utility>
 
@@ -330,6 +331,17 @@ static void checkOptions() {
       error("-r and -pie may not be used together");
   }
 
+  if (config->incremental) {
+    if (config->relocatable)
+      error("-r and --incremental may not be used together");
+    if (config->emitRelocs)
+      error("--emit-relocs and --incremental may not be used together");
+    if (config->icf != ICFLevel::None)
+      error("--icf and --incremental may not be used together");
+    if (config->oFormatBinary)
+      error("--oformat binary and --incremental may not be used together");
+  }
+
   if (config->executeOnly) {
     if (config->emachine != EM_AARCH64)
       error("-execute-only is only supported on AArch64 targets");
@@ -576,6 +588,36 @@ static ICFLevel getICF(opt::InputArgList &args) {
   return ICFLevel::All;
 }
 
+// Returns a hash of the options that affect the output of an incremental
+// link, so that a state file written with different options is not reused.
+// The contents of linker scripts are included because they control layout.
+static uint64_t getIncrementalArgsHash(opt::InputArgList &args) {
+  std::string s;
+  for (opt::Arg *arg : args) {
+    switch (arg->getOption().getID()) {
+    case OPT_INPUT:
+    case OPT_o:
+    case OPT_incremental_state:
+    case OPT_Map:
+    case OPT_verbose:
+    case OPT_threads:
+    case OPT_no_threads:
+    case OPT_gc_sections_threads:
+    case OPT_no_gc_sections_threads:
+    case OPT_error_limit:
+    case OPT_reproduce:
+      continue;
+    case OPT_script:
+      if (Optional<MemoryBufferRef> mb = readFile(arg->getValue()))
+        s += mb->getBuffer();
+      break;
+    }
+    s += arg->getAsString(args);
+    s += '\0';
+  }
+  return xxHash64(s);
+}
+
 static StripPolicy getStrip(opt::InputArgList &args) {
   if (args.hasArg(OPT_relocatable))
     return StripPolicy::None;
@@ -832,6 +874,8 @@ static void readConfigs(opt::InputArgList &args) {
   config->forceBTI = args.hasArg(OPT_force_bti);
   config->requireCET = args.hasArg(OPT_require_cet);
   config->gcSections = args.hasFlag(OPT_gc_sections, OPT_no_gc_sections, false);
+  config->gcSectionsThreads =
+      args.hasFlag(OPT_gc_sections_threads, OPT_no_gc_sections_threads, false);
   config->gnuUnique = args.hasFlag(OPT_gnu_unique, OPT_no_gnu_unique, true);
   config->gdbIndex = args.hasFlag(OPT_gdb_index, OPT_no_gdb_index, false);
   config->icf = getICF(args);
@@ -839,6 +883,9 @@ static void readConfigs(opt::InputArgList &args) {
       args.hasArg(OPT_ignore_data_address_equality);
   config->ignoreFunctionAddressEquality =
       args.hasArg(OPT_ignore_function_address_equality);
+  config->incremental =
+      args.hasFlag(OPT_incremental, OPT_no_incremental, false);
+  config->incrementalState = args.getLastArgValue(OPT_incremental_state);
   config->init = args.getLastArgValue(OPT_init, "_init");
   config->ltoAAPipeline = args.getLastArgValue(OPT_lto_aa_pipeline);
   config->ltoCSProfileGenerate = args.hasArg(OPT_lto_cs_profile_generate);
@@ -1706,6 +1753,12 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   // symbols that we need to the symbol table. This process might
   // add files to the link, via autolinking, these files are always
   // appended to the Files vector.
+  //
+  // Decoding section headers and symbol names does not depend on other files,
+  // so it is done up front for all of them in parallel. Symbols are still
+  // inserted below in command line order, which keeps symbol precedence and
+  // archive member selection the same.
+  parallelForEach(files, preparseFile);
   for (size_t i = 0; i < files.size(); ++i)
     parseFile(files[i]);
 
@@ -1856,6 +1909,16 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   target = getTarget();
 
   config->eflags = target->calcEFlags();
+
+  // Range extension thunks are placed according to the distances between
+  // sections, so they defeat the fixed layout of an incremental link.
+  if (config->incremental && (target->needsThunks || partitions.size() > 1)) {
+    warn("--incremental is not supported for this output; linking from "
+         "scratch");
+    config->incremental = false;
+  }
+  if (config->incremental)
+    config->incrementalArgsHash = getIncrementalArgsHash(args);
   // maxPageSize (sometimes called abi page size) is the maximum page size that
   // the output can be run on. For example if the OS can use 4k or 64k page
   // sizes then maxPageSize must be 64k for the output to be useable on both.
@@ -484,12 +484,16 @@ template <class ELFT> void ICF<ELFT>::run() {
   log("ICF needed " + Twine(cnt) + " iterations");
 
   // Merge sections by the equivalence class.
+  size_t numFolded = 0;
+  uint64_t foldedSize = 0;
   forEachClassRange(0, sections.size(), [&](size_t begin, size_t end) {
     if (end - begin == 1)
       return;
     print("selected section " + toString(sections[begin]));
     for (size_t i = begin + 1; i < end; ++i) {
       print("  removing identical section " + toString(sections[i]));
+      ++numFolded;
+      foldedSize += sections[i]->getSize();
       sections[begin]->replace(sections[i]);
 
       // At this point we know sections merged are fully identical and hence
@@ -499,6 +503,14 @@ template <class ELFT> void ICF<ELFT>::run() {
         isec->markDead();
     }
   });
+
+  std::string summary = ("ICF folded " + Twine(numFolded) + " sections (" +
+                         Twine(foldedSize) + " bytes)")
+                            .str();
+  if (config->printIcfSections && numFolded)
+    message(summary);
+  else
+    log(summary);
 }
 
 // ICF entry point function.
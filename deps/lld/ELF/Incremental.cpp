@@ -0,0 +1,596 @@
+//===- Incremental.cpp ----------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements --incremental, which lets a link reuse the output of
+// the previous link if only a few input files have changed.
+//
+// With --incremental, each input section that can grow gets a slot that is
+// larger than the section itself, and the linker writes a state file next to
+// the output. The state file records a hash of each object file, the address
+// and the slot size of each input section, a hash of the properties of each
+// global symbol that relocations may read, and the layout of the allocated
+// output sections.
+//
+// The next link gives each section the slot it had before, as long as the
+// section still fits. If all sections fit and nothing else moved, the
+// allocated part of the output has the same layout as the previous output.
+// In that case we copy the previous output and write only
+//
+//  - the sections of object files that have changed,
+//  - the sections of object files that refer to a global symbol whose
+//    address, size or GOT/PLT entry has changed, or whose mergeable section
+//    pieces or local GOT entries have moved, and
+//  - synthetic sections and non-allocated sections, which are always written.
+//
+// Sections of the remaining object files are not visited at all, which saves
+// the time of relocating them. Otherwise, the output is written from scratch
+// as usual. Either way, a new state file is written for the next link.
+//
+// The state file is a cache. It is only read by the same linker on the same
+// host, so it uses the host byte order, and any mismatch makes the linker
+// fall back to a full link.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Incremental.h"
+#include "Config.h"
+#include "InputFiles.h"
+#include "InputSection.h"
+#include "OutputSections.h"
+#include "SymbolTable.h"
+#include "Symbols.h"
+#include "SyntheticSections.h"
+#include "lld/Common/ErrorHandler.h"
+#include "lld/Common/Memory.h"
+#include "lld/Common/Strings.h"
+#include "lld/Common/Threads.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <map>
+
+using namespace llvm;
+using namespace llvm::ELF;
+
+using namespace lld;
+using namespace lld::elf;
+
+namespace {
+struct StateHeader {
+  char magic[8];
+  uint64_t argsHash;
+  uint64_t outputHash;
+  uint32_t numFiles;
+  uint32_t numSections;
+  uint32_t numSymbols;
+  uint32_t numOutputSections;
+  uint32_t outputPathOffset;
+  uint32_t stringsSize;
+};
+
+struct FileRecord {
+  uint64_t contentHash;
+  uint64_t dependencyHash;
+};
+
+// A section from an object file is identified by the index of the file in
+// objectFiles and the index of the section in the file. A synthetic section
+// has file -1, and is identified by its name and its index among synthetic
+// sections of the same name.
+struct SectionRecord {
+  uint64_t va;
+  uint64_t slotSize;
+  uint32_t file;
+  uint32_t index;
+  uint32_t nameOffset;
+  uint32_t padding;
+};
+
+struct SymbolRecord {
+  uint64_t hash;
+  uint32_t nameOffset;
+  uint32_t padding;
+};
+
+struct OutputSectionRecord {
+  uint64_t addr;
+  uint64_t offset;
+  uint64_t size;
+  uint64_t flags;
+  uint32_t type;
+  uint32_t nameOffset;
+};
+
+struct IncrementalState {
+  // The state file of the previous link, if it is usable.
+  std::unique_ptr<MemoryBuffer> mb;
+  const StateHeader *header = nullptr;
+  ArrayRef<FileRecord> files;
+  ArrayRef<SectionRecord> sections;
+  ArrayRef<SymbolRecord> symbols;
+  ArrayRef<OutputSectionRecord> outputSections;
+  StringRef strings;
+
+  // Content hashes of objectFiles.
+  std::vector<uint64_t> contentHashes;
+
+  // Maps sections of this link to their records in the previous link.
+  DenseMap<const InputSectionBase *, const SectionRecord *> slots;
+
+  // Set if the previous output is patched instead of written from scratch.
+  std::unique_ptr<MemoryBuffer> oldOutput;
+  DenseSet<const InputFile *> cleanFiles;
+  bool patching = false;
+};
+} // namespace
+
+static const char stateMagic[8] = {'L', 'L', 'D', 'I', 'N', 'C', 'R', 1};
+
+static IncrementalState *state;
+
+static std::string getStatePath() {
+  if (!config->incrementalState.empty())
+    return config->incrementalState.str();
+  return (config->outputFile + ".incremental").str();
+}
+
+static StringRef getString(uint32_t offset) {
+  if (offset >= state->strings.size())
+    return "";
+  return state->strings.data() + offset;
+}
+
+template <class T> static ArrayRef<uint8_t> toBytes(ArrayRef<T> arr) {
+  return makeArrayRef(reinterpret_cast<const uint8_t *>(arr.data()),
+                      arr.size() * sizeof(T));
+}
+
+// Returns true if S is a synthetic section that gets a slot. These are the
+// synthetic sections whose contents come from object files, so their sizes
+// change along with them.
+static bool isPaddedSynthetic(const InputSectionBase *s) {
+  if (!isa<SyntheticSection>(s))
+    return false;
+  if (s == in.got || s == mainPart->ehFrame || s == mainPart->ehFrameHdr)
+    return true;
+  return (s->flags & SHF_MERGE) && (s->flags & SHF_ALLOC);
+}
+
+// Returns true if S gets a slot that is larger than S.
+static bool isPadded(const InputSectionBase *s) {
+  if (!isa<InputSection>(s) || !(s->flags & SHF_ALLOC))
+    return false;
+  if (isa<SyntheticSection>(s))
+    return isPaddedSynthetic(s);
+  if (!s->file || s->file->kind() != InputFile::ObjKind)
+    return false;
+
+  // Sections that are read as arrays or executed as straight-line code
+  // must not have gaps between them. Neither must sections that can be
+  // enumerated using __start_/__stop_ symbols.
+  switch (s->type) {
+  case SHT_NOTE:
+  case SHT_INIT_ARRAY:
+  case SHT_FINI_ARRAY:
+  case SHT_PREINIT_ARRAY:
+    return false;
+  }
+  StringRef name = s->name;
+  return !name.startswith(".ctors") && !name.startswith(".dtors") &&
+         !name.startswith(".init") && !name.startswith(".fini") &&
+         !name.startswith(".jcr") && !isValidCIdentifier(name);
+}
+
+// Returns true if the position of S is recorded in the state file. This is
+// the case for all allocated sections from object files, so that we notice
+// when any of them moves, and for padded synthetic sections.
+static bool isRecorded(const InputSectionBase *s) {
+  auto *sec = dyn_cast<InputSection>(s);
+  if (!sec || !sec->isLive() || !sec->getParent() || !(sec->flags & SHF_ALLOC))
+    return false;
+  if (isa<SyntheticSection>(sec))
+    return isPaddedSynthetic(sec);
+  return sec->file && sec->file->kind() == InputFile::ObjKind;
+}
+
+// Calls Fn for each section that can be recorded, with the key that
+// identifies the section across links.
+static void
+forEachKeyedSection(function_ref<void(InputSectionBase *, uint32_t, uint32_t)> fn) {
+  for (size_t i = 0; i < objectFiles.size(); ++i) {
+    ArrayRef<InputSectionBase *> sections = objectFiles[i]->getSections();
+    for (size_t j = 0; j < sections.size(); ++j)
+      if (sections[j] && sections[j] != &InputSection::discarded)
+        fn(sections[j], i, j);
+  }
+
+  DenseMap<CachedHashStringRef, uint32_t> ordinals;
+  for (InputSectionBase *s : inputSections)
+    if (isPaddedSynthetic(s))
+      fn(s, -1, ordinals[CachedHashStringRef(s->name)]++);
+}
+
+// Returns a hash of the properties of Sym that relocations may read.
+static uint64_t getSymbolHash(const Symbol &sym) {
+  uint64_t v[6] = {};
+  v[0] = sym.kind() | sym.binding << 8 | sym.type << 16 | sym.stOther << 24 |
+         (uint64_t)sym.versionId << 32;
+  v[1] = sym.isPreemptible | sym.needsPltAddr << 1 | sym.isInIplt << 2 |
+         sym.gotInIgot << 3;
+  v[2] = (uint64_t)sym.gotIndex << 32 | sym.pltIndex;
+  v[3] = sym.globalDynIndex;
+
+  // Computing the address of a symbol in a discarded section is an error,
+  // and the address is meaningless anyway.
+  if (auto *d = dyn_cast<Defined>(&sym)) {
+    if (!d->section || d->section->isLive()) {
+      v[4] = d->getVA();
+      v[5] = d->size;
+    }
+  } else if (auto *ss = dyn_cast<SharedSymbol>(&sym)) {
+    v[4] = ss->getVA();
+    v[5] = ss->size;
+  }
+  return xxHash64(toBytes(makeArrayRef(v)));
+}
+
+// Returns a hash of what the contents of F depend on other than F itself and
+// global symbols: the output offsets of F's mergeable section pieces, which
+// are laid out together with the pieces of other files, and the GOT entries
+// of F's local symbols.
+static uint64_t getDependencyHash(InputFile *f) {
+  std::vector<uint64_t> v;
+  for (Symbol *sym : f->getSymbols()) {
+    if (sym && sym->isLocal() &&
+        (sym->isInGot() || sym->isInPlt() || sym->globalDynIndex != -1U)) {
+      v.push_back((uint64_t)sym->gotIndex << 32 | sym->pltIndex);
+      v.push_back(sym->globalDynIndex);
+    }
+  }
+
+  for (InputSectionBase *s : f->getSections()) {
+    auto *ms = dyn_cast_or_null<MergeInputSection>(s);
+    if (!ms || !ms->isLive() || !(ms->flags & SHF_ALLOC))
+      continue;
+    for (const SectionPiece &piece : ms->pieces)
+      if (piece.live)
+        v.push_back(piece.outputOff);
+  }
+  return xxHash64(toBytes(makeArrayRef(v)));
+}
+
+// Returns a hash of the allocated output sections in Buf, or 0 if Buf is too
+// small for the current layout.
+static uint64_t getOutputHash(ArrayRef<uint8_t> buf) {
+  std::vector<OutputSection *> v;
+  for (OutputSection *sec : outputSections) {
+    if (!(sec->flags & SHF_ALLOC) || sec->type == SHT_NOBITS)
+      continue;
+    if (sec->offset + sec->size > buf.size())
+      return 0;
+    v.push_back(sec);
+  }
+
+  std::vector<uint64_t> hashes(v.size());
+  parallelForEachN(0, v.size(), [&](size_t i) {
+    hashes[i] = xxHash64(buf.slice(v[i]->offset, v[i]->size));
+  });
+  return xxHash64(toBytes(makeArrayRef(hashes)));
+}
+
+template <class T>
+static bool readArray(StringRef &data, ArrayRef<T> &arr, size_t n) {
+  if (data.size() / sizeof(T) < n)
+    return false;
+  arr = makeArrayRef(reinterpret_cast<const T *>(data.data()), n);
+  data = data.drop_front(n * sizeof(T));
+  return true;
+}
+
+static bool parseState() {
+  StringRef data = state->mb->getBuffer();
+  if (data.size() < sizeof(StateHeader) ||
+      memcmp(data.data(), stateMagic, sizeof(stateMagic)) != 0)
+    return false;
+  const auto *h = reinterpret_cast<const StateHeader *>(data.data());
+  data = data.drop_front(sizeof(StateHeader));
+
+  if (!readArray(data, state->files, h->numFiles) ||
+      !readArray(data, state->sections, h->numSections) ||
+      !readArray(data, state->symbols, h->numSymbols) ||
+      !readArray(data, state->outputSections, h->numOutputSections))
+    return false;
+  if (data.size() != h->stringsSize || data.empty() || data.back() != '\0')
+    return false;
+  state->strings = data;
+  state->header = h;
+  return true;
+}
+
+// Reads the state file of the previous link. This is called before any
+// section is assigned an address.
+void elf::readIncrementalState() {
+  state = make<IncrementalState>();
+
+  // The new state file needs these even if the old one is unusable.
+  state->contentHashes.resize(objectFiles.size());
+  parallelForEachN(0, objectFiles.size(), [&](size_t i) {
+    state->contentHashes[i] = xxHash64(objectFiles[i]->mb.getBuffer());
+  });
+
+  std::string path = getStatePath();
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+      MemoryBuffer::getFile(path, -1, false);
+  if (!mbOrErr) {
+    log("--incremental: cannot read " + path + ": " +
+        mbOrErr.getError().message());
+    return;
+  }
+  state->mb = std::move(*mbOrErr);
+  if (!parseState()) {
+    log("--incremental: " + path + " is not a valid state file");
+    state->mb.reset();
+    return;
+  }
+  if (state->header->argsHash != config->incrementalArgsHash) {
+    log("--incremental: options have changed since the previous link");
+    state->header = nullptr;
+    return;
+  }
+
+  DenseMap<uint64_t, const SectionRecord *> fromFiles;
+  std::map<std::pair<StringRef, uint32_t>, const SectionRecord *> synthetic;
+  for (const SectionRecord &rec : state->sections) {
+    if (rec.file == (uint32_t)-1)
+      synthetic[{getString(rec.nameOffset), rec.index}] = &rec;
+    else if (rec.file < objectFiles.size())
+      fromFiles[(uint64_t)rec.file << 32 | rec.index] = &rec;
+  }
+
+  forEachKeyedSection([&](InputSectionBase *s, uint32_t file, uint32_t index) {
+    if (file != (uint32_t)-1) {
+      if (const SectionRecord *rec = fromFiles.lookup((uint64_t)file << 32 | index))
+        state->slots[s] = rec;
+      return;
+    }
+    auto it = synthetic.find({s->name, index});
+    if (it != synthetic.end())
+      state->slots[s] = it->second;
+  });
+}
+
+// Returns the size of the room reserved for Sec in its output section.
+uint64_t elf::getIncrementalSlotSize(InputSection *sec) {
+  uint64_t size = sec->getSize();
+  if (!isPadded(sec))
+    return size;
+  if (const SectionRecord *rec = state->slots.lookup(sec))
+    if (size <= rec->slotSize)
+      return rec->slotSize;
+  return size + size / 4 + 64;
+}
+
+// Returns true if the allocated part of the output has the same layout as in
+// the previous link.
+static bool isLayoutUnchanged() {
+  std::vector<OutputSection *> v;
+  for (OutputSection *sec : outputSections)
+    if (sec->flags & SHF_ALLOC)
+      v.push_back(sec);
+  if (v.size() != state->outputSections.size())
+    return false;
+
+  for (size_t i = 0; i < v.size(); ++i) {
+    const OutputSectionRecord &rec = state->outputSections[i];
+    if (v[i]->name != getString(rec.nameOffset) || v[i]->type != rec.type ||
+        v[i]->flags != rec.flags || v[i]->addr != rec.addr ||
+        v[i]->offset != rec.offset || v[i]->size != rec.size)
+      return false;
+  }
+
+  size_t numSections = 0;
+  bool unchanged = true;
+  forEachKeyedSection([&](InputSectionBase *s, uint32_t, uint32_t) {
+    if (!unchanged || !isRecorded(s))
+      return;
+    auto *sec = cast<InputSection>(s);
+    const SectionRecord *rec = state->slots.lookup(sec);
+    if (!rec || sec->getVA(0) != rec->va ||
+        getIncrementalSlotSize(sec) != rec->slotSize)
+      unchanged = false;
+    ++numSections;
+  });
+  return unchanged && numSections == state->sections.size();
+}
+
+// Decides whether the previous output can be patched. This is called after
+// all addresses are fixed, but before the output file is opened, because
+// opening the output file removes the previous output.
+void elf::prepareIncrementalPatch() {
+  if (!state->header)
+    return;
+  if (!isLayoutUnchanged()) {
+    log("--incremental: layout has changed; writing the output from scratch");
+    return;
+  }
+
+  StringRef path = getString(state->header->outputPathOffset);
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+      MemoryBuffer::getFile(path, -1, false);
+  if (!mbOrErr) {
+    log("--incremental: cannot read " + path + ": " +
+        mbOrErr.getError().message());
+    return;
+  }
+  ArrayRef<uint8_t> old = arrayRefFromStringRef((*mbOrErr)->getBuffer());
+  if (getOutputHash(old) != state->header->outputHash) {
+    log("--incremental: " + path + " has been modified since the previous "
+        "link; writing the output from scratch");
+    return;
+  }
+
+  // A symbol name that appears twice, once for each version, cannot be used
+  // to tell whether the symbol has changed.
+  DenseMap<CachedHashStringRef, uint64_t> oldSymbols;
+  DenseSet<CachedHashStringRef> ambiguous;
+  for (const SymbolRecord &rec : state->symbols) {
+    CachedHashStringRef name(getString(rec.nameOffset));
+    if (!oldSymbols.insert({name, rec.hash}).second)
+      ambiguous.insert(name);
+  }
+
+  std::vector<uint8_t> clean(objectFiles.size());
+  parallelForEachN(0, objectFiles.size(), [&](size_t i) {
+    InputFile *f = objectFiles[i];
+    if (i >= state->files.size() ||
+        state->files[i].contentHash != state->contentHashes[i] ||
+        state->files[i].dependencyHash != getDependencyHash(f))
+      return;
+
+    for (Symbol *sym : f->getSymbols()) {
+      if (!sym || sym->isLocal())
+        continue;
+      CachedHashStringRef name(sym->getName());
+      auto it = oldSymbols.find(name);
+      if (it == oldSymbols.end() || ambiguous.count(name) ||
+          it->second != getSymbolHash(*sym))
+        return;
+    }
+    clean[i] = true;
+  });
+
+  size_t numDirty = 0;
+  for (size_t i = 0; i < objectFiles.size(); ++i) {
+    if (clean[i])
+      state->cleanFiles.insert(objectFiles[i]);
+    else
+      ++numDirty;
+  }
+
+  state->oldOutput = std::move(*mbOrErr);
+  state->patching = true;
+  log("--incremental: patching " + path + "; " + Twine(numDirty) + " of " +
+      Twine(objectFiles.size()) + " object files need to be written");
+}
+
+// Copies the allocated output sections of the previous output to Buf.
+void elf::copyIncrementalBase(uint8_t *buf) {
+  if (!state->patching)
+    return;
+  const uint8_t *old =
+      reinterpret_cast<const uint8_t *>(state->oldOutput->getBufferStart());
+  parallelForEach(outputSections, [&](OutputSection *sec) {
+    if ((sec->flags & SHF_ALLOC) && sec->type != SHT_NOBITS)
+      memcpy(buf + sec->offset, old + sec->offset, sec->size);
+  });
+  state->oldOutput.reset();
+}
+
+bool elf::isIncrementalPatch() {
+  return config->incremental && state->patching;
+}
+
+// Returns true if Sec has the same contents as in the previous output.
+bool elf::isIncrementallyClean(const InputSection *sec) {
+  return (sec->flags & SHF_ALLOC) && !isa<SyntheticSection>(sec) &&
+         state->cleanFiles.count(sec->file);
+}
+
+// Writes the state file for the next link. Output is the contents of the
+// output file.
+void elf::writeIncrementalState(ArrayRef<uint8_t> output) {
+  std::string strings(1, '\0');
+  auto addString = [&](StringRef s) {
+    uint32_t offset = strings.size();
+    strings += s;
+    strings += '\0';
+    return offset;
+  };
+
+  std::vector<FileRecord> files(objectFiles.size());
+  parallelForEachN(0, objectFiles.size(), [&](size_t i) {
+    files[i].contentHash = state->contentHashes[i];
+    files[i].dependencyHash = getDependencyHash(objectFiles[i]);
+  });
+
+  std::vector<SectionRecord> sections;
+  forEachKeyedSection([&](InputSectionBase *s, uint32_t file, uint32_t index) {
+    if (!isRecorded(s))
+      return;
+    auto *sec = cast<InputSection>(s);
+    SectionRecord rec = {};
+    rec.va = sec->getVA(0);
+    rec.slotSize = getIncrementalSlotSize(sec);
+    rec.file = file;
+    rec.index = index;
+    if (file == (uint32_t)-1)
+      rec.nameOffset = addString(sec->name);
+    sections.push_back(rec);
+  });
+
+  std::vector<Symbol *> syms;
+  symtab->forEachSymbol([&](Symbol *sym) {
+    if (!sym->isLazy() && !sym->isPlaceholder())
+      syms.push_back(sym);
+  });
+  std::vector<SymbolRecord> symbols(syms.size());
+  parallelForEachN(0, syms.size(), [&](size_t i) {
+    symbols[i].hash = getSymbolHash(*syms[i]);
+  });
+  for (size_t i = 0; i < syms.size(); ++i)
+    symbols[i].nameOffset = addString(syms[i]->getName());
+
+  std::vector<OutputSectionRecord> outSections;
+  for (OutputSection *sec : outputSections) {
+    if (!(sec->flags & SHF_ALLOC))
+      continue;
+    OutputSectionRecord rec = {};
+    rec.addr = sec->addr;
+    rec.offset = sec->offset;
+    rec.size = sec->size;
+    rec.flags = sec->flags;
+    rec.type = sec->type;
+    rec.nameOffset = addString(sec->name);
+    outSections.push_back(rec);
+  }
+
+  // The output path is made absolute so that the state file can be found
+  // and used from any working directory.
+  SmallString<128> outputPath(config->outputFile);
+  sys::fs::make_absolute(outputPath);
+
+  StateHeader header = {};
+  memcpy(header.magic, stateMagic, sizeof(stateMagic));
+  header.argsHash = config->incrementalArgsHash;
+  header.outputHash = getOutputHash(output);
+  header.numFiles = files.size();
+  header.numSections = sections.size();
+  header.numSymbols = symbols.size();
+  header.numOutputSections = outSections.size();
+  header.outputPathOffset = addString(outputPath);
+  header.stringsSize = strings.size();
+
+  // A state file that cannot be written only makes the next link slower.
+  std::string path = getStatePath();
+  std::error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::F_None);
+  if (ec) {
+    warn("cannot open " + path + ": " + ec.message());
+    return;
+  }
+  os << toStringRef(toBytes(makeArrayRef(&header, 1)))
+     << toStringRef(toBytes(makeArrayRef(files)))
+     << toStringRef(toBytes(makeArrayRef(sections)))
+     << toStringRef(toBytes(makeArrayRef(symbols)))
+     << toStringRef(toBytes(makeArrayRef(outSections))) << strings;
+}
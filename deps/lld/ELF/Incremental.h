@@ -0,0 +1,28 @@
+//===- Incremental.h --------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_INCREMENTAL_H
+#define LLD_ELF_INCREMENTAL_H
+
+#include "lld/Common/LLVM.h"
+
+namespace lld {
+namespace elf {
+class InputSection;
+
+void readIncrementalState();
+uint64_t getIncrementalSlotSize(InputSection *sec);
+void prepareIncrementalPatch();
+void copyIncrementalBase(uint8_t *buf);
+bool isIncrementalPatch();
+bool isIncrementallyClean(const InputSection *sec);
+void writeIncrementalState(ArrayRef<uint8_t> output);
+} // namespace elf
+} // namespace lld
+
+#endif
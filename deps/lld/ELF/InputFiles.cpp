@@ -14,6 +14,7 @@
 #include "Symbols.h"
 #include "SyntheticSections.h"
 #include "lld/Common/ErrorHandler.h"
+#include "lld/Common/Filesystem.h"
 #include "lld/Common/Memory.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/CodeGen/Analysis.h"
@@ -96,6 +97,12 @@ Optional<MemoryBufferRef> elf::readFile(StringRef path) {
 
   log(path);
 
+  if (Optional<MemoryBufferRef> mbref = findInMemoryFile(path)) {
+    if (tar)
+      tar->append(relativeToRoot(path), mbref->getBuffer());
+    return mbref;
+  }
+
   auto mbOrErr = MemoryBuffer::getFile(path, -1, false);
   if (auto ec = mbOrErr.getError()) {
     error("cannot open " + path + ": " + ec.message());
@@ -207,6 +214,28 @@ void elf::parseFile(InputFile *file) {
   }
 }
 
+void elf::preparseFile(InputFile *file) {
+  if (file->kind() != InputFile::ObjKind)
+    return;
+
+  switch (cast<ELFFileBase>(file)->ekind) {
+  case ELF32LEKind:
+    cast<ObjFile<ELF32LE>>(file)->preparse();
+    return;
+  case ELF32BEKind:
+    cast<ObjFile<ELF32BE>>(file)->preparse();
+    return;
+  case ELF64LEKind:
+    cast<ObjFile<ELF64LE>>(file)->preparse();
+    return;
+  case ELF64BEKind:
+    cast<ObjFile<ELF64BE>>(file)->preparse();
+    return;
+  default:
+    llvm_unreachable("unknown ELFT");
+  }
+}
+
 // Concatenates arguments to construct a string representing an error location.
 static std::string createFileLineMsg(StringRef path, unsigned line) {
   std::string filename = path::filename(path);
@@ -449,6 +478,48 @@ template <class ELFT> ArrayRef<Symbol *> ObjFile<ELFT>::getGlobalSymbols() {
   return makeArrayRef(this->symbols).slice(this->firstGlobal);
 }
 
+template <class ELFT> void ObjFile<ELFT>::preparse() {
+  const ELFFile<ELFT> &obj = this->getObj();
+
+  Expected<ArrayRef<Elf_Shdr>> objSections = obj.sections();
+  if (!objSections) {
+    consumeError(objSections.takeError());
+    return;
+  }
+  Expected<StringRef> shstrtab = obj.getSectionStringTable(*objSections);
+  if (!shstrtab) {
+    consumeError(shstrtab.takeError());
+    return;
+  }
+
+  std::vector<StringRef> sectionNames;
+  sectionNames.reserve(objSections->size());
+  for (const Elf_Shdr &sec : *objSections) {
+    Expected<StringRef> name = obj.getSectionName(&sec, *shstrtab);
+    if (!name) {
+      consumeError(name.takeError());
+      return;
+    }
+    sectionNames.push_back(*name);
+  }
+
+  ArrayRef<Elf_Sym> eSyms = this->template getELFSyms<ELFT>();
+  std::vector<CachedHashStringRef> symbolKeys;
+  symbolKeys.reserve(eSyms.size() - this->firstGlobal);
+  for (const Elf_Sym &eSym : eSyms.slice(this->firstGlobal)) {
+    Expected<StringRef> name = eSym.getName(this->stringTable);
+    if (!name) {
+      consumeError(name.takeError());
+      return;
+    }
+    symbolKeys.push_back(SymbolTable::getKey(*name));
+  }
+
+  preparsedSections = objSections->data();
+  preparsedSectionNames = std::move(sectionNames);
+  preparsedSymbolKeys = std::move(symbolKeys);
+}
+
 template <class ELFT> void ObjFile<ELFT>::parse(bool ignoreComdats) {
   // Read a section table. justSymbols is usually false.
   if (this->justSymbols)
@@ -458,6 +529,11 @@ template <class ELFT> void ObjFile<ELFT>::parse(bool ignoreComdats) {
 
   // Read a symbol table.
   initializeSymbols();
+
+  // The names are only looked up while creating sections and symbols.
+  preparsedSections = nullptr;
+  std::vector<StringRef>().swap(preparsedSectionNames);
+  std::vector<CachedHashStringRef>().swap(preparsedSymbolKeys);
 }
 
 // Sections with SHT_GROUP and comdat bits define comdat section groups.
@@ -1037,6 +1113,11 @@ InputSectionBase *ObjFile<ELFT>::createInputSection(const Elf_Shdr &sec) {
 
 template <class ELFT>
 StringRef ObjFile<ELFT>::getSectionName(const Elf_Shdr &sec) {
+  if (preparsedSections) {
+    size_t i = &sec - preparsedSections;
+    if (i < preparsedSectionNames.size())
+      return preparsedSectionNames[i];
+  }
   return CHECK(getObj().getSectionName(&sec, sectionStringTable), this);
 }
 
@@ -1048,10 +1129,16 @@ template <class ELFT> void ObjFile<ELFT>::initializeSymbols() {
 
   // Our symbol table may have already been partially initialized
   // because of LazyObjFile.
-  for (size_t i = 0, end = eSyms.size(); i != end; ++i)
-    if (!this->symbols[i] && eSyms[i].getBinding() != STB_LOCAL)
+  for (size_t i = 0, end = eSyms.size(); i != end; ++i) {
+    if (this->symbols[i] || eSyms[i].getBinding() == STB_LOCAL)
+      continue;
+    if (i >= this->firstGlobal && !preparsedSymbolKeys.empty())
+      this->symbols[i] =
+          symtab->insert(preparsedSymbolKeys[i - this->firstGlobal]);
+    else
       this->symbols[i] =
           symtab->insert(CHECK(eSyms[i].getName(this->stringTable), this));
+  }
 
   // Fill this->Symbols. A symbol is either local or global.
   for (size_t i = 0, end = eSyms.size(); i != end; ++i) {
@@ -57,6 +57,10 @@ llvm::Optional<MemoryBufferRef> readFile(StringRef path);
 // Add symbols in File to the symbol table.
 void parseFile(InputFile *file);
 
+// Decodes what parseFile() needs from a file without touching any global
+// state, so that it can be done for many files in parallel.
+void preparseFile(InputFile *file);
+
 // The root class of input files.
 class InputFile {
 public:
@@ -207,6 +211,12 @@ public:
 
   void parse(bool ignoreComdats = false);
 
+  // Reads the section header table and decodes section and global symbol
+  // names ahead of parse(). This only reads the file and may run on any
+  // thread. If the file is malformed, nothing is recorded and parse()
+  // reports the error.
+  void preparse();
+
   StringRef getShtGroupSignature(ArrayRef<Elf_Shdr> sections,
                                  const Elf_Shdr &sec);
 
@@ -280,6 +290,12 @@ private:
   // .shstrtab contents.
   StringRef sectionStringTable;
 
+  // Results of preparse(): the name of each section in the section header
+  // table, and the symbol table key of each symbol from firstGlobal on.
+  const Elf_Shdr *preparsedSections = nullptr;
+  std::vector<StringRef> preparsedSectionNames;
+  std::vector<llvm::CachedHashStringRef> preparsedSymbolKeys;
+
   // Debugging information to retrieve source file and line for error
   // reporting. Linker may find reasonable number of errors in a
   // single object file, so we cache debugging information in order to
@@ -29,6 +29,7 @@
 #include "Target.h"
 #include "lld/Common/Memory.h"
 #include "lld/Common/Strings.h"
+#include "lld/Common/Threads.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Object/ELF.h"
 #include <functional>
@@ -43,6 +44,14 @@ using namespace lld;
 using namespace lld::elf;
 
 namespace {
+// The references from a live section that may change the liveness state.
+// They are collected without writing to any shared object, so that sections
+// can be scanned in parallel, and are then applied by a single thread.
+struct LiveEdges {
+  SmallVector<std::pair<InputSectionBase *, uint64_t>, 4> sections;
+  SmallVector<Symbol *, 4> symbols;
+};
+
 template <class ELFT> class MarkLive {
 public:
   MarkLive(unsigned partition) : partition(partition) {}
@@ -52,11 +61,16 @@ public:
 
 private:
   void enqueue(InputSectionBase *sec, uint64_t offset);
+  bool isEnqueueNeeded(InputSectionBase *sec) const;
   void markSymbol(Symbol *sym);
   void mark();
+  void markParallel();
+  void scanSection(InputSectionBase &sec, LiveEdges &edges);
+  void applyEdges(LiveEdges &edges);
 
   template <class RelTy>
-  void resolveReloc(InputSectionBase &sec, RelTy &rel, bool isLSDA);
+  void resolveReloc(InputSectionBase &sec, RelTy &rel, bool isLSDA,
+                    LiveEdges &edges);
 
   template <class RelTy>
   void scanEhFrameSection(EhInputSection &eh, ArrayRef<RelTy> rels);
@@ -67,6 +81,11 @@ private:
   // A list of sections to visit.
   SmallVector<InputSection *, 256> queue;
 
+  // The number of relocations in the queued sections. Scanning relocations
+  // is most of the work of marking, so this decides whether a parallel
+  // round is worth its thread dispatch and the extra pass over the edges.
+  size_t queuedRelocations = 0;
+
   // There are normally few input sections whose names are valid C
   // identifiers, so we just store a std::vector instead of a multimap.
   DenseMap<StringRef, std::vector<InputSectionBase *>> cNamedSections;
@@ -86,14 +105,19 @@ static uint64_t getAddend(InputSectionBase &sec,
   return rel.r_addend;
 }
 
+// Adds the references made by a relocation to Edges. This function only
+// reads the symbol table and sections, so it can be called from multiple
+// threads as long as applyEdges is not running at the same time.
 template <class ELFT>
 template <class RelTy>
 void MarkLive<ELFT>::resolveReloc(InputSectionBase &sec, RelTy &rel,
-                                  bool isLSDA) {
+                                  bool isLSDA, LiveEdges &edges) {
   Symbol &sym = sec.getFile<ELFT>()->getRelocTargetSym(rel);
 
-  // If a symbol is referenced in a live section, it is used.
-  sym.used = true;
+  // If a symbol is referenced in a live section, it is used. A shared symbol
+  // also makes its file needed, which applyEdges takes care of.
+  if (!sym.used || isa<SharedSymbol>(sym))
+    edges.symbols.push_back(&sym);
 
   if (auto *d = dyn_cast<Defined>(&sym)) {
     auto *relSec = dyn_cast_or_null<InputSectionBase>(d->section);
@@ -104,17 +128,32 @@ void MarkLive<ELFT>::resolveReloc(InputSectionBase &sec, RelTy &rel,
     if (d->isSection())
       offset += getAddend<ELFT>(sec, rel);
 
-    if (!isLSDA || !(relSec->flags & SHF_EXECINSTR))
-      enqueue(relSec, offset);
+    if ((!isLSDA || !(relSec->flags & SHF_EXECINSTR)) &&
+        isEnqueueNeeded(relSec))
+      edges.sections.push_back({relSec, offset});
     return;
   }
 
-  if (auto *ss = dyn_cast<SharedSymbol>(&sym))
-    if (!ss->isWeak())
-      ss->getFile().isNeeded = true;
+  if (isa<SharedSymbol>(sym))
+    return;
 
   for (InputSectionBase *sec : cNamedSections.lookup(sym.getName()))
-    enqueue(sec, 0);
+    if (isEnqueueNeeded(sec))
+      edges.sections.push_back({sec, 0});
+}
+
+template <class ELFT> void MarkLive<ELFT>::applyEdges(LiveEdges &edges) {
+  for (Symbol *sym : edges.symbols) {
+    sym->used = true;
+    if (auto *ss = dyn_cast<SharedSymbol>(sym))
+      if (!ss->isWeak())
+        ss->getFile().isNeeded = true;
+  }
+  for (std::pair<InputSectionBase *, uint64_t> &p : edges.sections)
+    enqueue(p.first, p.second);
+
+  edges.symbols.clear();
+  edges.sections.clear();
 }
 
 // The .eh_frame section is an unfortunate special case.
@@ -135,6 +174,7 @@ template <class ELFT>
 template <class RelTy>
 void MarkLive<ELFT>::scanEhFrameSection(EhInputSection &eh,
                                         ArrayRef<RelTy> rels) {
+  LiveEdges edges;
   for (size_t i = 0, end = eh.pieces.size(); i < end; ++i) {
     EhSectionPiece &piece = eh.pieces[i];
     size_t firstRelI = piece.firstRelocation;
@@ -144,7 +184,8 @@ void MarkLive<ELFT>::scanEhFrameSection(EhInputSection &eh,
     if (read32<ELFT::TargetEndianness>(piece.data().data() + 4) == 0) {
       // This is a CIE, we only need to worry about the first relocation. It is
       // known to point to the personality function.
-      resolveReloc(eh, rels[firstRelI], false);
+      resolveReloc(eh, rels[firstRelI], false, edges);
+      applyEdges(edges);
       continue;
     }
 
@@ -154,7 +195,8 @@ void MarkLive<ELFT>::scanEhFrameSection(EhInputSection &eh,
     uint64_t pieceEnd = piece.inputOff + piece.size;
     for (size_t j = firstRelI, end2 = rels.size(); j < end2; ++j)
       if (rels[j].r_offset < pieceEnd)
-        resolveReloc(eh, rels[j], true);
+        resolveReloc(eh, rels[j], true, edges);
+    applyEdges(edges);
   }
 }
 
@@ -199,8 +241,22 @@ void MarkLive<ELFT>::enqueue(InputSectionBase *sec, uint64_t offset) {
   sec->partition = sec->partition ? 1 : partition;
 
   // Add input section to the queue.
-  if (InputSection *s = dyn_cast<InputSection>(sec))
+  if (InputSection *s = dyn_cast<InputSection>(sec)) {
     queue.push_back(s);
+    queuedRelocations += s->numRelocations;
+  }
+}
+
+// Returns false if enqueue(Sec, ...) is known to be a no-op. Called from
+// multiple threads while no section is being enqueued.
+template <class ELFT>
+bool MarkLive<ELFT>::isEnqueueNeeded(InputSectionBase *sec) const {
+  if (sec == &InputSection::discarded)
+    return false;
+  // Pieces of mergeable sections have their own liveness bits.
+  if (isa<MergeInputSection>(sec))
+    return true;
+  return sec->partition != 1 && sec->partition != partition;
 }
 
 template <class ELFT> void MarkLive<ELFT>::markSymbol(Symbol *sym) {
@@ -268,24 +324,63 @@ template <class ELFT> void MarkLive<ELFT>::run() {
   mark();
 }
 
+template <class ELFT>
+void MarkLive<ELFT>::scanSection(InputSectionBase &sec, LiveEdges &edges) {
+  if (sec.areRelocsRela) {
+    for (const typename ELFT::Rela &rel : sec.template relas<ELFT>())
+      resolveReloc(sec, rel, false, edges);
+  } else {
+    for (const typename ELFT::Rel &rel : sec.template rels<ELFT>())
+      resolveReloc(sec, rel, false, edges);
+  }
+
+  for (InputSectionBase *isec : sec.dependentSections)
+    if (isEnqueueNeeded(isec))
+      edges.sections.push_back({isec, 0});
+}
+
 template <class ELFT> void MarkLive<ELFT>::mark() {
-  // Mark all reachable sections.
+  // Mark all reachable sections. The live set is the transitive closure of
+  // the roots, so it does not depend on the order in which sections are
+  // visited. That allows us to scan a large queue all at once in parallel.
+  //
+  // Parallel rounds are opt-in (--gc-sections-threads) and only pay off when
+  // the queue holds a lot of relocations spread over many sections. Small
+  // queues, which are the common case at the start and the end of marking and
+  // for small links, are scanned serially.
+  LiveEdges edges;
   while (!queue.empty()) {
-    InputSectionBase &sec = *queue.pop_back_val();
-
-    if (sec.areRelocsRela) {
-      for (const typename ELFT::Rela &rel : sec.template relas<ELFT>())
-        resolveReloc(sec, rel, false);
-    } else {
-      for (const typename ELFT::Rel &rel : sec.template rels<ELFT>())
-        resolveReloc(sec, rel, false);
+    if (config->gcSectionsThreads && threadsEnabled && queue.size() >= 1024 &&
+        queuedRelocations >= 64 * 1024) {
+      markParallel();
+      continue;
     }
 
-    for (InputSectionBase *isec : sec.dependentSections)
-      enqueue(isec, 0);
+    InputSectionBase &sec = *queue.pop_back_val();
+    queuedRelocations -= sec.numRelocations;
+    scanSection(sec, edges);
+    applyEdges(edges);
   }
 }
 
+// Scans all queued sections in parallel. Scanning does not mutate anything,
+// and the collected edges are then applied in queue order on this thread, so
+// newly found sections, used symbols and needed shared files are the same as
+// if we had visited the sections one by one.
+template <class ELFT> void MarkLive<ELFT>::markParallel() {
+  std::vector<InputSection *> sections(queue.begin(), queue.end());
+  queue.clear();
+  queuedRelocations = 0;
+
+  std::vector<LiveEdges> edges(sections.size());
+  parallelForEachN(0, sections.size(), [&](size_t i) {
+    scanSection(*sections[i], edges[i]);
+  });
+
+  for (LiveEdges &e : edges)
+    applyEdges(e);
+}
+
 // Move the sections for some symbols to the main partition, specifically ifuncs
 // (because they can result in an IRELATIVE being added to the main partition's
 // GOT, which means that the ifunc must be available when the main partition is
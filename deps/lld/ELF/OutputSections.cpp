@@ -8,6 +8,7 @@
 
 #include "OutputSections.h"
 #include "Config.h"
+#include "Incremental.h"
 #include "LinkerScript.h"
 #include "SymbolTable.h"
 #include "SyntheticSections.h"
@@ -21,6 +22,10 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SHA1.h"
 
+#if LLD_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
 using namespace llvm;
 using namespace llvm::dwarf;
 using namespace llvm::object;
@@ -175,31 +180,148 @@ static void fill(uint8_t *buf, size_t size,
   memcpy(buf + i, filler.data(), size - i);
 }
 
-// Compress section contents if this section contains debug info.
-template <class ELFT> void OutputSection::maybeCompress() {
+namespace {
+// A part of a debug section that is compressed independently of the others.
+struct CompressionShard {
+  size_t sectionIndex;
+  ArrayRef<uint8_t> data;
+  bool isLast;
+  SmallVector<char, 0> compressed;
+  uint32_t checksum;
+};
+} // namespace
+
+#if LLD_ENABLE_ZLIB
+// Shards are large enough that restarting the 32 KiB deflate window at
+// their boundaries costs a negligible amount of compression.
+static const size_t compressionShardSize = 1 << 20;
+
+// Compresses a shard to a raw deflate stream. Unless this is the last shard
+// of a section, the stream ends with a full flush instead of a final block,
+// so the shards of a section can be concatenated into a single stream.
+static void compressShard(CompressionShard &shard) {
+  z_stream s = {};
+  if (deflateInit2(&s, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    fatal("compress failed: deflateInit2 failed");
+
+  int flush = shard.isLast ? Z_FINISH : Z_FULL_FLUSH;
+  s.next_in = const_cast<uint8_t *>(shard.data.data());
+  s.avail_in = shard.data.size();
+
+  // deflateBound() is exact only for Z_FINISH. A full flush may need a few
+  // more bytes for the trailing empty stored block.
+  size_t bound = deflateBound(&s, shard.data.size()) + 16;
+  for (;;) {
+    size_t pos = shard.compressed.size();
+    shard.compressed.resize(pos + bound);
+    s.next_out = reinterpret_cast<Bytef *>(shard.compressed.data() + pos);
+    s.avail_out = bound;
+    int ret = deflate(&s, flush);
+    shard.compressed.resize(shard.compressed.size() - s.avail_out);
+    if (ret == Z_STREAM_ERROR)
+      fatal("compress failed: deflate failed");
+    if (flush == Z_FINISH ? ret == Z_STREAM_END : s.avail_out != 0)
+      break;
+  }
+  deflateEnd(&s);
+
+  shard.checksum = adler32(1, shard.data.data(), shard.data.size());
+}
+#else
+static const size_t compressionShardSize = SIZE_MAX;
+
+// Without direct access to zlib, each section is a single shard that is
+// compressed to a complete zlib stream.
+static void compressShard(CompressionShard &shard) {
+  if (Error e = zlib::compress(toStringRef(shard.data), shard.compressed))
+    fatal("compress failed: " + llvm::toString(std::move(e)));
+}
+#endif
+
+// Debug sections are compressed in batches of about this many uncompressed
+// bytes, so that the temporary copies of their contents do not all have to be
+// in memory at once. A batch still has enough shards to keep every thread
+// busy.
+static const size_t compressionBatchSize = 64 << 20;
+
+// Compress the contents of DWARF debug sections if --compress-debug-sections
+// is given. Sections are split into shards, and the shards of a batch of
+// sections are compressed in parallel. Then the shards of each section are
+// joined into one zlib stream, which is what SHF_COMPRESSED sections are
+// expected to contain.
+template <class ELFT> void elf::compressDebugSections() {
   using Elf_Chdr = typename ELFT::Chdr;
 
-  // Compress only DWARF debug sections.
-  if (!config->compressDebugSections || (flags & SHF_ALLOC) ||
-      !name.startswith(".debug_"))
+  if (!config->compressDebugSections)
     return;
 
-  // Create a section header.
-  zDebugHeader.resize(sizeof(Elf_Chdr));
-  auto *hdr = reinterpret_cast<Elf_Chdr *>(zDebugHeader.data());
-  hdr->ch_type = ELFCOMPRESS_ZLIB;
-  hdr->ch_size = size;
-  hdr->ch_addralign = alignment;
-
-  // Write section contents to a temporary buffer and compress it.
-  std::vector<uint8_t> buf(size);
-  writeTo<ELFT>(buf.data());
-  if (Error e = zlib::compress(toStringRef(buf), compressedData))
-    fatal("compress failed: " + llvm::toString(std::move(e)));
+  std::vector<OutputSection *> sections;
+  for (OutputSection *sec : outputSections)
+    if (!(sec->flags & SHF_ALLOC) && sec->name.startswith(".debug_"))
+      sections.push_back(sec);
+
+  std::vector<std::vector<uint8_t>> bufs(sections.size());
+  for (size_t begin = 0, end = 0; begin < sections.size(); begin = end) {
+    // Write section contents to temporary buffers and split them into shards.
+    // A batch always takes at least one section, however large.
+    std::vector<CompressionShard> shards;
+    size_t batchBytes = 0;
+    while (end < sections.size() &&
+           (end == begin || batchBytes < compressionBatchSize)) {
+      bufs[end].resize(sections[end]->size);
+      sections[end]->writeTo<ELFT>(bufs[end].data());
+      batchBytes += bufs[end].size();
+
+      ArrayRef<uint8_t> data = bufs[end];
+      do {
+        size_t n = std::min(data.size(), compressionShardSize);
+        shards.push_back({end, data.take_front(n), n == data.size()});
+        data = data.drop_front(n);
+      } while (!data.empty());
+      ++end;
+    }
 
-  // Update section headers.
-  size = sizeof(Elf_Chdr) + compressedData.size();
-  flags |= SHF_COMPRESSED;
+    parallelForEachN(0, shards.size(),
+                     [&](size_t i) { compressShard(shards[i]); });
+
+    for (size_t i = begin, j = 0; i < end; ++i) {
+      OutputSection *sec = sections[i];
+
+      // Create a section header.
+      sec->zDebugHeader.resize(sizeof(Elf_Chdr));
+      auto *hdr = reinterpret_cast<Elf_Chdr *>(sec->zDebugHeader.data());
+      hdr->ch_type = ELFCOMPRESS_ZLIB;
+      hdr->ch_size = sec->size;
+      hdr->ch_addralign = sec->alignment;
+
+#if LLD_ENABLE_ZLIB
+      // Wrap the concatenated deflate streams with a zlib header for a 32 KiB
+      // window and the Adler-32 checksum of the uncompressed contents.
+      SmallVector<char, 1> &out = sec->compressedData;
+      out = {'\x78', '\x01'};
+      uint32_t checksum = 1;
+      for (; j < shards.size() && shards[j].sectionIndex == i; ++j) {
+        CompressionShard &shard = shards[j];
+        out.append(shard.compressed.begin(), shard.compressed.end());
+        checksum = adler32_combine(checksum, shard.checksum, shard.data.size());
+        SmallVector<char, 0>().swap(shard.compressed);
+      }
+      out.resize(out.size() + 4);
+      write32be(out.data() + out.size() - 4, checksum);
+#else
+      sec->compressedData = std::move(shards[j++].compressed);
+#endif
+
+      // The shards of this section have been joined, so its uncompressed
+      // contents are no longer needed.
+      std::vector<uint8_t>().swap(bufs[i]);
+
+      // Update section headers.
+      sec->size = sizeof(Elf_Chdr) + sec->compressedData.size();
+      sec->flags |= SHF_COMPRESSED;
+    }
+  }
 }
 
 static void writeInt(uint8_t *buf, uint64_t data, uint64_t size) {
@@ -229,19 +351,23 @@ template <class ELFT> void OutputSection::writeTo(uint8_t *buf) {
     return;
   }
 
-  // Write leading padding.
+  // Write leading padding. If we are patching the previous output, the
+  // buffer is not zero-filled, so zero padding has to be written too.
   std::vector<InputSection *> sections = getInputSections(this);
   std::array<uint8_t, 4> filler = getFiller();
+  bool patching = isIncrementalPatch();
   bool nonZeroFiller = read32(filler.data()) != 0;
-  if (nonZeroFiller)
+  if (nonZeroFiller || patching)
     fill(buf, sections.empty() ? size : sections[0]->outSecOff, filler);
 
   parallelForEachN(0, sections.size(), [&](size_t i) {
     InputSection *isec = sections[i];
+    if (patching && isIncrementallyClean(isec))
+      return;
     isec->writeTo<ELFT>(buf);
 
     // Fill gaps between sections.
-    if (nonZeroFiller) {
+    if (nonZeroFiller || patching) {
       uint8_t *start = buf + isec->outSecOff + isec->getSize();
       uint8_t *end;
       if (i + 1 == sections.size())
@@ -415,7 +541,7 @@ template void OutputSection::writeTo<ELF32BE>(uint8_t *Buf);
 template void OutputSection::writeTo<ELF64LE>(uint8_t *Buf);
 template void OutputSection::writeTo<ELF64BE>(uint8_t *Buf);
 
-template void OutputSection::maybeCompress<ELF32LE>();
-template void OutputSection::maybeCompress<ELF32BE>();
-template void OutputSection::maybeCompress<ELF64LE>();
-template void OutputSection::maybeCompress<ELF64BE>();
+template void elf::compressDebugSections<ELF32LE>();
+template void elf::compressDebugSections<ELF32BE>();
+template void elf::compressDebugSections<ELF64LE>();
+template void elf::compressDebugSections<ELF64BE>();
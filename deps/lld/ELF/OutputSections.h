@@ -100,7 +100,6 @@ public:
 
   void finalize();
   template <class ELFT> void writeTo(uint8_t *buf);
-  template <class ELFT> void maybeCompress();
 
   void sort(llvm::function_ref<int(InputSectionBase *s)> order);
   void sortInitFini();
@@ -108,6 +107,7 @@ public:
 
 private:
   // Used for implementation of --compress-debug-sections option.
+  template <class ELFT> friend void compressDebugSections();
   std::vector<uint8_t> zDebugHeader;
   llvm::SmallVector<char, 1> compressedData;
 
@@ -118,6 +118,8 @@ int getPriority(StringRef s);
 
 std::vector<InputSection *> getInputSections(OutputSection* os);
 
+template <class ELFT> void compressDebugSections();
+
 // All output sections that are handled by the linker specially are
 // globally accessible. Writer initializes them, so don't use them
 // until Writer is initialized.
@@ -52,6 +52,7 @@
 #include "lld/Common/ErrorHandler.h"
 #include "lld/Common/Memory.h"
 #include "lld/Common/Strings.h"
+#include "lld/Common/Threads.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/raw_ostream.h"
@@ -1102,9 +1103,11 @@ struct IRelativeReloc {
 
 static std::vector<IRelativeReloc> iRelativeRelocs;
 
+// If knownExpr is non-null, it is the result of target->getRelExpr() for this
+// relocation, already computed by classifyReloc().
 template <class ELFT, class RelTy>
 static void scanReloc(InputSectionBase &sec, OffsetGetter &getOffset, RelTy *&i,
-                      RelTy *end) {
+                      RelTy *end, const RelExpr *knownExpr = nullptr) {
   const RelTy &rel = *i;
   uint32_t symIndex = rel.getSymbol(config->isMips64EL);
   Symbol &sym = sec.getFile<ELFT>()->getSymbol(symIndex);
@@ -1129,7 +1132,8 @@ static void scanReloc(InputSectionBase &sec, OffsetGetter &getOffset, RelTy *&i,
     return;
 
   const uint8_t *relocatedAddr = sec.data().begin() + rel.r_offset;
-  RelExpr expr = target->getRelExpr(type, sym, relocatedAddr);
+  RelExpr expr =
+      knownExpr ? *knownExpr : target->getRelExpr(type, sym, relocatedAddr);
 
   // Ignore "hint" relocations because they are only markers for relaxation.
   if (oneof<R_HINT, R_NONE>(expr))
@@ -1342,6 +1346,17 @@ static void scanReloc(InputSectionBase &sec, OffsetGetter &getOffset, RelTy *&i,
   processRelocAux<ELFT>(sec, expr, type, offset, sym, rel, addend);
 }
 
+// Sort relocations by offset for more efficient searching for
+// R_RISCV_PCREL_HI20 and R_PPC64_ADDR64.
+static void sortRelocations(InputSectionBase &sec) {
+  if (config->emachine == EM_RISCV ||
+      (config->emachine == EM_PPC64 && sec.name == ".toc"))
+    llvm::stable_sort(sec.relocations,
+                      [](const Relocation &lhs, const Relocation &rhs) {
+                        return lhs.offset < rhs.offset;
+                      });
+}
+
 template <class ELFT, class RelTy>
 static void scanRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels) {
   OffsetGetter getOffset(sec);
@@ -1352,14 +1367,7 @@ static void scanRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels) {
   for (auto i = rels.begin(), end = rels.end(); i != end;)
     scanReloc<ELFT>(sec, getOffset, i, end);
 
-  // Sort relocations by offset for more efficient searching for
-  // R_RISCV_PCREL_HI20 and R_PPC64_ADDR64.
-  if (config->emachine == EM_RISCV ||
-      (config->emachine == EM_PPC64 && sec.name == ".toc"))
-    llvm::stable_sort(sec.relocations,
-                      [](const Relocation &lhs, const Relocation &rhs) {
-                        return lhs.offset < rhs.offset;
-                      });
+  sortRelocations(sec);
 }
 
 template <class ELFT> void elf::scanRelocations(InputSectionBase &s) {
@@ -1369,6 +1377,175 @@ template <class ELFT> void elf::scanRelocations(InputSectionBase &s) {
     scanRelocs<ELFT>(s, s.rels<ELFT>());
 }
 
+// Most relocations in a typical link refer to a non-preemptible symbol defined
+// in a regular section and resolve to a link-time constant. Scanning them
+// only appends to the relocation list of their own section, so
+// they can be scanned for all sections in parallel. Everything else may create
+// GOT, PLT or copy relocation entries, dynamic relocations or undefined symbol
+// diagnostics, whose order is visible in the output. Those relocations are
+// deferred to a serial pass that visits them in the same order as
+// scanRelocations(), so the result is identical to scanning serially.
+namespace {
+struct DeferredReloc {
+  size_t relIndex;
+  // The number of relocations added to the section by the parallel pass
+  // before this one.
+  size_t resolvedBefore;
+  RelExpr expr;
+  bool hasExpr;
+};
+} // namespace
+
+// Returns true if the relocation was fully processed, that is, added to
+// sec.relocations or ignored in exactly the way scanReloc() would have. This
+// must stay in sync with scanReloc(). Otherwise the relocation is deferred; if
+// hasExpr is set, expr is the value of target->getRelExpr() for it.
+template <class ELFT, class RelTy>
+static bool classifyReloc(InputSectionBase &sec, const RelTy &rel,
+                          const RelTy *end, RelExpr &expr, bool &hasExpr) {
+  uint32_t symIndex = rel.getSymbol(config->isMips64EL);
+  Symbol &sym = sec.getFile<ELFT>()->getSymbol(symIndex);
+  RelType type = rel.getType(config->isMips64EL);
+  hasExpr = false;
+
+  // maybeReportUndefined() records a diagnostic for these. TLS relocations may
+  // update config->hasStaticTlsModel and consume the relocations following
+  // them.
+  if ((symIndex != 0 && sym.isUndefined() && !sym.isWeak()) || sym.isTls())
+    return false;
+
+  const uint8_t *relocatedAddr = sec.data().begin() + rel.r_offset;
+  expr = target->getRelExpr(type, sym, relocatedAddr);
+  hasExpr = true;
+  if (oneof<R_HINT, R_NONE>(expr))
+    return true;
+
+  // Copy relocations and canonical PLT entries change the definition of shared
+  // symbols and ifuncs as a side effect of scanning. Absolute symbols may need
+  // a diagnostic.
+  auto *d = dyn_cast<Defined>(&sym);
+  if (!d || !d->section || sym.isGnuIFunc())
+    return false;
+  if (config->emachine == EM_PPC64 && isPPC64SmallCodeModelTocReloc(type))
+    return false;
+
+  int64_t addend = computeAddend<ELFT>(rel, end, sec, expr, sym.isLocal());
+  RelExpr e = expr;
+  if (!sym.isPreemptible) {
+    if (e == R_GOT_PC) {
+      e = target->adjustRelaxExpr(type, relocatedAddr, e);
+    } else {
+      if (config->emachine == EM_PPC && e == R_PPC32_PLTREL)
+        addend = 0;
+      e = fromPlt(e);
+    }
+  }
+
+  if (oneof<R_GOTPLTONLY_PC, R_GOTPLTREL, R_GOTPLT, R_TLSGD_GOTPLT,
+            R_GOTONLY_PC, R_GOTREL, R_PPC64_TOCBASE, R_PPC64_RELAX_TOC>(e) ||
+      needsPlt(e) || needsGot(e))
+    return false;
+  if (!isStaticLinkTimeConstant(e, type, sym, sec, rel.r_offset))
+    return false;
+
+  sec.relocations.push_back({e, type, rel.r_offset, addend, &sym});
+  return true;
+}
+
+template <class ELFT, class RelTy>
+static void classifyRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels,
+                           std::vector<DeferredReloc> &deferred) {
+  sec.relocations.reserve(rels.size());
+
+  const RelTy *end = rels.end();
+  // A TLS relocation may be relaxed together with the relocations following
+  // it, in which case scanReloc() skips them. Those are left to the serial
+  // pass as well.
+  int mustDefer = 0;
+  for (size_t i = 0; i < rels.size(); ++i) {
+    DeferredReloc d = {i, sec.relocations.size(), R_NONE, false};
+    if (mustDefer > 0)
+      --mustDefer;
+    else if (classifyReloc<ELFT>(sec, rels[i], end, d.expr, d.hasExpr))
+      continue;
+    deferred.push_back(d);
+
+    Symbol &sym =
+        sec.getFile<ELFT>()->getSymbol(rels[i].getSymbol(config->isMips64EL));
+    if (sym.isTls())
+      mustDefer = std::max(
+          mustDefer,
+          target->getTlsGdRelaxSkip(rels[i].getType(config->isMips64EL)) - 1);
+  }
+
+  if (deferred.empty())
+    sortRelocations(sec);
+}
+
+template <class ELFT, class RelTy>
+static void mergeDeferredRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels,
+                                ArrayRef<DeferredReloc> deferred) {
+  std::vector<Relocation> resolved = std::move(sec.relocations);
+  sec.relocations.clear();
+  sec.relocations.reserve(rels.size());
+
+  OffsetGetter getOffset(sec);
+  const RelTy *i = rels.begin();
+  const RelTy *end = rels.end();
+  size_t next = 0;
+  for (const DeferredReloc &d : deferred) {
+    sec.relocations.insert(sec.relocations.end(), resolved.begin() + next,
+                           resolved.begin() + d.resolvedBefore);
+    next = d.resolvedBefore;
+
+    // Skip relocations consumed by a previous TLS relaxation.
+    if (rels.begin() + d.relIndex < i)
+      continue;
+    i = rels.begin() + d.relIndex;
+    scanReloc<ELFT>(sec, getOffset, i, end, d.hasExpr ? &d.expr : nullptr);
+  }
+  sec.relocations.insert(sec.relocations.end(), resolved.begin() + next,
+                         resolved.end());
+
+  sortRelocations(sec);
+}
+
+template <class ELFT>
+void elf::scanRelocations(ArrayRef<InputSectionBase *> sections) {
+  // MIPS computes addends and GOT entries across relocation pairs and
+  // handles N32 relocation sequences as one; scan serially.
+  if (config->emachine == EM_MIPS) {
+    for (InputSectionBase *s : sections)
+      scanRelocations<ELFT>(*s);
+    return;
+  }
+
+  // Pieces of .eh_frame are not contiguous with the section, so offsets need
+  // translating; those sections are few and are scanned in the serial pass.
+  std::vector<std::vector<DeferredReloc>> deferred(sections.size());
+  parallelForEachN(0, sections.size(), [&](size_t i) {
+    InputSectionBase &s = *sections[i];
+    if (isa<EhInputSection>(s))
+      return;
+    if (s.areRelocsRela)
+      classifyRelocs<ELFT>(s, s.relas<ELFT>(), deferred[i]);
+    else
+      classifyRelocs<ELFT>(s, s.rels<ELFT>(), deferred[i]);
+  });
+
+  for (size_t i = 0; i < sections.size(); ++i) {
+    InputSectionBase &s = *sections[i];
+    if (isa<EhInputSection>(s))
+      scanRelocations<ELFT>(s);
+    else if (deferred[i].empty())
+      continue;
+    else if (s.areRelocsRela)
+      mergeDeferredRelocs<ELFT>(s, s.relas<ELFT>(), deferred[i]);
+    else
+      mergeDeferredRelocs<ELFT>(s, s.rels<ELFT>(), deferred[i]);
+  }
+}
+
 // Figure out which representation to use for any absolute relocs to
 // non-preemptible ifuncs that we visited during scanRelocs().
 void elf::addIRelativeRelocs() {
@@ -1813,6 +1990,10 @@ template void elf::scanRelocations<ELF32LE>(InputSectionBase &);
 template void elf::scanRelocations<ELF32BE>(InputSectionBase &);
 template void elf::scanRelocations<ELF64LE>(InputSectionBase &);
 template void elf::scanRelocations<ELF64BE>(InputSectionBase &);
+template void elf::scanRelocations<ELF32LE>(ArrayRef<InputSectionBase *>);
+template void elf::scanRelocations<ELF32BE>(ArrayRef<InputSectionBase *>);
+template void elf::scanRelocations<ELF64LE>(ArrayRef<InputSectionBase *>);
+template void elf::scanRelocations<ELF64BE>(ArrayRef<InputSectionBase *>);
 template void elf::reportUndefinedSymbols<ELF32LE>();
 template void elf::reportUndefinedSymbols<ELF32BE>();
 template void elf::reportUndefinedSymbols<ELF64LE>();
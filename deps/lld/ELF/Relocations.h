@@ -114,6 +114,11 @@ struct Relocation {
 // the diagnostics.
 template <class ELFT> void scanRelocations(InputSectionBase &);
 
+// Scans the given sections in order, processing the relocations that cannot
+// have side effects on other sections in parallel. The result is the same as
+// calling scanRelocations() on each section in turn.
+template <class ELFT> void scanRelocations(ArrayRef<InputSectionBase *>);
+
 template <class ELFT> void reportUndefinedSymbols();
 
 void addIRelativeRelocs();
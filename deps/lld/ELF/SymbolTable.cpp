@@ -50,7 +50,7 @@ void SymbolTable::wrap(Symbol *sym, Symbol *real, Symbol *wrap) {
 }
 
 // Find an existing symbol or create a new one.
-Symbol *SymbolTable::insert(StringRef name) {
+CachedHashStringRef SymbolTable::getKey(StringRef name) {
   // <name>@@<version> means the symbol is the default version. In that
   // case <name>@@<version> will be used to resolve references to <name>.
   //
@@ -60,8 +60,13 @@ Symbol *SymbolTable::insert(StringRef name) {
   size_t pos = name.find('@');
   if (pos != StringRef::npos && pos + 1 < name.size() && name[pos + 1] == '@')
     name = name.take_front(pos);
+  return CachedHashStringRef(name);
+}
+
+Symbol *SymbolTable::insert(StringRef name) { return insert(getKey(name)); }
 
-  auto p = symMap.insert({CachedHashStringRef(name), (int)symVector.size()});
+Symbol *SymbolTable::insert(CachedHashStringRef key) {
+  auto p = symMap.insert({key, (int)symVector.size()});
   int &symIndex = p.first->second;
   bool isNew = p.second;
 
@@ -71,7 +76,7 @@ Symbol *SymbolTable::insert(StringRef name) {
   Symbol *sym = reinterpret_cast<Symbol *>(make<SymbolUnion>());
   symVector.push_back(sym);
 
-  sym->setName(name);
+  sym->setName(key.val());
   sym->symbolKind = Symbol::PlaceholderKind;
   sym->versionId = config->defaultSymbolVersion;
   sym->visibility = STV_DEFAULT;
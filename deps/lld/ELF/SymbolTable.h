@@ -43,6 +43,13 @@ public:
 
   Symbol *insert(StringRef name);
 
+  // Same as insert(name), given getKey(name).
+  Symbol *insert(llvm::CachedHashStringRef key);
+
+  // Returns the key the symbol table stores a symbol name under. Unlike
+  // insert(), this may be called from multiple threads.
+  static llvm::CachedHashStringRef getKey(StringRef name);
+
   Symbol *addSymbol(const Symbol &New);
 
   void scanVersionScript();
@@ -10,6 +10,7 @@
 #include "AArch64ErrataFix.h"
 #include "CallGraphSort.h"
 #include "Config.h"
+#include "Incremental.h"
 #include "LinkerScript.h"
 #include "MapFile.h"
 #include "OutputSections.h"
@@ -573,6 +574,11 @@ template <class ELFT> void Writer<ELFT>::run() {
   if (config->copyRelocs)
     addSectionSymbols();
 
+  // With --incremental, read the previous state before any section is
+  // given an address, so that sections keep their previous slots.
+  if (config->incremental)
+    readIncrementalState();
+
   // Now that we have a complete set of output sections. This function
   // completes section contents. For example, we need to add strings
   // to the string table, and add entries to .got and .plt.
@@ -587,8 +593,7 @@ template <class ELFT> void Writer<ELFT>::run() {
   // If -compressed-debug-sections is specified, we need to compress
   // .debug_* sections. Do it right now because it changes the size of
   // output sections.
-  for (OutputSection *sec : outputSections)
-    sec->maybeCompress<ELFT>();
+  compressDebugSections<ELFT>();
 
   script->allocateHeaders(mainPart->phdrs);
 
@@ -616,11 +621,20 @@ template <class ELFT> void Writer<ELFT>::run() {
   // It does not make sense try to open the file if we have error already.
   if (errorCount())
     return;
+
+  // Opening the output file removes the previous output, so decide whether
+  // it can be patched first.
+  if (config->incremental)
+    prepareIncrementalPatch();
+
   // Write the result down to a file.
   openFile();
   if (errorCount())
     return;
 
+  if (config->incremental)
+    copyIncrementalBase(Out::bufferStart);
+
   if (!config->oFormatBinary) {
     writeTrapInstr();
     writeHeader();
@@ -641,6 +655,10 @@ template <class ELFT> void Writer<ELFT>::run() {
   if (errorCount())
     return;
 
+  if (config->incremental)
+    writeIncrementalState(
+        makeArrayRef(buffer->getBufferStart(), buffer->getBufferSize()));
+
   if (auto e = buffer->commit())
     error("failed to write to the output file: " + toString(std::move(e)));
 }
@@ -1738,7 +1756,9 @@ template <class ELFT> void Writer<ELFT>::finalizeSections() {
   // Scan relocations. This must be done after every symbol is declared so that
   // we can correctly decide if a dynamic relocation is needed.
   if (!config->relocatable) {
-    forEachRelSec(scanRelocations<ELFT>);
+    std::vector<InputSectionBase *> relSecs;
+    forEachRelSec([&](InputSectionBase &s) { relSecs.push_back(&s); });
+    scanRelocations<ELFT>(relSecs);
     reportUndefinedSymbols<ELFT>();
   }
 
@@ -10,11 +10,20 @@
 #define LLD_FILESYSTEM_H
 
 #include "lld/Common/LLVM.h"
+#include "llvm/ADT/Optional.h"
+#include <memory>
 #include <system_error>
 
 namespace lld {
 void unlinkAsync(StringRef path);
 std::error_code tryCreateFile(StringRef path);
+
+// A program embedding lld may have just generated an input file in memory.
+// Registering it here under the path it is also being written to lets the
+// drivers use the buffer directly instead of reading the file back from disk.
+void addInMemoryFile(StringRef path, std::unique_ptr<MemoryBuffer> mb);
+void removeInMemoryFile(StringRef path);
+llvm::Optional<MemoryBufferRef> findInMemoryFile(StringRef path);
 } // namespace lld
 
 #endif
@@ -0,0 +1,43 @@
+# REQUIRES: x86, zlib
+## Debug sections larger than 1 MiB are compressed in several shards which
+## are joined into one zlib stream. Check that it decompresses to the
+## original contents.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t
+# RUN: ld.lld -threads %t.o -o %t.z --compress-debug-sections=zlib
+# RUN: ld.lld -no-threads %t.o -o %t.z.nothreads --compress-debug-sections=zlib
+# RUN: cmp %t.z %t.z.nothreads
+
+# RUN: llvm-readobj -S %t.z | FileCheck %s
+# CHECK:      Name: .debug_info
+# CHECK-NEXT: Type: SHT_PROGBITS
+# CHECK-NEXT: Flags [
+# CHECK-NEXT:   SHF_COMPRESSED
+# CHECK:      Name: .debug_str
+# CHECK-NEXT: Type: SHT_PROGBITS
+# CHECK-NEXT: Flags [
+# CHECK-NEXT:   SHF_COMPRESSED
+
+# RUN: llvm-objcopy --decompress-debug-sections %t.z %t.d
+# RUN: llvm-objcopy --dump-section=.debug_info=%t.info %t
+# RUN: llvm-objcopy --dump-section=.debug_info=%t.d.info %t.d
+# RUN: cmp %t.info %t.d.info
+# RUN: llvm-objcopy --dump-section=.debug_str=%t.str %t
+# RUN: llvm-objcopy --dump-section=.debug_str=%t.d.str %t.d
+# RUN: cmp %t.str %t.d.str
+
+.globl _start
+_start:
+  ret
+
+.section .debug_info,"",@progbits
+.rept 100000
+  .quad 0x0123456789abcdef
+  .long 0x5a5a5a5a
+.endr
+  .fill 1500000, 1, 0xcc
+
+.section .debug_str,"MS",@progbits,1
+  .asciz "AAAAAAAAAAAAAAAAAAAAAAAAAAA"
+  .asciz "BBBBBBBBBBBBBBBBBBBBBBBBBBB"
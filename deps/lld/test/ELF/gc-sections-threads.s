@@ -0,0 +1,48 @@
+# REQUIRES: x86
+## With --gc-sections-threads, large queues of live sections are scanned in
+## parallel. Check that the set of garbage-collected sections does not
+## depend on it.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld -threads --gc-sections-threads -shared --gc-sections \
+# RUN:   --print-gc-sections %t.o -o %t.threads.so > %t.threads.txt
+# RUN: ld.lld -no-threads -shared --gc-sections --print-gc-sections %t.o \
+# RUN:   -o %t.nothreads.so > %t.nothreads.txt
+# RUN: cmp %t.threads.so %t.nothreads.so
+# RUN: cmp %t.threads.txt %t.nothreads.txt
+# RUN: FileCheck %s < %t.threads.txt
+
+# CHECK-NOT:  removing unused section {{.*}}:(.text.exported)
+# CHECK-NOT:  removing unused section {{.*}}:(.text.used)
+# CHECK:      removing unused section {{.*}}:(.text.unused)
+# CHECK-NOT:  removing unused section {{.*}}:(.text.exported)
+# CHECK-NOT:  removing unused section {{.*}}:(.text.used)
+
+## Each copy of the macro defines an exported function, a local function it
+## calls, a mergeable string and an unreferenced function. The exported
+## functions make up a queue that is large enough (1100 sections with 66000
+## relocations) to be scanned in parallel.
+.macro def
+.section .text.exported,"ax",@progbits,unique,\@
+.globl exported\@
+exported\@:
+  .rept 60
+  call used\@
+  .endr
+  ret
+.section .text.used,"ax",@progbits,unique,\@
+used\@:
+  leaq .Lstr\@(%rip), %rax
+  ret
+.section .text.unused,"ax",@progbits,unique,\@
+unused\@:
+  call used\@
+  ret
+.section .rodata.str,"aMS",@progbits,1
+.Lstr\@:
+  .asciz "str\@"
+.endm
+
+.rept 1100
+def
+.endr
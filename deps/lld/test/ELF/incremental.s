@@ -0,0 +1,59 @@
+# REQUIRES: x86
+## --incremental patches the previous output if the layout does not change.
+## The result must be the same as writing the output from scratch.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: echo '.globl foo; .type foo,@function; foo: movl $1, %eax; ret; \
+# RUN:   .data; .globl bar; bar: .quad foo' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64-unknown-linux - -o %t1.o
+# RUN: echo '.globl foo; .type foo,@function; foo: movl $2, %eax; ret; \
+# RUN:   .data; .globl bar; bar: .quad foo' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64-unknown-linux - -o %t2.o
+# RUN: echo '.globl foo; .type foo,@function; foo: .fill 4096, 1, 0x90; ret; \
+# RUN:   .data; .globl bar; bar: .quad foo' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64-unknown-linux - -o %t3.o
+
+# RUN: rm -f %t.state %t.fresh.state
+# RUN: cp %t1.o %t.in.o
+# RUN: ld.lld --incremental --incremental-state=%t.state %t.o %t.in.o -o %t
+
+## Only %t.in.o has changed, and it still fits in its slots.
+# RUN: cp %t2.o %t.in.o
+# RUN: ld.lld --incremental --incremental-state=%t.state %t.o %t.in.o -o %t \
+# RUN:   --verbose 2>&1 | FileCheck --check-prefix=PATCH %s
+# RUN: ld.lld --incremental --incremental-state=%t.fresh.state %t.o %t.in.o \
+# RUN:   -o %t.fresh
+# RUN: cmp %t %t.fresh
+# RUN: llvm-objdump -d %t | FileCheck --check-prefix=DIS %s
+
+# PATCH: --incremental: patching {{.*}}; 1 of 2 object files need to be written
+
+# DIS:      {{<?}}foo{{>?}}:
+# DIS-NEXT:   movl $2, %eax
+
+## foo no longer fits in its slot.
+# RUN: cp %t3.o %t.in.o
+# RUN: ld.lld --incremental --incremental-state=%t.state %t.o %t.in.o -o %t \
+# RUN:   --verbose 2>&1 | FileCheck --check-prefix=LAYOUT %s
+# RUN: rm -f %t.fresh.state
+# RUN: ld.lld --incremental --incremental-state=%t.fresh.state %t.o %t.in.o \
+# RUN:   -o %t.fresh
+# RUN: cmp %t %t.fresh
+
+# LAYOUT: --incremental: layout has changed; writing the output from scratch
+
+## The state is not used if the options have changed.
+# RUN: ld.lld --incremental --incremental-state=%t.state %t.o %t.in.o -o %t \
+# RUN:   -z now --verbose 2>&1 | FileCheck --check-prefix=ARGS %s
+
+# ARGS: --incremental: options have changed since the previous link
+
+# RUN: not ld.lld --incremental -r %t.o -o /dev/null 2>&1 | \
+# RUN:   FileCheck --check-prefix=ERR %s
+# ERR: -r and --incremental may not be used together
+
+.globl _start
+_start:
+  call foo
+  movq bar(%rip), %rax
+  ret
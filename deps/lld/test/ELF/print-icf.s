@@ -13,9 +13,11 @@
 # CHECK:   removing identical section {{.*}}:(.text.f3)
 # CHECK:   removing identical section {{.*}}:(.text.f5)
 # CHECK:   removing identical section {{.*}}:(.text.f6)
+# CHECK: ICF folded 5 sections (62 bytes)
 
 # PRINT-NOT: selected
 # PRINT-NOT: removing
+# PRINT-NOT: ICF folded
 
 .globl _start, f1, f2
 _start:
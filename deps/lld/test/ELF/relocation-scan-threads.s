@@ -0,0 +1,62 @@
+# REQUIRES: x86
+## Relocations that do not create GOT, PLT or dynamic relocation entries are
+## scanned in parallel. Check that the output does not depend on it.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: echo '.globl shared_fn, shared_obj; .type shared_obj,@object; \
+# RUN:   shared_fn: ret; .data; shared_obj: .quad 0; .size shared_obj, 8' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64-unknown-linux - -o %t1.o
+# RUN: ld.lld -shared -soname=t1.so %t1.o -o %t1.so
+## A copy relocation, only valid in a position dependent executable.
+# RUN: echo '.globl _start; _start: movq shared_obj(%rip), %rax' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64-unknown-linux - -o %t2.o
+
+# RUN: ld.lld -threads %t.o %t2.o %t1.so -o %t.threads
+# RUN: ld.lld -no-threads %t.o %t2.o %t1.so -o %t.nothreads
+# RUN: cmp %t.threads %t.nothreads
+
+# RUN: ld.lld -threads -shared %t.o %t1.so -o %t.threads.so
+# RUN: ld.lld -no-threads -shared %t.o %t1.so -o %t.nothreads.so
+# RUN: cmp %t.threads.so %t.nothreads.so
+
+# RUN: ld.lld -threads -pie %t.o %t1.so -o %t.threads.pie
+# RUN: ld.lld -no-threads -pie %t.o %t1.so -o %t.nothreads.pie
+# RUN: cmp %t.threads.pie %t.nothreads.pie
+
+.globl global_fn
+.type tls,@object
+
+.text
+foo:
+  call local_fn
+  call global_fn@PLT
+  call shared_fn@PLT
+  movq shared_obj@GOTPCREL(%rip), %rax
+  leaq local_data(%rip), %rax
+  movq global_fn@GOTPCREL(%rip), %rax
+  data16
+  leaq tls@tlsgd(%rip), %rdi
+  data16
+  data16
+  rex64
+  call __tls_get_addr@PLT
+  movq tls@gottpoff(%rip), %rax
+  ret
+
+local_fn:
+  ret
+
+global_fn:
+  ret
+
+.data
+local_data:
+  .quad local_fn
+  .quad global_fn
+  .quad shared_fn
+  .quad local_data + 8
+
+.section .tbss,"awT",@nobits
+.globl tls
+tls:
+  .zero 8
@@ -13,6 +13,7 @@
 #include "InputGlobal.h"
 #include "SymbolTable.h"
 #include "lld/Common/ErrorHandler.h"
+#include "lld/Common/Filesystem.h"
 #include "lld/Common/Memory.h"
 #include "lld/Common/Reproduce.h"
 #include "llvm/Object/Binary.h"
@@ -34,6 +35,12 @@ std::unique_ptr<llvm::TarWriter> lld::wasm::tar;
 Optional<MemoryBufferRef> lld::wasm::readFile(StringRef path) {
   log("Loading: " + path);
 
+  if (Optional<MemoryBufferRef> mbref = findInMemoryFile(path)) {
+    if (tar)
+      tar->append(relativeToRoot(path), mbref->getBuffer());
+    return mbref;
+  }
+
   auto mbOrErr = MemoryBuffer::getFile(path);
   if (auto ec = mbOrErr.getError()) {
     error("cannot open " + path + ": " + ec.message());
@@ -1022,6 +1022,7 @@ pub const LibExeObjStep = struct {
     disable_gen_h: bool,
     bundle_compiler_rt: bool,
     disable_stack_probing: bool,
+    dedup_fns: bool,
     c_std: Builder.CStd,
     override_lib_dir: ?[]const u8,
     main_pkg_path: ?[]const u8,
@@ -1053,6 +1054,30 @@ pub const LibExeObjStep = struct {
     libc_file: ?[]const u8 = null,
     target_glibc: ?Version = null,
 
+    /// Passed as -mcpu; replaces the default CPU model of the target.
+    target_cpu: ?[]const u8 = null,
+    /// Passed as -mattr, e.g. "+avx2,-sse4a"; applied on top of the CPU model.
+    target_features: ?[]const u8 = null,
+
+    /// Passed as -fprofile-generate; running the artifact writes <dir>/<name>.zprof.
+    profile_generate_dir: ?[]const u8 = null,
+    /// Passed as -fprofile-use.
+    profile_use_path: ?[]const u8 = null,
+
+    /// Passed as -flto=thin.
+    thin_lto: bool = false,
+
+    /// Passed as -gline-tables-only.
+    line_tables_only: bool = false,
+    /// Passed as -gsplit-dwarf.
+    split_dwarf: bool = false,
+
+    /// Passed as --icf: "none", "safe" or "all".
+    icf: ?[]const u8 = null,
+
+    /// Passed as -fcall-graph-profile.
+    call_graph_profile: bool = false,
+
     valgrind_support: ?bool = null,
 
     /// Uses system Wine installation to run cross compiled Windows build artifacts.
@@ -1166,6 +1191,7 @@ pub const LibExeObjStep = struct {
             .disable_gen_h = false,
             .bundle_compiler_rt = false,
             .disable_stack_probing = false,
+            .dedup_fns = false,
             .output_dir = null,
             .need_system_paths = false,
             .single_threaded = false,
@@ -1747,6 +1773,31 @@ pub const LibExeObjStep = struct {
         if (self.disable_stack_probing) {
             try zig_args.append("-fno-stack-check");
         }
+        if (self.dedup_fns) {
+            try zig_args.append("-fdedup-fns");
+        }
+        if (self.profile_generate_dir) |dir| {
+            try zig_args.append(builder.fmt("-fprofile-generate={}", dir));
+        }
+        if (self.profile_use_path) |path| {
+            try zig_args.append(builder.fmt("-fprofile-use={}", path));
+        }
+        if (self.thin_lto) {
+            try zig_args.append("-flto=thin");
+        }
+        if (self.line_tables_only) {
+            try zig_args.append("-gline-tables-only");
+        }
+        if (self.split_dwarf) {
+            try zig_args.append("-gsplit-dwarf");
+        }
+        if (self.icf) |icf| {
+            try zig_args.append("--icf");
+            try zig_args.append(icf);
+        }
+        if (self.call_graph_profile) {
+            try zig_args.append("-fcall-graph-profile");
+        }
 
         switch (self.target) {
             .Native => {},
@@ -1755,6 +1806,12 @@ pub const LibExeObjStep = struct {
                 try zig_args.append(self.target.zigTriple(builder.allocator) catch unreachable);
             },
         }
+        if (self.target_cpu) |cpu| {
+            try zig_args.append(builder.fmt("-mcpu={}", cpu));
+        }
+        if (self.target_features) |features| {
+            try zig_args.append(builder.fmt("-mattr={}", features));
+        }
 
         if (self.target_glibc) |ver| {
             try zig_args.append("-target-glibc");
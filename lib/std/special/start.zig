@@ -174,7 +174,40 @@ fn callMainWithArgs(argc: usize, argv: [*][*]u8, envp: [][*]u8) u8 {
 
     std.debug.maybeEnableSegfaultHandler();
 
-    return initEventLoopAndCallMain();
+    const result = initEventLoopAndCallMain();
+    if (builtin.profile_generate) writeFunctionProfile();
+    return result;
+}
+
+// Defined by the compiler when building with -fprofile-generate.
+extern var __zig_profile_counters: usize;
+extern const __zig_profile_names: u8;
+extern const __zig_profile_names_len: usize;
+extern const __zig_profile_path: u8;
+
+/// Appends a "<count> <symbol>" line for every function that was entered. Lines are appended
+/// so that several runs accumulate; the compiler sums the counts for each symbol.
+fn writeFunctionProfile() void {
+    const counters = @ptrCast([*]usize, &__zig_profile_counters);
+    const names = @ptrCast([*]const u8, &__zig_profile_names)[0..__zig_profile_names_len];
+    const path = @ptrCast([*]const u8, &__zig_profile_path);
+    const flags = std.os.O_WRONLY | std.os.O_CREAT | std.os.O_APPEND | std.os.O_CLOEXEC;
+    const fd = std.os.openC(path, flags, 0o666) catch return;
+    defer std.os.close(fd);
+
+    var fn_index: usize = 0;
+    var name_start: usize = 0;
+    while (std.mem.indexOfScalarPos(u8, names, name_start, '\n')) |name_end| : (fn_index += 1) {
+        const name_line = names[name_start .. name_end + 1];
+        name_start = name_end + 1;
+        const count = @atomicLoad(usize, &counters[fn_index], .Monotonic);
+        if (count == 0) continue;
+        var count_buf: [24]u8 = undefined;
+        const count_len = std.fmt.formatIntBuf(count_buf[0..], count, 10, false, std.fmt.FormatOptions{});
+        count_buf[count_len] = ' ';
+        std.os.write(fd, count_buf[0 .. count_len + 1]) catch return;
+        std.os.write(fd, name_line) catch return;
+    }
 }
 
 extern fn main(c_argc: i32, c_argv: [*][*]u8, c_envp: [*]?[*]u8) i32 {
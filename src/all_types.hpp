@@ -1431,6 +1431,8 @@ struct ZigTypeOpaque {
 struct ZigTypeFnFrame {
     ZigFn *fn;
     ZigType *locals_struct;
+    // What abi_size would be if every alloca had its own field.
+    size_t unshared_abi_size;
 
     // This is set to the type that resolving the frame currently depends on, null if none.
     // It's for generating a helpful error message.
@@ -1562,6 +1564,8 @@ struct ZigFn {
 
     uint32_t align_bytes;
     uint32_t alignstack_value;
+    // Runtime safety checks proven redundant and removed from analyzed_executable.
+    size_t removed_safety_check_count;
 
     bool calls_or_awaits_errorable_fn;
     bool is_cold;
@@ -1828,6 +1832,12 @@ enum BuildMode {
     BuildModeSmallRelease,
 };
 
+enum LinkerIcf {
+    LinkerIcfNone,
+    LinkerIcfSafe,
+    LinkerIcfAll,
+};
+
 enum EmitFileType {
     EmitFileTypeBinary,
     EmitFileTypeAssembly,
@@ -1865,6 +1875,36 @@ struct CFile {
 };
 
 // When adding fields, check if they should be added to the hash computation in build_with_cache
+// A function whose body was identical to another's, so only the other one was emitted.
+struct FnMerge {
+    ZigFn *merged;
+    ZigFn *kept;
+    size_t instruction_count;
+};
+
+enum SizeReportKind {
+    SizeReportKindFn,
+    SizeReportKindVar,
+    // Anonymous constant data, such as comptime-generated tables and string literals.
+    SizeReportKindConst,
+    SizeReportKindOther,
+};
+
+struct SizeReportSymbol {
+    Buf *name;
+    uint64_t size;
+    SizeReportKind kind;
+    // For SizeReportKindConst, the function that refers to the data, if only one does.
+    ZigFn *fn;
+    Tld *tld;
+};
+
+struct SizeReportSection {
+    Buf *name;
+    uint64_t size;
+    ZigLLVMObjectSectionKind kind;
+};
+
 struct CodeGen {
     //////////////////////////// Runtime State
     LLVMModuleRef module;
@@ -1877,7 +1917,10 @@ struct CodeGen {
     LinkLib *libc_link_lib;
     LLVMTargetDataRef target_data_ref;
     LLVMTargetMachineRef target_machine;
+    const char *llvm_cpu;
+    const char *llvm_features;
     ZigLLVMDIFile *dummy_di_file;
+    ZigLLVMDIType *empty_fn_di_type;
     LLVMValueRef cur_ret_ptr;
     LLVMValueRef cur_frame_ptr;
     LLVMValueRef cur_fn_val;
@@ -1901,6 +1944,7 @@ struct CodeGen {
     LLVMValueRef merge_err_ret_traces_fn_val;
     LLVMValueRef sp_md_node;
     LLVMValueRef err_name_table;
+    LLVMValueRef profile_counters;
     LLVMValueRef safety_crash_err_fn;
     LLVMValueRef return_err_fn;
     LLVMTypeRef anyframe_fn_type;
@@ -1982,6 +2026,16 @@ struct CodeGen {
     Buf global_asm;
     Buf output_file_path;
     Buf o_file_output_path;
+    Buf asm_output_path;
+    Buf llvm_ir_output_path;
+    Buf llvm_bc_output_path;
+    Buf dwo_output_path;
+    // Set when the object was emitted to memory and handed to LLD directly. The copy at
+    // o_file_output_path is then written by o_file_write_thread while linking proceeds.
+    const char *o_file_mem_ptr;
+    size_t o_file_mem_len;
+    OsThread *o_file_write_thread;
+    Error o_file_write_err;
     Buf *cache_dir;
     // As an input parameter, mutually exclusive with enable_cache. But it gets
     // populated in codegen_build_and_link.
@@ -2008,6 +2062,9 @@ struct CodeGen {
     ZigFn *panic_fn;
 
     ZigFn *largest_frame_fn;
+    ZigList<FnMerge> fn_merges;
+    ZigList<SizeReportSymbol> size_report_symbols;
+    ZigList<SizeReportSection> size_report_sections;
 
     Stage2ProgressNode *main_progress_node;
     Stage2ProgressNode *sub_progress_node;
@@ -2044,6 +2101,7 @@ struct CodeGen {
     bool enable_cache; // mutually exclusive with output_dir
     bool enable_time_report;
     bool enable_stack_report;
+    bool enable_size_report;
     bool system_linker_hack;
     bool reported_bad_link_libc_error;
     bool is_dynamic; // shared library rather than static library. dynamic musl rather than static musl.
@@ -2072,6 +2130,11 @@ struct CodeGen {
     const char *linker_script;
 
     EmitFileType emit_file_type;
+    // Additional outputs written next to the one selected by emit_file_type, from the same
+    // optimized module.
+    bool emit_asm;
+    bool emit_llvm_ir;
+    bool emit_llvm_bc;
     BuildMode build_mode;
     OutType out_type;
     const ZigTarget *zig_target;
@@ -2082,17 +2145,38 @@ struct CodeGen {
     bool is_single_threaded;
     bool want_single_threaded;
     bool linker_rdynamic;
+    // LLD compresses the .debug_* sections of the output with zlib.
+    bool linker_compress_debug_sections;
+    // LLD reserves room in the output and patches the previous output when
+    // only a few object files changed.
+    bool linker_incremental;
+    // LLD folds identical functions. Safe folding keeps functions whose
+    // address is taken apart, using the objects' address-significance tables.
+    LinkerIcf linker_icf;
     bool each_lib_rpath;
-    bool is_dummy_so;
     bool disable_gen_h;
     bool bundle_compiler_rt;
     bool have_pic;
     bool have_dynamic_link; // this is whether the final thing will be dynamically linked. see also is_dynamic
     bool have_stack_probing;
     bool function_sections;
+    // Objects are ThinLTO bitcode and LLD generates the machine code at link time.
+    bool thin_lto;
+    // Debug builds skip the IR optimizer and emit line tables only.
+    bool debug_fast;
+    // Calls are recorded with static weights so that the linker places callers next to callees.
+    bool call_graph_profile;
+    // Debug info has only what stack traces need: functions and line tables, no types or variables.
+    bool debug_line_tables_only;
+    // Debug info goes into a .dwo file next to the object, and only a skeleton reaches the linker.
+    bool debug_split_dwarf;
+    // Functions that are identical after lowering, typically generic instantiations over types
+    // with the same layout, are emitted once.
+    bool dedup_fns;
     bool enable_dump_analysis;
     bool enable_doc_generation;
     bool disable_bin_generation;
+    bool profile_generate;
 
     Buf *mmacosx_version_min;
     Buf *mios_version_min;
@@ -2104,6 +2188,16 @@ struct CodeGen {
     Buf *zig_std_dir;
     Buf *dynamic_linker_path;
     Buf *version_script_path;
+    // Where an instrumented program writes its function entry counts; the
+    // current directory when null.
+    Buf *profile_generate_dir;
+    // Function entry counts to optimize with, and the symbol ordering file
+    // derived from them for the linker.
+    Buf *profile_use_path;
+    Buf *symbol_ordering_file_path;
+    // CPU model and "+feat,-feat" list from -mcpu and -mattr; null for the target's default.
+    Buf *mcpu;
+    Buf *mattr;
 
     const char **llvm_argv;
     size_t llvm_argv_len;
@@ -3792,6 +3886,10 @@ struct IrInstructionAllocaGen {
     uint32_t align;
     const char *name_hint;
     size_t field_index;
+    // Only used when laying out an async frame. Allocas whose lifetime scopes
+    // are not nested in each other may share a frame field.
+    Scope *lifetime_scope;
+    size_t slot_index;
 };
 
 struct IrInstructionEndExpr {
@@ -3991,6 +4089,8 @@ static const size_t stack_trace_ptr_count = 32; // Must be a power of 2.
 
 #define CACHE_OUT_SUBDIR "o"
 #define CACHE_HASH_SUBDIR "h"
+#define CACHE_THINLTO_SUBDIR "thinlto"
+#define CACHE_INCREMENTAL_SUBDIR "incremental"
 
 enum FloatMode {
     FloatModeStrict,
@@ -1995,6 +1995,40 @@ static ZigType *get_struct_type(CodeGen *g, const char *type_name, SrcField fiel
     return struct_type;
 }
 
+// Returns the abi_size that get_struct_type would compute for these fields,
+// without creating the type.
+static size_t get_src_fields_abi_size(SrcField fields[], size_t field_count, unsigned min_abi_align) {
+    size_t abi_align = min_abi_align;
+    for (size_t i = 0; i < field_count; i += 1) {
+        if (type_has_bits(fields[i].ty)) {
+            unsigned field_abi_align = max(fields[i].align, fields[i].ty->abi_align);
+            if (field_abi_align > abi_align) {
+                abi_align = field_abi_align;
+            }
+        }
+    }
+
+    size_t next_offset = 0;
+    for (size_t i = 0; i < field_count; i += 1) {
+        if (!type_has_bits(fields[i].ty))
+            continue;
+
+        size_t next_src_field_index = i + 1;
+        for (; next_src_field_index < field_count; next_src_field_index += 1) {
+            if (type_has_bits(fields[next_src_field_index].ty))
+                break;
+        }
+        size_t next_abi_align;
+        if (next_src_field_index == field_count) {
+            next_abi_align = abi_align;
+        } else {
+            next_abi_align = max(fields[next_src_field_index].align, fields[next_src_field_index].ty->abi_align);
+        }
+        next_offset = next_field_offset(next_offset, abi_align, fields[i].ty->abi_size, next_abi_align);
+    }
+    return next_offset;
+}
+
 static size_t get_store_size_bytes(size_t size_in_bits) {
     return (size_in_bits + 7) / 8;
 }
@@ -3173,7 +3207,7 @@ void append_namespace_qualification(CodeGen *g, Buf *buf, ZigType *container_typ
     buf_append_char(buf, NAMESPACE_SEP_CHAR);
 }
 
-static void get_fully_qualified_decl_name(CodeGen *g, Buf *buf, Tld *tld, bool is_test) {
+void get_fully_qualified_decl_name(CodeGen *g, Buf *buf, Tld *tld, bool is_test) {
     buf_resize(buf, 0);
 
     Scope *scope = tld->parent_scope;
@@ -4573,6 +4607,8 @@ static void analyze_fn_ir(CodeGen *g, ZigFn *fn, AstNode *return_type_node) {
         fn->anal_state = FnAnalStateInvalid;
     }
 
+    fn->removed_safety_check_count = ir_remove_redundant_safety_checks(g, &fn->analyzed_executable);
+
     if (g->verbose_ir) {
         fprintf(stderr, "fn %s() { // (analyzed)\n", buf_ptr(&fn->symbol_name));
         ir_print(g, stderr, &fn->analyzed_executable, 4, IrPassGen);
@@ -4617,6 +4653,44 @@ static void analyze_fn_body(CodeGen *g, ZigFn *fn_table_entry) {
     analyze_fn_ir(g, fn_table_entry, return_type_node);
 }
 
+struct CachedTokenization {
+    Buf *source_code;
+    Tokenization tokenization;
+};
+
+// Files under the zig lib directory are imported again by every child CodeGen (compiler_rt,
+// c.zig, ...) built in the same process. Their tokens are never mutated after tokenizing, so
+// the token list is shared instead of re-tokenizing the same std source each time. The AST is
+// not shared because nodes point back to their owning import and get per-compilation scopes.
+static HashMap<Buf *, CachedTokenization *, buf_hash, buf_eql_buf> *lib_tokenization_cache = nullptr;
+
+static Buf *tokenize_source_file(CodeGen *g, Buf *resolved_path, Buf *source_code,
+        Tokenization *out_tokenization)
+{
+    bool cacheable = g->zig_lib_dir != nullptr && buf_starts_with_buf(resolved_path, g->zig_lib_dir);
+    if (cacheable) {
+        if (lib_tokenization_cache == nullptr) {
+            lib_tokenization_cache = allocate<HashMap<Buf *, CachedTokenization *, buf_hash, buf_eql_buf>>(1);
+            lib_tokenization_cache->init(64);
+        }
+        auto entry = lib_tokenization_cache->maybe_get(resolved_path);
+        if (entry != nullptr && buf_eql_buf(entry->value->source_code, source_code)) {
+            *out_tokenization = entry->value->tokenization;
+            return entry->value->source_code;
+        }
+    }
+
+    tokenize(source_code, out_tokenization);
+
+    if (cacheable && out_tokenization->err == nullptr) {
+        CachedTokenization *cached = allocate<CachedTokenization>(1);
+        cached->source_code = source_code;
+        cached->tokenization = *out_tokenization;
+        lib_tokenization_cache->put(buf_create_from_buf(resolved_path), cached);
+    }
+    return source_code;
+}
+
 ZigType *add_source_file(CodeGen *g, ZigPackage *package, Buf *resolved_path, Buf *source_code,
         SourceKind source_kind)
 {
@@ -4630,7 +4704,7 @@ ZigType *add_source_file(CodeGen *g, ZigPackage *package, Buf *resolved_path, Bu
     }
 
     Tokenization tokenization = {0};
-    tokenize(source_code, &tokenization);
+    source_code = tokenize_source_file(g, resolved_path, source_code, &tokenization);
 
     if (tokenization.err) {
         ErrorMsg *err = err_msg_create_with_line(resolved_path, tokenization.err_line, tokenization.err_column,
@@ -5875,6 +5949,145 @@ static bool scope_needs_spill(Scope *scope) {
     zig_unreachable();
 }
 
+struct BlockBreakEscape {
+    ZigList<Buf *> labels;
+    size_t loop_depth;
+    bool escapes;
+};
+
+static bool block_break_target_is_inside(BlockBreakEscape *ctx, Buf *name) {
+    if (name == nullptr)
+        return ctx->loop_depth != 0;
+    for (size_t i = 0; i < ctx->labels.length; i += 1) {
+        if (buf_eql_buf(ctx->labels.at(i), name))
+            return true;
+    }
+    return false;
+}
+
+static void block_break_escape_visit(AstNode **node_ptr, void *context);
+
+static void block_break_escape_visit_loop_body(BlockBreakEscape *ctx, Buf *name, AstNode **body) {
+    if (name != nullptr)
+        ctx->labels.append(name);
+    ctx->loop_depth += 1;
+    block_break_escape_visit(body, ctx);
+    ctx->loop_depth -= 1;
+    if (name != nullptr)
+        ctx->labels.pop();
+}
+
+static void block_break_escape_visit(AstNode **node_ptr, void *context) {
+    BlockBreakEscape *ctx = reinterpret_cast<BlockBreakEscape *>(context);
+    AstNode *node = *node_ptr;
+    if (node == nullptr || ctx->escapes)
+        return;
+    switch (node->type) {
+        case NodeTypeBreak:
+            if (node->data.break_expr.expr != nullptr &&
+                !block_break_target_is_inside(ctx, node->data.break_expr.name))
+            {
+                ctx->escapes = true;
+                return;
+            }
+            break;
+        case NodeTypeBlock:
+            if (node->data.block.name != nullptr) {
+                ctx->labels.append(node->data.block.name);
+                ast_visit_node_children(node, block_break_escape_visit, ctx);
+                ctx->labels.pop();
+                return;
+            }
+            break;
+        case NodeTypeWhileExpr:
+            // A break in the condition, continue expression, or else branch
+            // targets the enclosing loop, not this one.
+            block_break_escape_visit(&node->data.while_expr.condition, ctx);
+            block_break_escape_visit(&node->data.while_expr.continue_expr, ctx);
+            block_break_escape_visit_loop_body(ctx, node->data.while_expr.name, &node->data.while_expr.body);
+            block_break_escape_visit(&node->data.while_expr.else_node, ctx);
+            return;
+        case NodeTypeForExpr:
+            block_break_escape_visit(&node->data.for_expr.array_expr, ctx);
+            block_break_escape_visit_loop_body(ctx, node->data.for_expr.name, &node->data.for_expr.body);
+            block_break_escape_visit(&node->data.for_expr.else_node, ctx);
+            return;
+        default:
+            break;
+    }
+    ast_visit_node_children(node, block_break_escape_visit, ctx);
+}
+
+// Whether a `break` inside the block passes a value to the block itself or to
+// something outside of it. Such a value may be a pointer to a local of the
+// block rather than a copy, since aggregate loads do not copy.
+static bool block_value_may_escape(ScopeBlock *block_scope) {
+    BlockBreakEscape ctx = {};
+    ast_visit_node_children(block_scope->base.source_node, block_break_escape_visit, &ctx);
+    ctx.labels.deinit();
+    return ctx.escapes;
+}
+
+// Returns the innermost block that a variable's storage is bounded by, or
+// the function scope if it must live for the entire function.
+static Scope *frame_var_lifetime_scope(ZigFn *fn, ZigVar *var, ZigType *child_type) {
+    Scope *fn_scope = &fn->fndef_scope->base;
+    ScopeBlock *block_scope = nullptr;
+    for (Scope *scope = var->parent_scope; scope != nullptr; scope = scope->parent) {
+        if (scope->id == ScopeIdFnDef) {
+            // Variables of inlined calls belong to another function's scope tree.
+            if (scope != fn_scope || block_scope == nullptr)
+                return fn_scope;
+            if (handle_is_ptr(child_type) && block_value_may_escape(block_scope))
+                return fn_scope;
+            return &block_scope->base;
+        }
+        if (scope->id == ScopeIdBlock && block_scope == nullptr) {
+            block_scope = reinterpret_cast<ScopeBlock *>(scope);
+        }
+    }
+    return fn_scope;
+}
+
+static bool scope_is_ancestor_or_self(Scope *ancestor, Scope *scope) {
+    for (; scope != nullptr; scope = scope->parent) {
+        if (scope == ancestor)
+            return true;
+    }
+    return false;
+}
+
+struct FrameSlot {
+    ZigList<IrInstructionAllocaGen *> members;
+    size_t field_index;
+    size_t abi_size;
+    unsigned abi_align;
+};
+
+static bool frame_slot_accepts(FrameSlot *slot, IrInstructionAllocaGen *alloca) {
+    for (size_t i = 0; i < slot->members.length; i += 1) {
+        Scope *other = slot->members.at(i)->lifetime_scope;
+        if (scope_is_ancestor_or_self(other, alloca->lifetime_scope) ||
+            scope_is_ancestor_or_self(alloca->lifetime_scope, other))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int compare_frame_allocas_size_desc(const void *a, const void *b) {
+    IrInstructionAllocaGen *alloca_a = *reinterpret_cast<IrInstructionAllocaGen * const *>(a);
+    IrInstructionAllocaGen *alloca_b = *reinterpret_cast<IrInstructionAllocaGen * const *>(b);
+    size_t size_a = alloca_a->base.value.type->data.pointer.child_type->abi_size;
+    size_t size_b = alloca_b->base.value.type->data.pointer.child_type->abi_size;
+    if (size_a > size_b)
+        return -1;
+    if (size_a < size_b)
+        return 1;
+    return 0;
+}
+
 static Error resolve_async_frame(CodeGen *g, ZigType *frame_type) {
     Error err;
 
@@ -5944,6 +6157,7 @@ static Error resolve_async_frame(CodeGen *g, ZigType *frame_type) {
         frame_type->abi_size = frame_type->data.frame.locals_struct->abi_size;
         frame_type->abi_align = frame_type->data.frame.locals_struct->abi_align;
         frame_type->size_in_bits = frame_type->data.frame.locals_struct->size_in_bits;
+        frame_type->data.frame.unshared_abi_size = frame_type->abi_size;
 
         return ErrorNone;
     }
@@ -6145,9 +6359,45 @@ static Error resolve_async_frame(CodeGen *g, ZigType *frame_type) {
                 get_array_type(g, g->builtin_types.entry_usize, stack_trace_ptr_count), 0});
     }
 
+    // Variables whose lifetimes are bounded by disjoint blocks can share a frame
+    // slot. Everything else (spills, await results, the call frame) is live for
+    // the whole function as far as we can tell.
+    for (size_t alloca_i = 0; alloca_i < fn->alloca_gen_list.length; alloca_i += 1) {
+        fn->alloca_gen_list.at(alloca_i)->lifetime_scope = nullptr;
+    }
+    Scope *fn_scope = &fn->fndef_scope->base;
+    for (size_t block_i = 0; block_i < fn->analyzed_executable.basic_block_list.length; block_i += 1) {
+        IrBasicBlock *block = fn->analyzed_executable.basic_block_list.at(block_i);
+        for (size_t instr_i = 0; instr_i < block->instruction_list.length; instr_i += 1) {
+            IrInstruction *instruction = block->instruction_list.at(instr_i);
+            if (instruction->id != IrInstructionIdDeclVarGen)
+                continue;
+            IrInstructionDeclVarGen *decl_var = reinterpret_cast<IrInstructionDeclVarGen *>(instruction);
+            if (decl_var->var_ptr->id != IrInstructionIdAllocaGen)
+                continue;
+            IrInstructionAllocaGen *alloca_gen = reinterpret_cast<IrInstructionAllocaGen *>(decl_var->var_ptr);
+            ZigType *child_type = alloca_gen->base.value.type->data.pointer.child_type;
+            Scope *lifetime_scope = frame_var_lifetime_scope(fn, decl_var->var, child_type);
+            if (alloca_gen->lifetime_scope == nullptr) {
+                alloca_gen->lifetime_scope = lifetime_scope;
+            } else if (alloca_gen->lifetime_scope != lifetime_scope) {
+                alloca_gen->lifetime_scope = fn_scope;
+            }
+        }
+    }
+
+    ZigList<SrcField> unshared_fields = {};
+    for (size_t i = 0; i < fields.length; i += 1) {
+        unshared_fields.append(fields.at(i));
+    }
+    ZigList<IrInstructionAllocaGen *> frame_allocas = {};
+    ZigList<IrInstructionAllocaGen *> shareable_allocas = {};
     for (size_t alloca_i = 0; alloca_i < fn->alloca_gen_list.length; alloca_i += 1) {
         IrInstructionAllocaGen *instruction = fn->alloca_gen_list.at(alloca_i);
         instruction->field_index = SIZE_MAX;
+        instruction->slot_index = SIZE_MAX;
+        if (instruction->lifetime_scope == nullptr)
+            instruction->lifetime_scope = fn_scope;
         ZigType *ptr_type = instruction->base.value.type;
         assert(ptr_type->id == ZigTypeIdPointer);
         ZigType *child_type = ptr_type->data.pointer.child_type;
@@ -6175,10 +6425,61 @@ static Error resolve_async_frame(CodeGen *g, ZigType *frame_type) {
         } else {
             name = buf_ptr(buf_sprintf("%s.%" ZIG_PRI_usize, instruction->name_hint, alloca_i));
         }
+        unshared_fields.append({name, child_type, instruction->align});
+        frame_allocas.append(instruction);
+        if (instruction->lifetime_scope != fn_scope)
+            shareable_allocas.append(instruction);
+    }
+
+    // Assign the largest variables first, each to the first slot that has no
+    // member with an overlapping lifetime.
+    qsort(shareable_allocas.items, shareable_allocas.length, sizeof(IrInstructionAllocaGen *),
+            compare_frame_allocas_size_desc);
+    ZigList<FrameSlot> slots = {};
+    for (size_t i = 0; i < shareable_allocas.length; i += 1) {
+        IrInstructionAllocaGen *instruction = shareable_allocas.at(i);
+        ZigType *child_type = instruction->base.value.type->data.pointer.child_type;
+        size_t slot_i = 0;
+        for (; slot_i < slots.length; slot_i += 1) {
+            if (frame_slot_accepts(&slots.at(slot_i), instruction))
+                break;
+        }
+        if (slot_i == slots.length) {
+            FrameSlot *new_slot = slots.add_one();
+            *new_slot = {};
+            new_slot->field_index = SIZE_MAX;
+        }
+        FrameSlot *slot = &slots.at(slot_i);
+        slot->members.append(instruction);
+        slot->abi_size = max(slot->abi_size, child_type->abi_size);
+        slot->abi_align = max(slot->abi_align, max(instruction->align, child_type->abi_align));
+        instruction->slot_index = slot_i;
+    }
+
+    for (size_t i = 0; i < frame_allocas.length; i += 1) {
+        IrInstructionAllocaGen *instruction = frame_allocas.at(i);
+        FrameSlot *slot = (instruction->slot_index == SIZE_MAX) ? nullptr : &slots.at(instruction->slot_index);
+        if (slot != nullptr && slot->members.length > 1) {
+            if (slot->field_index == SIZE_MAX) {
+                slot->field_index = fields.length;
+                ZigType *slot_type = get_array_type(g, g->builtin_types.entry_u8, slot->abi_size);
+                const char *name = buf_ptr(buf_sprintf("@shared%" ZIG_PRI_usize, instruction->slot_index));
+                fields.append({name, slot_type, slot->abi_align});
+            }
+            instruction->field_index = slot->field_index;
+            continue;
+        }
+
         instruction->field_index = fields.length;
+        fields.append(unshared_fields.at(unshared_fields.length - frame_allocas.length + i));
+    }
 
-        fields.append({name, child_type, instruction->align});
+    for (size_t i = 0; i < slots.length; i += 1) {
+        slots.at(i).members.deinit();
     }
+    slots.deinit();
+    shareable_allocas.deinit();
+    frame_allocas.deinit();
 
 
     frame_type->data.frame.locals_struct = get_struct_type(g, buf_ptr(&frame_type->name),
@@ -6186,6 +6487,9 @@ static Error resolve_async_frame(CodeGen *g, ZigType *frame_type) {
     frame_type->abi_size = frame_type->data.frame.locals_struct->abi_size;
     frame_type->abi_align = frame_type->data.frame.locals_struct->abi_align;
     frame_type->size_in_bits = frame_type->data.frame.locals_struct->size_in_bits;
+    frame_type->data.frame.unshared_abi_size = get_src_fields_abi_size(unshared_fields.items,
+            unshared_fields.length, target_fn_align(g->zig_target));
+    unshared_fields.deinit();
 
     if (g->largest_frame_fn == nullptr || frame_type->abi_size > g->largest_frame_fn->frame_type->abi_size) {
         g->largest_frame_fn = fn;
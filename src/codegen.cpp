@@ -517,6 +517,14 @@ static LLVMValueRef make_fn_llvm_value(CodeGen *g, ZigFn *fn) {
         } else if (g->zig_target->os == OsUefi) {
             addLLVMFnAttrStr(llvm_fn, "no-stack-arg-probe", "");
         }
+        // The linker generates the machine code for ThinLTO bitcode and only knows
+        // about the CPU through these attributes.
+        if (g->thin_lto) {
+            if (g->llvm_cpu[0] != 0)
+                addLLVMFnAttrStr(llvm_fn, "target-cpu", g->llvm_cpu);
+            if (g->llvm_features[0] != 0)
+                addLLVMFnAttrStr(llvm_fn, "target-features", g->llvm_features);
+        }
     } else {
         maybe_import_dll(g, llvm_fn, linkage);
     }
@@ -590,6 +598,10 @@ static LLVMValueRef fn_llvm_value(CodeGen *g, ZigFn *fn) {
     return fn->llvm_value;
 }
 
+static bool want_line_tables_only(CodeGen *g) {
+    return g->debug_line_tables_only || g->debug_fast;
+}
+
 static ZigLLVMDIScope *get_di_scope(CodeGen *g, Scope *scope) {
     if (scope->di_scope)
         return scope->di_scope;
@@ -616,10 +628,18 @@ static ZigLLVMDIScope *get_di_scope(CodeGen *g, Scope *scope) {
             ZigLLVMDIScope *fn_di_scope = get_di_scope(g, scope->parent);
             assert(fn_di_scope != nullptr);
             assert(fn_table_entry->raw_di_type != nullptr);
+            // Line tables do not describe parameter types, so every function shares one empty
+            // signature and the type debug info never reaches the module.
+            ZigLLVMDIType *fn_di_type = fn_table_entry->raw_di_type;
+            if (want_line_tables_only(g)) {
+                if (g->empty_fn_di_type == nullptr)
+                    g->empty_fn_di_type = ZigLLVMCreateSubroutineType(g->dbuilder, nullptr, 0, 0);
+                fn_di_type = g->empty_fn_di_type;
+            }
             ZigLLVMDISubprogram *subprogram = ZigLLVMCreateFunction(g->dbuilder,
                 fn_di_scope, buf_ptr(&fn_table_entry->symbol_name), "",
                 import->data.structure.root_struct->di_file, line_number,
-                fn_table_entry->raw_di_type, is_internal_linkage,
+                fn_di_type, is_internal_linkage,
                 is_definition, scope_line, flags, is_optimized, nullptr);
 
             scope->di_scope = ZigLLVMSubprogramToScope(subprogram);
@@ -629,7 +649,8 @@ static ZigLLVMDIScope *get_di_scope(CodeGen *g, Scope *scope) {
             return scope->di_scope;
         }
         case ScopeIdDecls:
-            if (scope->parent) {
+            // Containers are types, so with line tables only, their declarations are scoped to the file.
+            if (scope->parent && !want_line_tables_only(g)) {
                 ScopeDecls *decls_scope = (ScopeDecls *)scope;
                 assert(decls_scope->container_type);
                 scope->di_scope = ZigLLVMTypeToScope(get_llvm_di_type(g, decls_scope->container_type));
@@ -856,7 +877,7 @@ static bool ir_want_fast_math(CodeGen *g, IrInstruction *instruction) {
     return false;
 }
 
-static bool ir_want_runtime_safety_scope(CodeGen *g, Scope *scope) {
+bool ir_want_runtime_safety_scope(CodeGen *g, Scope *scope) {
     // TODO memoize
     while (scope) {
         if (scope->id == ScopeIdBlock) {
@@ -1673,7 +1694,7 @@ static void gen_assign_raw(CodeGen *g, LLVMValueRef ptr, ZigType *ptr_type,
 }
 
 static void gen_var_debug_decl(CodeGen *g, ZigVar *var) {
-    if (g->strip_debug_symbols) return;
+    if (g->strip_debug_symbols || want_line_tables_only(g)) return;
     assert(var->di_loc_var != nullptr);
     AstNode *source_node = var->decl_node;
     ZigLLVMDILocation *debug_loc = ZigLLVMGetDebugLoc((unsigned)source_node->line + 1,
@@ -1983,7 +2004,7 @@ static bool iter_function_params_c_abi(CodeGen *g, ZigType *fn_type, FnWalk *fn_
     return false;
 
 var_ok:
-    if (dest_ty != nullptr && var->decl_node) {
+    if (dest_ty != nullptr && var->decl_node && !want_line_tables_only(g)) {
         // arg index + 1 because the 0 index is return value
         var->di_loc_var = ZigLLVMCreateParameterVariable(g->dbuilder, get_di_scope(g, var->parent_scope),
                 var->name, fn_walk->data.vars.import->data.structure.root_struct->di_file,
@@ -3798,7 +3819,7 @@ static void render_async_spills(CodeGen *g) {
 
         var->value_ref = LLVMBuildStructGEP(g->builder, g->cur_frame_ptr, async_var_index, var->name);
         async_var_index += 1;
-        if (var->decl_node) {
+        if (var->decl_node && !want_line_tables_only(g)) {
             var->di_loc_var = ZigLLVMCreateAutoVariable(g->dbuilder, get_di_scope(g, var->parent_scope),
                 var->name, import->data.structure.root_struct->di_file,
                 (unsigned)(var->decl_node->line + 1),
@@ -3814,9 +3835,14 @@ static void render_async_spills(CodeGen *g) {
         if (instruction->field_index == SIZE_MAX)
             continue;
 
-        size_t gen_index = frame_type->data.structure.fields[instruction->field_index].gen_index;
-        instruction->base.llvm_value = LLVMBuildStructGEP(g->builder, g->cur_frame_ptr, gen_index,
+        TypeStructField *field = &frame_type->data.structure.fields[instruction->field_index];
+        instruction->base.llvm_value = LLVMBuildStructGEP(g->builder, g->cur_frame_ptr, field->gen_index,
                 instruction->name_hint);
+        if (field->type_entry != instruction->base.value.type->data.pointer.child_type) {
+            // This field is shared with other allocas; see resolve_async_frame.
+            instruction->base.llvm_value = LLVMBuildBitCast(g->builder, instruction->base.llvm_value,
+                    get_llvm_type(g, instruction->base.value.type), "");
+        }
     }
 }
 
@@ -7148,6 +7174,168 @@ static void generate_error_name_table(CodeGen *g) {
     LLVMSetAlignment(g->err_name_table, LLVMABIAlignmentOfType(g->target_data_ref, LLVMTypeOf(err_name_table_init)));
 }
 
+// -fprofile-generate instruments every function entry with an increment of its slot in
+// __zig_profile_counters. When the program exits, start.zig appends a "<count> <symbol>" line
+// to the file named by __zig_profile_path for each function that was entered. Appending lets
+// several runs accumulate; the counts are summed when the file is read back with -fprofile-use.
+static void gen_profile_globals(CodeGen *g) {
+    LLVMTypeRef usize_type_ref = g->builtin_types.entry_usize->llvm_type;
+    LLVMTypeRef counters_type = LLVMArrayType(usize_type_ref, (unsigned)g->fn_defs.length);
+    g->profile_counters = LLVMAddGlobal(g->module, counters_type, "__zig_profile_counters");
+    LLVMSetInitializer(g->profile_counters, LLVMConstNull(counters_type));
+    LLVMSetLinkage(g->profile_counters, LLVMInternalLinkage);
+
+    Buf *names = buf_alloc();
+    for (size_t fn_i = 0; fn_i < g->fn_defs.length; fn_i += 1) {
+        buf_append_buf(names, &g->fn_defs.at(fn_i)->symbol_name);
+        buf_append_char(names, '\n');
+    }
+    LLVMValueRef names_init = LLVMConstString(buf_ptr(names), (unsigned)buf_len(names), true);
+    LLVMValueRef names_global = LLVMAddGlobal(g->module, LLVMTypeOf(names_init), "__zig_profile_names");
+    LLVMSetInitializer(names_global, names_init);
+    LLVMSetLinkage(names_global, LLVMInternalLinkage);
+    LLVMSetGlobalConstant(names_global, true);
+
+    LLVMValueRef names_len_init = LLVMConstInt(usize_type_ref, buf_len(names), false);
+    LLVMValueRef names_len_global = LLVMAddGlobal(g->module, usize_type_ref, "__zig_profile_names_len");
+    LLVMSetInitializer(names_len_global, names_len_init);
+    LLVMSetLinkage(names_len_global, LLVMInternalLinkage);
+    LLVMSetGlobalConstant(names_len_global, true);
+
+    Buf *path = buf_sprintf("%s/%s.zprof",
+            (g->profile_generate_dir == nullptr) ? "." : buf_ptr(g->profile_generate_dir),
+            buf_ptr(g->root_out_name));
+    LLVMValueRef path_init = LLVMConstString(buf_ptr(path), (unsigned)buf_len(path), false);
+    LLVMValueRef path_global = LLVMAddGlobal(g->module, LLVMTypeOf(path_init), "__zig_profile_path");
+    LLVMSetInitializer(path_global, path_init);
+    LLVMSetLinkage(path_global, LLVMInternalLinkage);
+    LLVMSetGlobalConstant(path_global, true);
+}
+
+static void gen_profile_counter_increment(CodeGen *g, size_t fn_index) {
+    LLVMTypeRef usize_type_ref = g->builtin_types.entry_usize->llvm_type;
+    LLVMValueRef indices[] = {
+        LLVMConstNull(usize_type_ref),
+        LLVMConstInt(usize_type_ref, fn_index, false),
+    };
+    LLVMValueRef counter_ptr = LLVMConstInBoundsGEP(g->profile_counters, indices, 2);
+    LLVMBuildAtomicRMW(g->builder, LLVMAtomicRMWBinOpAdd, counter_ptr, LLVMConstInt(usize_type_ref, 1, false),
+            LLVMAtomicOrderingMonotonic, g->is_single_threaded);
+}
+
+// -fdedup-fns: instantiations such as ArrayList(u32) and ArrayList(i32), or containers over
+// different pointer types, lower to the same LLVM IR once signedness and pointee types are
+// erased. Merging them here, before the optimizer, saves optimizing and emitting every copy.
+// The release pipeline's MergeFunctions pass only finds them after they have been optimized.
+static void dedup_fns(CodeGen *g) {
+    size_t fn_count = g->fn_defs.length;
+    LLVMValueRef *fns = allocate<LLVMValueRef>(fn_count);
+    size_t *kept_index = allocate<size_t>(fn_count);
+    size_t *instruction_counts = allocate<size_t>(fn_count);
+    for (size_t fn_i = 0; fn_i < fn_count; fn_i += 1) {
+        fns[fn_i] = g->fn_defs.at(fn_i)->llvm_value;
+    }
+
+    ZigLLVM_ObjectFormatType oformat = target_object_format(g->zig_target);
+    bool create_aliases = (oformat == ZigLLVM_ELF || oformat == ZigLLVM_COFF);
+    ZigLLVMMergeIdenticalFunctions(fns, fn_count, create_aliases, kept_index, instruction_counts);
+
+    for (size_t fn_i = 0; fn_i < fn_count; fn_i += 1) {
+        if (kept_index[fn_i] == SIZE_MAX)
+            continue;
+        ZigFn *fn_entry = g->fn_defs.at(fn_i);
+        fn_entry->llvm_value = fns[fn_i];
+        g->fn_merges.append({fn_entry, g->fn_defs.at(kept_index[fn_i]), instruction_counts[fn_i]});
+    }
+    deallocate(fns, fn_count);
+    deallocate(kept_index, fn_count);
+    deallocate(instruction_counts, fn_count);
+}
+
+struct ProfileEntry {
+    const char *symbol_name;
+    uint64_t count;
+};
+
+static int compare_profile_entries_desc(const void *a, const void *b) {
+    uint64_t count_a = reinterpret_cast<const ProfileEntry *>(a)->count;
+    uint64_t count_b = reinterpret_cast<const ProfileEntry *>(b)->count;
+    if (count_a > count_b)
+        return -1;
+    if (count_a < count_b)
+        return 1;
+    return 0;
+}
+
+// -fprofile-use: attach the recorded entry counts to the functions being generated. Functions
+// that the profile does not mention were never entered during the profiling runs, so they get
+// a count of zero, which is what lets LLVM move them into .text.unlikely. The entered functions
+// are also written to a symbol ordering file, hottest first, for the linker.
+static void apply_profile(CodeGen *g) {
+    Error err;
+    Buf *contents = buf_alloc();
+    if ((err = os_fetch_file_path(g->profile_use_path, contents))) {
+        fprintf(stderr, "Unable to read profile %s: %s\n", buf_ptr(g->profile_use_path), err_str(err));
+        exit(1);
+    }
+
+    HashMap<Buf *, uint64_t, buf_hash, buf_eql_buf> counts = {};
+    counts.init(g->fn_defs.length);
+    size_t line_start = 0;
+    size_t line_number = 1;
+    while (line_start < buf_len(contents)) {
+        const char *line = buf_ptr(contents) + line_start;
+        const char *line_end = (const char *)memchr(line, '\n', buf_len(contents) - line_start);
+        size_t line_len = (line_end == nullptr) ? buf_len(contents) - line_start : line_end - line;
+        line_start += line_len + 1;
+
+        const char *space = (const char *)memchr(line, ' ', line_len);
+        char *count_end;
+        uint64_t count = (space == nullptr) ? 0 : strtoull(line, &count_end, 10);
+        if (space == nullptr || count_end != space || space + 1 == line + line_len) {
+            fprintf(stderr, "%s:%zu: invalid profile line\n", buf_ptr(g->profile_use_path), line_number);
+            exit(1);
+        }
+        line_number += 1;
+
+        Buf *name = buf_create_from_mem(space + 1, line + line_len - space - 1);
+        auto entry = counts.put_unique(name, count);
+        if (entry != nullptr) {
+            entry->value += count;
+        }
+    }
+
+    LLVMValueRef *fns = allocate<LLVMValueRef>(g->fn_defs.length);
+    uint64_t *fn_counts = allocate<uint64_t>(g->fn_defs.length);
+    ZigList<ProfileEntry> entered = {};
+    for (size_t fn_i = 0; fn_i < g->fn_defs.length; fn_i += 1) {
+        ZigFn *fn_entry = g->fn_defs.at(fn_i);
+        fns[fn_i] = fn_llvm_value(g, fn_entry);
+        auto entry = counts.maybe_get(&fn_entry->symbol_name);
+        fn_counts[fn_i] = (entry == nullptr) ? 0 : entry->value;
+        if (fn_counts[fn_i] != 0) {
+            entered.append({LLVMGetValueName(fns[fn_i]), fn_counts[fn_i]});
+        }
+    }
+    ZigLLVMSetFunctionEntryCounts(g->module, fns, fn_counts, g->fn_defs.length);
+    deallocate(fns, g->fn_defs.length);
+    deallocate(fn_counts, g->fn_defs.length);
+
+    qsort(entered.items, entered.length, sizeof(ProfileEntry), compare_profile_entries_desc);
+    Buf *ordering = buf_alloc();
+    for (size_t i = 0; i < entered.length; i += 1) {
+        buf_appendf(ordering, "%s\n", entered.at(i).symbol_name);
+    }
+    g->symbol_ordering_file_path = buf_sprintf("%s" OS_SEP "%s.symbol-order", buf_ptr(g->output_dir),
+            buf_ptr(g->root_out_name));
+    if ((err = os_write_file(g->symbol_ordering_file_path, ordering))) {
+        fprintf(stderr, "Unable to write %s: %s\n", buf_ptr(g->symbol_ordering_file_path), err_str(err));
+        exit(1);
+    }
+    entered.deinit();
+    counts.deinit();
+}
+
 static void build_all_basic_blocks(CodeGen *g, ZigFn *fn) {
     IrExecutable *executable = &fn->analyzed_executable;
     assert(executable->basic_block_list.length > 0);
@@ -7170,7 +7358,7 @@ static void build_all_basic_blocks(CodeGen *g, ZigFn *fn) {
 static void gen_global_var(CodeGen *g, ZigVar *var, LLVMValueRef init_val,
     ZigType *type_entry)
 {
-    if (g->strip_debug_symbols) {
+    if (g->strip_debug_symbols || want_line_tables_only(g)) {
         return;
     }
 
@@ -7215,6 +7403,12 @@ static void do_code_gen(CodeGen *g) {
 
     generate_error_name_table(g);
 
+    // Must come before the module level variables: the extern declarations in start.zig
+    // bind to these by name.
+    if (g->profile_generate) {
+        gen_profile_globals(g);
+    }
+
     // Generate module level variables
     for (size_t i = 0; i < g->global_vars.length; i += 1) {
         TldVar *tld_var = g->global_vars.at(i);
@@ -7468,10 +7662,11 @@ static void do_code_gen(CodeGen *g) {
             }
 
             if (var->src_arg_index == SIZE_MAX) {
-                var->di_loc_var = ZigLLVMCreateAutoVariable(g->dbuilder, get_di_scope(g, var->parent_scope),
-                        var->name, import->data.structure.root_struct->di_file, (unsigned)(var->decl_node->line + 1),
-                        get_llvm_di_type(g, var->var_type), !g->strip_debug_symbols, 0);
-
+                if (!want_line_tables_only(g)) {
+                    var->di_loc_var = ZigLLVMCreateAutoVariable(g->dbuilder, get_di_scope(g, var->parent_scope),
+                            var->name, import->data.structure.root_struct->di_file, (unsigned)(var->decl_node->line + 1),
+                            get_llvm_di_type(g, var->var_type), !g->strip_debug_symbols, 0);
+                }
             } else if (is_c_abi) {
                 fn_walk_var.data.vars.var = var;
                 iter_function_params_c_abi(g, fn_table_entry->type_entry, &fn_walk_var, var->src_arg_index);
@@ -7491,7 +7686,7 @@ static void do_code_gen(CodeGen *g) {
                     gen_type = var->var_type;
                     var->value_ref = build_alloca(g, var->var_type, var->name, var->align_bytes);
                 }
-                if (var->decl_node) {
+                if (var->decl_node && !want_line_tables_only(g)) {
                     var->di_loc_var = ZigLLVMCreateParameterVariable(g->dbuilder, get_di_scope(g, var->parent_scope),
                         var->name, import->data.structure.root_struct->di_file,
                         (unsigned)(var->decl_node->line + 1),
@@ -7612,6 +7807,10 @@ static void do_code_gen(CodeGen *g) {
             walk_function_params(g, fn_table_entry->type_entry, &fn_walk_init);
         }
 
+        if (g->profile_generate && cc != CallingConventionNaked) {
+            gen_profile_counter_increment(g, fn_i);
+        }
+
         ir_render(g, fn_table_entry);
 
         stage2_progress_end(fn_prog_node);
@@ -7619,6 +7818,10 @@ static void do_code_gen(CodeGen *g) {
 
     assert(!g->errors.length);
 
+    if (g->profile_use_path != nullptr) {
+        apply_profile(g);
+    }
+
     if (buf_len(&g->global_asm) != 0) {
         LLVMSetModuleInlineAsm(g->module, buf_ptr(&g->global_asm));
     }
@@ -7631,6 +7834,10 @@ static void do_code_gen(CodeGen *g) {
 
     ZigLLVMDIBuilderFinalize(g->dbuilder);
 
+    if (g->dedup_fns) {
+        dedup_fns(g);
+    }
+
     if (g->verbose_llvm_ir) {
         fflush(stderr);
         LLVMDumpModule(g->module);
@@ -7642,53 +7849,299 @@ static void do_code_gen(CodeGen *g) {
     }
 }
 
+// LLD runs in-process, so rather than writing the object out and having the linker read it
+// straight back, it can be given the buffer. The object file still has to end up in the
+// cache directory, but nothing reads it during this build, so it is written in the background.
+static bool want_in_memory_object(CodeGen *g) {
+    // The object itself may be the build artifact.
+    if (g->out_type == OutTypeObj)
+        return false;
+    // The archive writer reads its members from disk.
+    if (g->out_type == OutTypeLib && !g->is_dynamic)
+        return false;
+    if (g->system_linker_hack && g->zig_target->os == OsMacOSX)
+        return false;
+    switch (target_object_format(g->zig_target)) {
+        case ZigLLVM_COFF:
+        case ZigLLVM_ELF:
+        case ZigLLVM_Wasm:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void write_o_file(void *context) {
+    CodeGen *g = reinterpret_cast<CodeGen *>(context);
+    FILE *f = fopen(buf_ptr(&g->o_file_output_path), "wb");
+    if (f == nullptr) {
+        g->o_file_write_err = ErrorFileSystem;
+        return;
+    }
+    size_t amt_written = fwrite(g->o_file_mem_ptr, 1, g->o_file_mem_len, f);
+    if (fclose(f) != 0 || amt_written != g->o_file_mem_len) {
+        g->o_file_write_err = ErrorFileSystem;
+    }
+}
+
+static void emit_o_file_to_linker_memory(CodeGen *g, bool is_small, const char *asm_filename,
+        const char *llvm_ir_filename, const char *bitcode_filename, const char *dwo_filename)
+{
+    char *err_msg = nullptr;
+    if (ZigLLVMTargetMachineEmitToLinkerMemory(g->target_machine, g->module, buf_ptr(&g->o_file_output_path),
+                &g->o_file_mem_ptr, &g->o_file_mem_len, &err_msg, g->build_mode == BuildModeDebug, is_small,
+                g->enable_time_report, g->thin_lto, g->debug_fast, g->call_graph_profile, asm_filename,
+                llvm_ir_filename, bitcode_filename, dwo_filename))
+    {
+        zig_panic("unable to emit object file %s: %s", buf_ptr(&g->o_file_output_path), err_msg);
+    }
+    g->o_file_write_err = ErrorNone;
+    if (os_thread_spawn(write_o_file, g, &g->o_file_write_thread) != ErrorNone) {
+        g->o_file_write_thread = nullptr;
+        write_o_file(g);
+    }
+}
+
+static void finish_o_file_write(CodeGen *g) {
+    if (g->o_file_mem_ptr == nullptr)
+        return;
+    if (g->o_file_write_thread != nullptr) {
+        os_thread_join(g->o_file_write_thread);
+        g->o_file_write_thread = nullptr;
+    }
+    ZigLLDRemoveInMemoryFile(buf_ptr(&g->o_file_output_path));
+    g->o_file_mem_ptr = nullptr;
+    g->o_file_mem_len = 0;
+    if (g->o_file_write_err != ErrorNone) {
+        fprintf(stderr, "Unable to write object file %s: %s\n", buf_ptr(&g->o_file_output_path),
+                err_str(g->o_file_write_err));
+        exit(1);
+    }
+}
+
+// Finds the function that refers to val, looking through constant expressions and
+// initializers. Returns false if more than one function or a global refers to it.
+static bool size_report_sole_user_fn(LLVMValueRef val, LLVMValueRef *user_fn, size_t depth) {
+    for (LLVMUseRef use = LLVMGetFirstUse(val); use != nullptr; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+        if (LLVMIsAInstruction(user)) {
+            LLVMValueRef fn = LLVMGetBasicBlockParent(LLVMGetInstructionParent(user));
+            if (*user_fn != nullptr && *user_fn != fn)
+                return false;
+            *user_fn = fn;
+        } else if (LLVMIsAConstant(user) && !LLVMIsAGlobalValue(user) && depth < 8) {
+            if (!size_report_sole_user_fn(user, user_fn, depth + 1))
+                return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -fsize-report: attribute the bytes of each symbol in the emitted object to the function
+// or global variable it came from. Anonymous constants do not make it into the symbol table,
+// so their sizes are taken from the module and charged to the function that uses them.
+static void collect_size_report_symbols(CodeGen *g, const char *data, size_t data_len) {
+    HashMap<Buf *, ZigFn *, buf_hash, buf_eql_buf> fns_by_name = {};
+    fns_by_name.init(g->fn_defs.length);
+    for (size_t fn_i = 0; fn_i < g->fn_defs.length; fn_i += 1) {
+        ZigFn *fn_entry = g->fn_defs.at(fn_i);
+        if (fn_entry->llvm_value == nullptr)
+            continue;
+        fns_by_name.put(buf_create_from_str(LLVMGetValueName(fn_entry->llvm_value)), fn_entry);
+    }
+    HashMap<Buf *, Tld *, buf_hash, buf_eql_buf> tlds_by_name = {};
+    tlds_by_name.init(g->global_vars.length);
+    for (size_t var_i = 0; var_i < g->global_vars.length; var_i += 1) {
+        TldVar *tld_var = g->global_vars.at(var_i);
+        LLVMValueRef value_ref = tld_var->var->value_ref;
+        if (value_ref == nullptr || !LLVMIsAGlobalVariable(value_ref))
+            continue;
+        tlds_by_name.put(buf_create_from_str(LLVMGetValueName(value_ref)), &tld_var->base);
+    }
+
+    ZigLLVMObjectSymbol *symbols;
+    size_t symbol_count;
+    ZigLLVMObjectSection *sections;
+    size_t section_count;
+    char *err_msg = nullptr;
+    if (ZigLLVMReadObjectSymbols(data, data_len, &symbols, &symbol_count, &sections, &section_count, &err_msg)) {
+        fprintf(stderr, "Warning: -fsize-report: unable to read symbols of %s: %s\n",
+                buf_ptr(&g->o_file_output_path), err_msg);
+        free(err_msg);
+        symbol_count = 0;
+        section_count = 0;
+    }
+    for (size_t i = 0; i < symbol_count; i += 1) {
+        const char *name = symbols[i].name;
+        SizeReportSymbol *report_symbol = g->size_report_symbols.add_one();
+        *report_symbol = {};
+        report_symbol->name = buf_create_from_str(name);
+        report_symbol->size = symbols[i].size;
+        report_symbol->kind = SizeReportKindOther;
+        // Mach-O and 32-bit COFF prefix C symbol names with an underscore.
+        for (size_t attempt = 0; attempt < 2; attempt += 1) {
+            Buf *key = buf_create_from_str(name);
+            if (auto entry = fns_by_name.maybe_get(key)) {
+                report_symbol->kind = SizeReportKindFn;
+                report_symbol->fn = entry->value;
+                break;
+            }
+            if (auto entry = tlds_by_name.maybe_get(key)) {
+                report_symbol->kind = SizeReportKindVar;
+                report_symbol->tld = entry->value;
+                break;
+            }
+            if (name[0] != '_')
+                break;
+            name += 1;
+        }
+        free((void *)symbols[i].name);
+    }
+    for (size_t i = 0; i < section_count; i += 1) {
+        free((void *)sections[i].name);
+    }
+    if (err_msg == nullptr) {
+        free(symbols);
+        free(sections);
+    }
+
+    for (LLVMValueRef global = LLVMGetFirstGlobal(g->module); global != nullptr;
+            global = LLVMGetNextGlobal(global))
+    {
+        if (LLVMIsDeclaration(global))
+            continue;
+        const char *name = LLVMGetValueName(global);
+        if (name[0] != 0 && LLVMGetLinkage(global) != LLVMPrivateLinkage)
+            continue;
+        SizeReportSymbol *report_symbol = g->size_report_symbols.add_one();
+        *report_symbol = {};
+        report_symbol->name = buf_create_from_str(name);
+        report_symbol->size = LLVMABISizeOfType(g->target_data_ref, LLVMGlobalGetValueType(global));
+        report_symbol->kind = SizeReportKindConst;
+        LLVMValueRef user_fn = nullptr;
+        if (size_report_sole_user_fn(global, &user_fn, 0) && user_fn != nullptr) {
+            if (auto entry = fns_by_name.maybe_get(buf_create_from_str(LLVMGetValueName(user_fn)))) {
+                report_symbol->fn = entry->value;
+            }
+        }
+    }
+
+    fns_by_name.deinit();
+    tlds_by_name.deinit();
+}
+
+// -fsize-report: record the section sizes of the final artifact, after linking.
+static void collect_size_report_sections(CodeGen *g) {
+    Error err;
+    Buf *contents = buf_alloc();
+    if ((err = os_fetch_file_path(&g->output_file_path, contents))) {
+        fprintf(stderr, "Warning: -fsize-report: unable to read %s: %s\n",
+                buf_ptr(&g->output_file_path), err_str(err));
+        return;
+    }
+    ZigLLVMObjectSymbol *symbols;
+    size_t symbol_count;
+    ZigLLVMObjectSection *sections;
+    size_t section_count;
+    char *err_msg = nullptr;
+    if (ZigLLVMReadObjectSymbols(buf_ptr(contents), buf_len(contents), &symbols, &symbol_count,
+                &sections, &section_count, &err_msg))
+    {
+        fprintf(stderr, "Warning: -fsize-report: unable to read sections of %s: %s\n",
+                buf_ptr(&g->output_file_path), err_msg);
+        free(err_msg);
+        buf_destroy(contents);
+        return;
+    }
+    for (size_t i = 0; i < section_count; i += 1) {
+        g->size_report_sections.append({buf_create_from_str(sections[i].name), sections[i].size,
+                sections[i].kind});
+        free((void *)sections[i].name);
+    }
+    for (size_t i = 0; i < symbol_count; i += 1) {
+        free((void *)symbols[i].name);
+    }
+    free(symbols);
+    free(sections);
+    buf_destroy(contents);
+}
+
 static void zig_llvm_emit_output(CodeGen *g) {
     bool is_small = g->build_mode == BuildModeSmallRelease;
 
     Buf *output_path = &g->o_file_output_path;
-    char *err_msg = nullptr;
+    const char *asm_filename = nullptr;
+    const char *bin_filename = nullptr;
+    const char *llvm_ir_filename = nullptr;
+    const char *bitcode_filename = nullptr;
     switch (g->emit_file_type) {
         case EmitFileTypeBinary:
-            if (g->disable_bin_generation)
-                return;
-            if (ZigLLVMTargetMachineEmitToFile(g->target_machine, g->module, buf_ptr(output_path),
-                        ZigLLVM_EmitBinary, &err_msg, g->build_mode == BuildModeDebug, is_small,
-                        g->enable_time_report))
-            {
-                zig_panic("unable to write object file %s: %s", buf_ptr(output_path), err_msg);
-            }
-            validate_inline_fns(g);
-            g->link_objects.append(output_path);
-            if (g->bundle_compiler_rt && (g->out_type == OutTypeObj ||
-                (g->out_type == OutTypeLib && !g->is_dynamic)))
-            {
-                zig_link_add_compiler_rt(g, g->sub_progress_node);
-            }
+            if (!g->disable_bin_generation)
+                bin_filename = buf_ptr(output_path);
             break;
-
         case EmitFileTypeAssembly:
-            if (ZigLLVMTargetMachineEmitToFile(g->target_machine, g->module, buf_ptr(output_path),
-                        ZigLLVM_EmitAssembly, &err_msg, g->build_mode == BuildModeDebug, is_small,
-                        g->enable_time_report))
-            {
-                zig_panic("unable to write assembly file %s: %s", buf_ptr(output_path), err_msg);
-            }
-            validate_inline_fns(g);
+            asm_filename = buf_ptr(output_path);
             break;
-
         case EmitFileTypeLLVMIr:
-            if (ZigLLVMTargetMachineEmitToFile(g->target_machine, g->module, buf_ptr(output_path),
-                        ZigLLVM_EmitLLVMIr, &err_msg, g->build_mode == BuildModeDebug, is_small,
-                        g->enable_time_report))
-            {
-                zig_panic("unable to write llvm-ir file %s: %s", buf_ptr(output_path), err_msg);
-            }
-            validate_inline_fns(g);
+            llvm_ir_filename = buf_ptr(output_path);
             break;
-
         default:
             zig_unreachable();
     }
+    if (g->emit_asm && asm_filename == nullptr)
+        asm_filename = buf_ptr(&g->asm_output_path);
+    if (g->emit_llvm_ir && llvm_ir_filename == nullptr)
+        llvm_ir_filename = buf_ptr(&g->llvm_ir_output_path);
+    if (g->emit_llvm_bc)
+        bitcode_filename = buf_ptr(&g->llvm_bc_output_path);
+    const char *dwo_filename = nullptr;
+    if (bin_filename != nullptr && g->debug_split_dwarf && !g->strip_debug_symbols)
+        dwo_filename = buf_ptr(&g->dwo_output_path);
+
+    if (asm_filename == nullptr && bin_filename == nullptr && llvm_ir_filename == nullptr &&
+        bitcode_filename == nullptr)
+    {
+        return;
+    }
+
+    char *err_msg = nullptr;
+    if (bin_filename != nullptr && want_in_memory_object(g)) {
+        emit_o_file_to_linker_memory(g, is_small, asm_filename, llvm_ir_filename, bitcode_filename,
+                dwo_filename);
+    } else if (ZigLLVMTargetMachineEmitToFile(g->target_machine, g->module, &err_msg,
+                g->build_mode == BuildModeDebug, is_small, g->enable_time_report, g->thin_lto,
+                g->debug_fast, g->call_graph_profile, asm_filename, bin_filename, llvm_ir_filename,
+                bitcode_filename, dwo_filename))
+    {
+        zig_panic("unable to write %s: %s", buf_ptr(output_path), err_msg);
+    }
+    validate_inline_fns(g);
+
+    if (bin_filename != nullptr && g->enable_size_report) {
+        if (g->o_file_mem_ptr != nullptr) {
+            collect_size_report_symbols(g, g->o_file_mem_ptr, g->o_file_mem_len);
+        } else {
+            Buf *contents = buf_alloc();
+            Error err;
+            if ((err = os_fetch_file_path(output_path, contents))) {
+                fprintf(stderr, "Unable to read %s: %s\n", buf_ptr(output_path), err_str(err));
+                exit(1);
+            }
+            collect_size_report_symbols(g, buf_ptr(contents), buf_len(contents));
+            buf_destroy(contents);
+        }
+    }
+
+    if (bin_filename != nullptr) {
+        g->link_objects.append(output_path);
+        if (g->bundle_compiler_rt && (g->out_type == OutTypeObj ||
+            (g->out_type == OutTypeLib && !g->is_dynamic)))
+        {
+            zig_link_add_compiler_rt(g, g->sub_progress_node);
+        }
+    }
 }
 
 struct CIntTypeInfo {
@@ -8128,7 +8581,94 @@ static bool detect_err_ret_tracing(CodeGen *g) {
         g->build_mode != BuildModeSmallRelease;
 }
 
+// Whether a feature list entry after `rest` (the comma ending the current entry, or null)
+// mentions the feature `name`.
+static bool cpu_feature_overridden(const char *rest, const char *name, size_t name_len) {
+    while (rest != nullptr) {
+        const char *entry = rest + 1;
+        rest = strchr(entry, ',');
+        size_t len = (rest == nullptr) ? strlen(entry) : (size_t)(rest - entry);
+        if (len == name_len + 1 && memcmp(entry + 1, name, name_len) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Picks the CPU model and feature string handed to LLVM. -mcpu replaces the default model
+// (including the host CPU of native builds) and -mattr features are applied on top of the
+// defaults, so a later "-feat" can switch off a feature the model implies.
+static void resolve_target_cpu(CodeGen *g) {
+    if (g->llvm_cpu != nullptr)
+        return;
+
+    const char *target_specific_cpu_args;
+    const char *target_specific_features;
+    if (g->zig_target->is_native) {
+        // LLVM creates invalid binaries on Windows sometimes.
+        // See https://github.com/ziglang/zig/issues/508
+        // As a workaround we do not use target native features on Windows.
+        if (g->zig_target->os == OsWindows || g->zig_target->os == OsUefi) {
+            target_specific_cpu_args = "";
+            target_specific_features = "";
+        } else {
+            target_specific_cpu_args = ZigLLVMGetHostCPUName();
+            target_specific_features = ZigLLVMGetNativeFeatures();
+        }
+    } else if (target_is_riscv(g->zig_target)) {
+        // TODO https://github.com/ziglang/zig/issues/2883
+        // Be aware of https://github.com/ziglang/zig/issues/3275
+        target_specific_cpu_args = "";
+        target_specific_features = riscv_default_features;
+    } else if (g->zig_target->arch == ZigLLVM_x86) {
+        // This is because we're really targeting i686 rather than i386.
+        // It's pretty much impossible to use many of the language features
+        // such as fp16 if you stick use the x87 only. This is also what clang
+        // uses as base cpu.
+        // TODO https://github.com/ziglang/zig/issues/2883
+        target_specific_cpu_args = "pentium4";
+        target_specific_features = (g->zig_target->os == OsFreestanding) ? "-sse": "";
+    } else {
+        target_specific_cpu_args = "";
+        target_specific_features = "";
+    }
+
+    if (g->mcpu != nullptr) {
+        target_specific_cpu_args = buf_ptr(g->mcpu);
+        if (g->zig_target->is_native)
+            target_specific_features = "";
+    }
+    if (g->mattr != nullptr) {
+        if (target_specific_features[0] == 0) {
+            target_specific_features = buf_ptr(g->mattr);
+        } else {
+            target_specific_features = buf_ptr(buf_sprintf("%s,%s", target_specific_features,
+                        buf_ptr(g->mattr)));
+        }
+    }
+
+    if (g->mcpu != nullptr || g->mattr != nullptr) {
+        LLVMTargetRef target_ref;
+        char *err_msg = nullptr;
+        if (LLVMGetTargetFromTriple(buf_ptr(&g->llvm_triple_str), &target_ref, &err_msg)) {
+            fprintf(stderr, "Unable to find LLVM target '%s': %s\n", buf_ptr(&g->llvm_triple_str), err_msg);
+            exit(1);
+        }
+        if (ZigLLVMValidateCPUAndFeatures(target_ref, buf_ptr(&g->llvm_triple_str),
+                    (g->mcpu != nullptr) ? buf_ptr(g->mcpu) : "",
+                    (g->mattr != nullptr) ? buf_ptr(g->mattr) : "", &err_msg))
+        {
+            fprintf(stderr, "Invalid CPU selection for target '%s': %s\n", buf_ptr(&g->llvm_triple_str),
+                    err_msg);
+            exit(1);
+        }
+    }
+
+    g->llvm_cpu = target_specific_cpu_args;
+    g->llvm_features = target_specific_features;
+}
+
 Buf *codegen_generate_builtin_source(CodeGen *g) {
+    resolve_target_cpu(g);
     g->have_dynamic_link = detect_dynamic_link(g);
     g->have_pic = detect_pic(g);
     g->have_stack_probing = detect_stack_probing(g);
@@ -8270,6 +8810,26 @@ Buf *codegen_generate_builtin_source(CodeGen *g) {
     buf_appendf(contents, "pub const valgrind_support = %s;\n", bool_to_str(want_valgrind_support(g)));
     buf_appendf(contents, "pub const position_independent_code = %s;\n", bool_to_str(g->have_pic));
     buf_appendf(contents, "pub const strip_debug_info = %s;\n", bool_to_str(g->strip_debug_symbols));
+    buf_appendf(contents, "pub const profile_generate = %s;\n", bool_to_str(g->profile_generate));
+    buf_appendf(contents, "pub const cpu: []const u8 = \"%s\";\n", g->llvm_cpu);
+    {
+        buf_appendf(contents, "pub const cpu_features = [_][]const u8{");
+        bool first = true;
+        const char *p = g->llvm_features;
+        while (*p != 0) {
+            const char *end = strchr(p, ',');
+            size_t len = (end == nullptr) ? strlen(p) : (size_t)(end - p);
+            // Later entries override earlier ones, so only features still enabled at the end are listed.
+            if (len > 1 && p[0] == '+' && !cpu_feature_overridden(end, p + 1, len - 1)) {
+                buf_appendf(contents, "%s\"%.*s\"", first ? "" : ", ", (int)(len - 1), p + 1);
+                first = false;
+            }
+            if (end == nullptr)
+                break;
+            p = end + 1;
+        }
+        buf_appendf(contents, "};\n");
+    }
 
     {
         TargetSubsystem detected_subsystem = detect_subsystem(g);
@@ -8331,6 +8891,9 @@ static Error define_builtin_compile_vars(CodeGen *g) {
     cache_bool(&cache_hash, g->have_err_ret_tracing);
     cache_bool(&cache_hash, g->libc_link_lib != nullptr);
     cache_bool(&cache_hash, g->valgrind_support);
+    cache_bool(&cache_hash, g->profile_generate);
+    cache_str(&cache_hash, g->llvm_cpu);
+    cache_str(&cache_hash, g->llvm_features);
     cache_int(&cache_hash, detect_subsystem(g));
 
     Buf digest = BUF_INIT;
@@ -8396,6 +8959,34 @@ static Error define_builtin_compile_vars(CodeGen *g) {
     return ErrorNone;
 }
 
+// Creating a target machine parses the CPU and feature strings and builds the subtarget tables,
+// which is repeated for every child CodeGen (compiler_rt, c.zig, ...) built in this process.
+// All CodeGens already share the global LLVM context, so target machines with identical
+// configuration are shared as well. Per-emission options are set by each emit call.
+static HashMap<Buf *, LLVMTargetMachineRef, buf_hash, buf_eql_buf> *target_machine_cache = nullptr;
+
+static LLVMTargetMachineRef get_target_machine(CodeGen *g, LLVMTargetRef target_ref,
+        LLVMCodeGenOptLevel opt_level, LLVMRelocMode reloc_mode, bool function_sections)
+{
+    Buf *key = buf_sprintf("%s|%s|%s|%d|%d|%d", buf_ptr(&g->llvm_triple_str), g->llvm_cpu, g->llvm_features,
+            (int)opt_level, (int)reloc_mode, (int)function_sections);
+
+    if (target_machine_cache == nullptr) {
+        target_machine_cache = allocate<HashMap<Buf *, LLVMTargetMachineRef, buf_hash, buf_eql_buf>>(1);
+        target_machine_cache->init(4);
+    }
+    auto entry = target_machine_cache->maybe_get(key);
+    if (entry != nullptr) {
+        buf_destroy(key);
+        return entry->value;
+    }
+
+    LLVMTargetMachineRef target_machine = ZigLLVMCreateTargetMachine(target_ref, buf_ptr(&g->llvm_triple_str),
+            g->llvm_cpu, g->llvm_features, opt_level, reloc_mode, LLVMCodeModelDefault, function_sections);
+    target_machine_cache->put(key, target_machine);
+    return target_machine;
+}
+
 static void init(CodeGen *g) {
     if (g->module)
         return;
@@ -8445,40 +9036,9 @@ static void init(CodeGen *g) {
         reloc_mode = LLVMRelocStatic;
     }
 
-    const char *target_specific_cpu_args;
-    const char *target_specific_features;
-    if (g->zig_target->is_native) {
-        // LLVM creates invalid binaries on Windows sometimes.
-        // See https://github.com/ziglang/zig/issues/508
-        // As a workaround we do not use target native features on Windows.
-        if (g->zig_target->os == OsWindows || g->zig_target->os == OsUefi) {
-            target_specific_cpu_args = "";
-            target_specific_features = "";
-        } else {
-            target_specific_cpu_args = ZigLLVMGetHostCPUName();
-            target_specific_features = ZigLLVMGetNativeFeatures();
-        }
-    } else if (target_is_riscv(g->zig_target)) {
-        // TODO https://github.com/ziglang/zig/issues/2883
-        // Be aware of https://github.com/ziglang/zig/issues/3275
-        target_specific_cpu_args = "";
-        target_specific_features = riscv_default_features;
-    } else if (g->zig_target->arch == ZigLLVM_x86) {
-        // This is because we're really targeting i686 rather than i386.
-        // It's pretty much impossible to use many of the language features
-        // such as fp16 if you stick use the x87 only. This is also what clang
-        // uses as base cpu.
-        // TODO https://github.com/ziglang/zig/issues/2883
-        target_specific_cpu_args = "pentium4";
-        target_specific_features = (g->zig_target->os == OsFreestanding) ? "-sse": "";
-    } else {
-        target_specific_cpu_args = "";
-        target_specific_features = "";
-    }
-
-    g->target_machine = ZigLLVMCreateTargetMachine(target_ref, buf_ptr(&g->llvm_triple_str),
-            target_specific_cpu_args, target_specific_features, opt_level, reloc_mode,
-            LLVMCodeModelDefault, g->function_sections);
+    resolve_target_cpu(g);
+    g->target_machine = get_target_machine(g, target_ref, opt_level, reloc_mode,
+            g->function_sections || g->profile_use_path != nullptr);
 
     g->target_data_ref = LLVMCreateTargetDataLayout(g->target_machine);
 
@@ -8514,7 +9074,7 @@ static void init(CodeGen *g) {
             compile_unit_dir);
     g->compile_unit = ZigLLVMCreateCompileUnit(g->dbuilder, ZigLLVMLang_DW_LANG_C99(),
             compile_unit_file, buf_ptr(producer), is_optimized, flags, runtime_version,
-            "", 0, !g->strip_debug_symbols);
+            "", 0, !g->strip_debug_symbols, want_line_tables_only(g));
 
     // This is for debug stuff that doesn't have a real file.
     g->dummy_di_file = nullptr;
@@ -8722,6 +9282,14 @@ void add_cc_args(CodeGen *g, ZigList<const char *> &args, const char *out_dep_pa
         args.append("-ffunction-sections");
     }
 
+    // Address-significance tables tell the linker which functions may be
+    // folded by --icf=safe.
+    args.append("-faddrsig");
+
+    if (g->thin_lto && !translate_c) {
+        args.append("-flto=thin");
+    }
+
     if (translate_c) {
         // this gives us access to preprocessing entities, presumably at
         // the cost of performance
@@ -8760,7 +9328,7 @@ void add_cc_args(CodeGen *g, ZigList<const char *> &args, const char *out_dep_pa
     }
 
     if (g->zig_target->is_native) {
-        if (target_supports_clang_march_native(g->zig_target)) {
+        if (g->mcpu == nullptr && target_supports_clang_march_native(g->zig_target)) {
             args.append("-march=native");
         }
     } else {
@@ -8782,6 +9350,24 @@ void add_cc_args(CodeGen *g, ZigList<const char *> &args, const char *out_dep_pa
             args.append("-sse");
         }
     }
+    if (g->mcpu != nullptr) {
+        args.append("-Xclang");
+        args.append("-target-cpu");
+        args.append("-Xclang");
+        args.append(buf_ptr(g->mcpu));
+    }
+    if (g->mattr != nullptr) {
+        // cc1 takes one feature per -target-feature, so "+avx2,-sse4a" must be split.
+        SplitIterator it = memSplit(buf_to_slice(g->mattr), str(","));
+        for (;;) {
+            Optional<Slice<uint8_t>> opt_feature = SplitIterator_next(&it);
+            if (!opt_feature.is_some) break;
+            args.append("-Xclang");
+            args.append("-target-feature");
+            args.append("-Xclang");
+            args.append(buf_ptr(buf_create_from_slice(opt_feature.value)));
+        }
+    }
     if (g->zig_target->os == OsFreestanding) {
         args.append("-ffreestanding");
     }
@@ -8793,7 +9379,10 @@ void add_cc_args(CodeGen *g, ZigList<const char *> &args, const char *out_dep_pa
     }
 
     if (!g->strip_debug_symbols) {
-        args.append("-g");
+        args.append(want_line_tables_only(g) ? "-gline-tables-only" : "-g");
+        if (target_object_format(g->zig_target) == ZigLLVM_COFF) {
+            args.append("-gcodeview-ghash");
+        }
     }
 
     if (codegen_have_frame_pointer(g)) {
@@ -9084,47 +9673,45 @@ static void gen_root_source(CodeGen *g) {
     assert(g->root_out_name);
     assert(g->out_type != OutTypeUnknown);
 
-    if (!g->is_dummy_so) {
-        // Zig has lazy top level definitions. Here we semantically analyze the panic function.
-        Buf *import_target_path;
-        Buf full_path = BUF_INIT;
-        ZigType *std_import;
-        if ((err = analyze_import(g, g->root_import, buf_create_from_str("std"), &std_import,
-            &import_target_path, &full_path)))
-        {
-            if (err == ErrorFileNotFound) {
-                fprintf(stderr, "unable to find '%s'", buf_ptr(import_target_path));
-            } else {
-                fprintf(stderr, "unable to open '%s': %s\n", buf_ptr(&full_path), err_str(err));
-            }
-            exit(1);
+    // Zig has lazy top level definitions. Here we semantically analyze the panic function.
+    Buf *import_target_path;
+    Buf full_path = BUF_INIT;
+    ZigType *std_import;
+    if ((err = analyze_import(g, g->root_import, buf_create_from_str("std"), &std_import,
+        &import_target_path, &full_path)))
+    {
+        if (err == ErrorFileNotFound) {
+            fprintf(stderr, "unable to find '%s'", buf_ptr(import_target_path));
+        } else {
+            fprintf(stderr, "unable to open '%s': %s\n", buf_ptr(&full_path), err_str(err));
         }
-
-        Tld *builtin_tld = find_decl(g, &get_container_scope(std_import)->base,
-                buf_create_from_str("builtin"));
-        assert(builtin_tld != nullptr);
-        resolve_top_level_decl(g, builtin_tld, nullptr, false);
-        report_errors_and_maybe_exit(g);
-        assert(builtin_tld->id == TldIdVar);
-        TldVar *builtin_tld_var = (TldVar*)builtin_tld;
-        ConstExprValue *builtin_val = builtin_tld_var->var->const_value;
-        assert(builtin_val->type->id == ZigTypeIdMetaType);
-        ZigType *builtin_type = builtin_val->data.x_type;
-
-        Tld *panic_tld = find_decl(g, &get_container_scope(builtin_type)->base,
-                buf_create_from_str("panic"));
-        assert(panic_tld != nullptr);
-        resolve_top_level_decl(g, panic_tld, nullptr, false);
-        report_errors_and_maybe_exit(g);
-        assert(panic_tld->id == TldIdVar);
-        TldVar *panic_tld_var = (TldVar*)panic_tld;
-        ConstExprValue *panic_fn_val = panic_tld_var->var->const_value;
-        assert(panic_fn_val->type->id == ZigTypeIdFn);
-        assert(panic_fn_val->data.x_ptr.special == ConstPtrSpecialFunction);
-        g->panic_fn = panic_fn_val->data.x_ptr.data.fn.fn_entry;
-        assert(g->panic_fn != nullptr);
+        exit(1);
     }
 
+    Tld *builtin_tld = find_decl(g, &get_container_scope(std_import)->base,
+            buf_create_from_str("builtin"));
+    assert(builtin_tld != nullptr);
+    resolve_top_level_decl(g, builtin_tld, nullptr, false);
+    report_errors_and_maybe_exit(g);
+    assert(builtin_tld->id == TldIdVar);
+    TldVar *builtin_tld_var = (TldVar*)builtin_tld;
+    ConstExprValue *builtin_val = builtin_tld_var->var->const_value;
+    assert(builtin_val->type->id == ZigTypeIdMetaType);
+    ZigType *builtin_type = builtin_val->data.x_type;
+
+    Tld *panic_tld = find_decl(g, &get_container_scope(builtin_type)->base,
+            buf_create_from_str("panic"));
+    assert(panic_tld != nullptr);
+    resolve_top_level_decl(g, panic_tld, nullptr, false);
+    report_errors_and_maybe_exit(g);
+    assert(panic_tld->id == TldIdVar);
+    TldVar *panic_tld_var = (TldVar*)panic_tld;
+    ConstExprValue *panic_fn_val = panic_tld_var->var->const_value;
+    assert(panic_fn_val->type->id == ZigTypeIdFn);
+    assert(panic_fn_val->data.x_ptr.special == ConstPtrSpecialFunction);
+    g->panic_fn = panic_fn_val->data.x_ptr.data.fn.fn_entry;
+    assert(g->panic_fn != nullptr);
+
 
     if (!g->error_during_imports) {
         semantic_analyze(g);
@@ -9210,6 +9797,11 @@ Error create_c_object_cache(CodeGen *g, CacheHash **out_cache_hash, bool verbose
     cache_bool(cache_hash, g->have_pic);
     cache_bool(cache_hash, want_valgrind_support(g));
     cache_bool(cache_hash, g->function_sections);
+    cache_bool(cache_hash, g->thin_lto);
+    cache_bool(cache_hash, g->debug_fast);
+    cache_bool(cache_hash, g->debug_line_tables_only);
+    cache_buf_opt(cache_hash, g->mcpu);
+    cache_buf_opt(cache_hash, g->mattr);
     for (size_t arg_i = 0; arg_i < g->clang_argv_len; arg_i += 1) {
         cache_str(cache_hash, g->clang_argv[arg_i]);
     }
@@ -9218,32 +9810,52 @@ Error create_c_object_cache(CodeGen *g, CacheHash **out_cache_hash, bool verbose
     return ErrorNone;
 }
 
-// returns true if it was a cache miss
-static void gen_c_object(CodeGen *g, Buf *self_exe_path, CFile *c_file) {
-    Error err;
+struct CObjectJob {
+    CFile *c_file;
+    Buf *c_source_file;
+    Buf *final_o_basename;
+    Stage2ProgressNode *prog_node;
+    CacheHash *cache_hash;
+    Buf digest;
 
-    Buf *artifact_dir;
-    Buf *o_final_path;
+    // Only used on a cache miss.
+    Buf *out_obj_path;
+    Buf *out_dep_path;
+    ZigList<const char *> args;
+    int result;
+};
 
-    Buf *o_dir = buf_sprintf("%s" OS_SEP CACHE_OUT_SUBDIR, buf_ptr(g->cache_dir));
+extern "C" void ZigClang_cc_in_process(const char ***argvs, const size_t *argcs, int *out_results,
+        size_t count, size_t thread_count);
+
+// Matches ZigClangInProcessCrashed in zig_clang_driver.cpp. Also returned for
+// command lines whose -cc1 jobs cannot run on a worker thread.
+static const int c_object_in_process_crashed = -2;
 
-    Buf *c_source_file = buf_create_from_str(c_file->source_path);
+// Checks the cache and, on a miss, prepares the `zig cc` command line.
+// Returns true if it was a cache miss.
+static bool gen_c_object_prepare(CodeGen *g, Buf *self_exe_path, CObjectJob *job) {
+    Error err;
+
+    CFile *c_file = job->c_file;
+    job->c_source_file = buf_create_from_str(c_file->source_path);
     Buf *c_source_basename = buf_alloc();
-    os_path_split(c_source_file, nullptr, c_source_basename);
+    os_path_split(job->c_source_file, nullptr, c_source_basename);
 
-    Stage2ProgressNode *child_prog_node = stage2_progress_start(g->sub_progress_node, buf_ptr(c_source_basename),
+    job->prog_node = stage2_progress_start(g->sub_progress_node, buf_ptr(c_source_basename),
             buf_len(c_source_basename), 0);
 
-    Buf *final_o_basename = buf_alloc();
-    os_path_extname(c_source_basename, final_o_basename, nullptr);
-    buf_append_str(final_o_basename, target_o_file_ext(g->zig_target));
+    job->final_o_basename = buf_alloc();
+    os_path_extname(c_source_basename, job->final_o_basename, nullptr);
+    buf_append_str(job->final_o_basename, target_o_file_ext(g->zig_target));
 
     CacheHash *cache_hash;
     if ((err = create_c_object_cache(g, &cache_hash, true))) {
         // Already printed error; verbose = true
         exit(1);
     }
-    cache_file(cache_hash, c_source_file);
+    job->cache_hash = cache_hash;
+    cache_file(cache_hash, job->c_source_file);
 
     // Note: not directory args, just args that always have a file next
     static const char *file_args[] = {
@@ -9260,9 +9872,8 @@ static void gen_c_object(CodeGen *g, Buf *self_exe_path, CFile *c_file) {
         }
     }
 
-    Buf digest = BUF_INIT;
-    buf_resize(&digest, 0);
-    if ((err = cache_hit(cache_hash, &digest))) {
+    buf_resize(&job->digest, 0);
+    if ((err = cache_hit(cache_hash, &job->digest))) {
         if (err != ErrorInvalidFormat) {
             if (err == ErrorCacheUnavailable) {
                 // already printed error
@@ -9272,46 +9883,109 @@ static void gen_c_object(CodeGen *g, Buf *self_exe_path, CFile *c_file) {
             exit(1);
         }
     }
-    bool is_cache_miss = (buf_len(&digest) == 0);
-    if (is_cache_miss) {
-        // we can't know the digest until we do the C compiler invocation, so we
-        // need a tmp filename.
-        Buf *out_obj_path = buf_alloc();
-        if ((err = get_tmp_filename(g, out_obj_path, final_o_basename))) {
-            fprintf(stderr, "unable to create tmp dir: %s\n", err_str(err));
-            exit(1);
-        }
+    if (buf_len(&job->digest) != 0)
+        return false;
 
-        Termination term;
-        ZigList<const char *> args = {};
-        args.append(buf_ptr(self_exe_path));
-        args.append("cc");
+    // we can't know the digest until we do the C compiler invocation, so we
+    // need a tmp filename.
+    job->out_obj_path = buf_alloc();
+    if ((err = get_tmp_filename(g, job->out_obj_path, job->final_o_basename))) {
+        fprintf(stderr, "unable to create tmp dir: %s\n", err_str(err));
+        exit(1);
+    }
+
+    job->args.append(buf_ptr(self_exe_path));
+    job->args.append("cc");
+
+    job->out_dep_path = buf_sprintf("%s.d", buf_ptr(job->out_obj_path));
+    add_cc_args(g, job->args, buf_ptr(job->out_dep_path), false);
 
-        Buf *out_dep_path = buf_sprintf("%s.d", buf_ptr(out_obj_path));
-        add_cc_args(g, args, buf_ptr(out_dep_path), false);
+    job->args.append("-o");
+    job->args.append(buf_ptr(job->out_obj_path));
 
-        args.append("-o");
-        args.append(buf_ptr(out_obj_path));
+    job->args.append("-c");
+    job->args.append(buf_ptr(job->c_source_file));
 
-        args.append("-c");
-        args.append(buf_ptr(c_source_file));
+    for (size_t arg_i = 0; arg_i < c_file->args.length; arg_i += 1) {
+        job->args.append(c_file->args.at(arg_i));
+    }
 
-        for (size_t arg_i = 0; arg_i < c_file->args.length; arg_i += 1) {
-            args.append(c_file->args.at(arg_i));
+    if (g->verbose_cc) {
+        print_zig_cc_cmd(&job->args);
+    }
+    return true;
+}
+
+// Whether the clang driver can run for this command line inside this process.
+// -### and -v print the jobs instead of, or in addition to, running them. Options
+// which mutate LLVM's process-wide state are found by ZigClang_cc_in_process in
+// the -cc1 jobs themselves, since the driver adds some of them on its own.
+static bool c_object_can_compile_in_process(CObjectJob *job) {
+    for (size_t arg_i = 0; arg_i < job->args.length; arg_i += 1) {
+        const char *arg = job->args.at(arg_i);
+        if (strcmp(arg, "-###") == 0 || strcmp(arg, "-v") == 0) {
+            return false;
         }
+    }
+    return true;
+}
 
-        if (g->verbose_cc) {
-            print_zig_cc_cmd(&args);
+static void gen_c_object_run_misses(CodeGen *g, ZigList<CObjectJob *> &misses) {
+    ZigList<CObjectJob *> in_process = {};
+    for (size_t i = 0; i < misses.length; i += 1) {
+        CObjectJob *job = misses.at(i);
+        job->result = c_object_in_process_crashed;
+        if (c_object_can_compile_in_process(job)) {
+            in_process.append(job);
         }
-        os_spawn_process(args, &term);
-        if (term.how != TerminationIdClean || term.code != 0) {
+    }
+
+    if (in_process.length != 0) {
+        const char ***argvs = allocate<const char **>(in_process.length);
+        size_t *argcs = allocate<size_t>(in_process.length);
+        int *results = allocate<int>(in_process.length);
+        for (size_t i = 0; i < in_process.length; i += 1) {
+            argvs[i] = in_process.at(i)->args.items;
+            argcs[i] = in_process.at(i)->args.length;
+        }
+        ZigClang_cc_in_process(argvs, argcs, results, in_process.length, os_cpu_count());
+        for (size_t i = 0; i < in_process.length; i += 1) {
+            in_process.at(i)->result = results[i];
+        }
+        deallocate(results, in_process.length);
+        deallocate(argcs, in_process.length);
+        deallocate(argvs, in_process.length);
+        in_process.deinit();
+    }
+
+    // Whatever could not run in-process, or crashed doing so, gets its own `zig cc`
+    // process, which also gives clang the chance to produce crash diagnostics.
+    for (size_t i = 0; i < misses.length; i += 1) {
+        CObjectJob *job = misses.at(i);
+        if (job->result != c_object_in_process_crashed)
+            continue;
+        Termination term;
+        os_spawn_process(job->args, &term);
+        job->result = (term.how == TerminationIdClean) ? term.code : -1;
+    }
+}
+
+static void gen_c_object_finish(CodeGen *g, CObjectJob *job, bool is_cache_miss) {
+    Error err;
+
+    Buf *o_dir = buf_sprintf("%s" OS_SEP CACHE_OUT_SUBDIR, buf_ptr(g->cache_dir));
+    Buf *artifact_dir;
+    Buf *o_final_path;
+
+    if (is_cache_miss) {
+        if (job->result != 0) {
             fprintf(stderr, "\nThe following command failed:\n");
-            print_zig_cc_cmd(&args);
+            print_zig_cc_cmd(&job->args);
             exit(1);
         }
 
         // add the files depended on to the cache system
-        if ((err = cache_add_dep_file(cache_hash, out_dep_path, true))) {
+        if ((err = cache_add_dep_file(job->cache_hash, job->out_dep_path, true))) {
             // Don't treat the absence of the .d file as a fatal error, the
             // compiler may not produce one eg. when compiling .s files
             if (err != ErrorFileNotFound) {
@@ -9320,41 +9994,42 @@ static void gen_c_object(CodeGen *g, Buf *self_exe_path, CFile *c_file) {
             }
         }
         if (err != ErrorFileNotFound) {
-            os_delete_file(out_dep_path);
+            os_delete_file(job->out_dep_path);
         }
 
-        if ((err = cache_final(cache_hash, &digest))) {
+        if ((err = cache_final(job->cache_hash, &job->digest))) {
             fprintf(stderr, "Unable to finalize cache hash: %s\n", err_str(err));
             exit(1);
         }
         artifact_dir = buf_alloc();
-        os_path_join(o_dir, &digest, artifact_dir);
+        os_path_join(o_dir, &job->digest, artifact_dir);
         if ((err = os_make_path(artifact_dir))) {
             fprintf(stderr, "Unable to create output directory '%s': %s",
                     buf_ptr(artifact_dir), err_str(err));
             exit(1);
         }
         o_final_path = buf_alloc();
-        os_path_join(artifact_dir, final_o_basename, o_final_path);
-        if ((err = os_rename(out_obj_path, o_final_path))) {
+        os_path_join(artifact_dir, job->final_o_basename, o_final_path);
+        if ((err = os_rename(job->out_obj_path, o_final_path))) {
             fprintf(stderr, "Unable to rename object: %s\n", err_str(err));
             exit(1);
         }
     } else {
         // cache hit
         artifact_dir = buf_alloc();
-        os_path_join(o_dir, &digest, artifact_dir);
+        os_path_join(o_dir, &job->digest, artifact_dir);
         o_final_path = buf_alloc();
-        os_path_join(artifact_dir, final_o_basename, o_final_path);
+        os_path_join(artifact_dir, job->final_o_basename, o_final_path);
     }
 
     g->link_objects.append(o_final_path);
-    g->caches_to_release.append(cache_hash);
+    g->caches_to_release.append(job->cache_hash);
 
-    stage2_progress_end(child_prog_node);
+    stage2_progress_end(job->prog_node);
 }
 
-// returns true if we had any cache misses
+// Cache misses are compiled together so that they can run concurrently; objects are
+// still added to the link in source order.
 static void gen_c_objects(CodeGen *g) {
     Error err;
 
@@ -9372,10 +10047,25 @@ static void gen_c_objects(CodeGen *g) {
     codegen_switch_sub_prog_node(g, stage2_progress_start(g->main_progress_node, c_prog_name, strlen(c_prog_name),
             g->c_source_files.length));
 
+    CObjectJob *jobs = allocate<CObjectJob>(g->c_source_files.length);
+    bool *is_cache_miss = allocate<bool>(g->c_source_files.length);
+    ZigList<CObjectJob *> misses = {};
+    for (size_t c_file_i = 0; c_file_i < g->c_source_files.length; c_file_i += 1) {
+        CObjectJob *job = &jobs[c_file_i];
+        job->c_file = g->c_source_files.at(c_file_i);
+        is_cache_miss[c_file_i] = gen_c_object_prepare(g, self_exe_path, job);
+        if (is_cache_miss[c_file_i]) {
+            misses.append(job);
+        }
+    }
+
+    gen_c_object_run_misses(g, misses);
+
     for (size_t c_file_i = 0; c_file_i < g->c_source_files.length; c_file_i += 1) {
-        CFile *c_file = g->c_source_files.at(c_file_i);
-        gen_c_object(g, self_exe_path, c_file);
+        gen_c_object_finish(g, &jobs[c_file_i], is_cache_miss[c_file_i]);
     }
+    misses.deinit();
+    deallocate(is_cache_miss, g->c_source_files.length);
 }
 
 void codegen_add_object(CodeGen *g, Buf *object_path) {
@@ -9935,6 +10625,9 @@ static Error check_cache(CodeGen *g, Buf *manifest_dir, Buf *digest) {
     }
     cache_bool(ch, g->is_single_threaded);
     cache_bool(ch, g->linker_rdynamic);
+    cache_bool(ch, g->linker_compress_debug_sections);
+    cache_bool(ch, g->linker_incremental);
+    cache_int(ch, g->linker_icf);
     cache_bool(ch, g->each_lib_rpath);
     cache_bool(ch, g->disable_gen_h);
     cache_bool(ch, g->bundle_compiler_rt);
@@ -9942,11 +10635,25 @@ static Error check_cache(CodeGen *g, Buf *manifest_dir, Buf *digest) {
     cache_bool(ch, g->have_pic);
     cache_bool(ch, g->have_dynamic_link);
     cache_bool(ch, g->have_stack_probing);
-    cache_bool(ch, g->is_dummy_so);
     cache_bool(ch, g->function_sections);
+    cache_bool(ch, g->thin_lto);
+    cache_bool(ch, g->debug_fast);
+    cache_bool(ch, g->call_graph_profile);
+    cache_bool(ch, g->debug_line_tables_only);
+    cache_bool(ch, g->debug_split_dwarf);
+    cache_bool(ch, g->dedup_fns);
+    cache_buf_opt(ch, g->mcpu);
+    cache_buf_opt(ch, g->mattr);
+    cache_bool(ch, g->profile_generate);
+    cache_buf_opt(ch, g->profile_generate_dir);
+    cache_file_opt(ch, g->profile_use_path);
     cache_bool(ch, g->enable_dump_analysis);
     cache_bool(ch, g->enable_doc_generation);
     cache_bool(ch, g->disable_bin_generation);
+    cache_int(ch, g->emit_file_type);
+    cache_bool(ch, g->emit_asm);
+    cache_bool(ch, g->emit_llvm_ir);
+    cache_bool(ch, g->emit_llvm_bc);
     cache_buf_opt(ch, g->mmacosx_version_min);
     cache_buf_opt(ch, g->mios_version_min);
     cache_usize(ch, g->version_major);
@@ -9991,6 +10698,26 @@ static void resolve_out_paths(CodeGen *g) {
     assert(g->output_dir != nullptr);
     assert(g->root_out_name != nullptr);
 
+    if (g->emit_asm) {
+        Buf *basename = buf_sprintf("%s%s", buf_ptr(g->root_out_name), target_asm_file_ext(g->zig_target));
+        os_path_join(g->output_dir, basename, &g->asm_output_path);
+    }
+    if (g->emit_llvm_ir) {
+        Buf *basename = buf_sprintf("%s%s", buf_ptr(g->root_out_name), target_llvm_ir_file_ext(g->zig_target));
+        os_path_join(g->output_dir, basename, &g->llvm_ir_output_path);
+    }
+    if (g->emit_llvm_bc) {
+        Buf *basename = buf_sprintf("%s%s", buf_ptr(g->root_out_name), target_llvm_bc_file_ext(g->zig_target));
+        os_path_join(g->output_dir, basename, &g->llvm_bc_output_path);
+    }
+    if (g->debug_split_dwarf && !g->strip_debug_symbols) {
+        // The path is recorded in the skeleton unit, and a relative one would be looked up
+        // from the compile directory rather than from here.
+        Buf *dwo_path = buf_alloc();
+        os_path_join(g->output_dir, buf_sprintf("%s.dwo", buf_ptr(g->root_out_name)), dwo_path);
+        g->dwo_output_path = os_path_resolve(&dwo_path, 1);
+    }
+
     Buf *out_basename = buf_create_from_buf(g->root_out_name);
     Buf *o_basename = buf_create_from_buf(g->root_out_name);
     switch (g->emit_file_type) {
@@ -10209,6 +10936,12 @@ void codegen_build_and_link(CodeGen *g) {
         {
             codegen_link(g);
         }
+        finish_o_file_write(g);
+        if (g->enable_size_report && need_llvm_module(g) && !g->disable_bin_generation &&
+            g->emit_file_type == EmitFileTypeBinary)
+        {
+            collect_size_report_sections(g);
+        }
     }
 
     codegen_release_caches(g);
@@ -10259,6 +10992,8 @@ CodeGen *create_child_codegen(CodeGen *parent_gen, Buf *root_src_path, OutType o
     child_gen->verbose_cimport = parent_gen->verbose_cimport;
     child_gen->verbose_cc = parent_gen->verbose_cc;
     child_gen->llvm_argv = parent_gen->llvm_argv;
+    child_gen->mcpu = parent_gen->mcpu;
+    child_gen->mattr = parent_gen->mattr;
     child_gen->dynamic_linker_path = parent_gen->dynamic_linker_path;
 
     codegen_set_strip(child_gen, parent_gen->strip_debug_symbols);
@@ -63,6 +63,7 @@ TargetSubsystem detect_subsystem(CodeGen *g);
 void codegen_release_caches(CodeGen *codegen);
 bool codegen_fn_has_err_ret_tracing_arg(CodeGen *g, ZigType *return_type);
 bool codegen_fn_has_err_ret_tracing_stack(CodeGen *g, ZigFn *fn, bool is_async);
+bool ir_want_runtime_safety_scope(CodeGen *g, Scope *scope);
 
 ATTRIBUTE_NORETURN
 void codegen_report_errors_and_exit(CodeGen *g);
@@ -313,6 +313,8 @@ static void tree_print(FILE *f, ZigType *ty, size_t indent) {
 
     switch (ty->id) {
         case ZigTypeIdFnFrame:
+            start_peer(f, indent);
+            fprintf(f, "\"unsharedSize\": \"%" ZIG_PRI_usize "\"", ty->data.frame.unshared_abi_size);
             return tree_print_struct(f, ty->data.frame.locals_struct, indent);
         case ZigTypeIdStruct:
             return tree_print_struct(f, ty, indent);
@@ -330,10 +332,326 @@ void zig_print_stack_report(CodeGen *g, FILE *f) {
     fprintf(f, "{");
     tree_print(f, g->largest_frame_fn->frame_type, 1);
 
+    start_peer(f, 1);
+    fprintf(f, "\"frames\": [");
+    bool first = true;
+    for (size_t i = 0; i < g->fn_defs.length; i += 1) {
+        ZigFn *fn = g->fn_defs.at(i);
+        if (fn->frame_type == nullptr || !fn_is_async(fn))
+            continue;
+        ZigType *locals_struct = fn->frame_type->data.frame.locals_struct;
+        if (locals_struct == nullptr || type_is_invalid(locals_struct))
+            continue;
+        if (first) {
+            start_child(f, 2);
+            first = false;
+        } else {
+            start_peer(f, 2);
+        }
+        fprintf(f, "{\"fn\": \"%s\", \"size\": \"%" ZIG_PRI_usize "\", \"unsharedSize\": \"%" ZIG_PRI_usize "\"}",
+                buf_ptr(&fn->symbol_name), fn->frame_type->abi_size, fn->frame_type->data.frame.unshared_abi_size);
+    }
+    start_child(f, 1);
+    fprintf(f, "]");
+
     start_child(f, 0);
     fprintf(f, "}\n");
 }
 
+void zig_print_dedup_report(CodeGen *g, FILE *f) {
+    size_t instruction_count = 0;
+    for (size_t i = 0; i < g->fn_merges.length; i += 1) {
+        instruction_count += g->fn_merges.at(i).instruction_count;
+    }
+
+    JsonWriter jw;
+    jw_init(&jw, f, " ", "\n");
+    jw_begin_object(&jw);
+    jw_object_field(&jw, "fnCount");
+    jw_int(&jw, g->fn_defs.length);
+    jw_object_field(&jw, "mergedCount");
+    jw_int(&jw, g->fn_merges.length);
+    jw_object_field(&jw, "mergedInstructions");
+    jw_int(&jw, instruction_count);
+    jw_object_field(&jw, "merges");
+    jw_begin_array(&jw);
+    for (size_t i = 0; i < g->fn_merges.length; i += 1) {
+        const FnMerge *merge = &g->fn_merges.at(i);
+        jw_array_elem(&jw);
+        jw_begin_object(&jw);
+        jw_object_field(&jw, "fn");
+        jw_string(&jw, buf_ptr(&merge->merged->symbol_name));
+        jw_object_field(&jw, "into");
+        jw_string(&jw, buf_ptr(&merge->kept->symbol_name));
+        jw_object_field(&jw, "instructions");
+        jw_int(&jw, merge->instruction_count);
+        jw_end_object(&jw);
+    }
+    jw_end_array(&jw);
+    jw_end_object(&jw);
+    fprintf(f, "\n");
+}
+
+void zig_print_safety_report(CodeGen *g, FILE *f) {
+    size_t removed_count = 0;
+    for (size_t i = 0; i < g->fn_defs.length; i += 1) {
+        removed_count += g->fn_defs.at(i)->removed_safety_check_count;
+    }
+
+    JsonWriter jw;
+    jw_init(&jw, f, " ", "\n");
+    jw_begin_object(&jw);
+    jw_object_field(&jw, "removedChecks");
+    jw_int(&jw, removed_count);
+    jw_object_field(&jw, "fns");
+    jw_begin_array(&jw);
+    for (size_t i = 0; i < g->fn_defs.length; i += 1) {
+        ZigFn *fn = g->fn_defs.at(i);
+        if (fn->removed_safety_check_count == 0)
+            continue;
+        jw_array_elem(&jw);
+        jw_begin_object(&jw);
+        jw_object_field(&jw, "fn");
+        jw_string(&jw, buf_ptr(&fn->symbol_name));
+        jw_object_field(&jw, "removedChecks");
+        jw_int(&jw, fn->removed_safety_check_count);
+        jw_end_object(&jw);
+    }
+    jw_end_array(&jw);
+    jw_end_object(&jw);
+    fprintf(f, "\n");
+}
+
+struct SizeReportRow {
+    const char *name;
+    const char *kind;
+    const char *package;
+    const char *decl;
+    uint64_t size;
+    size_t symbol_count;
+};
+
+static int compare_size_report_rows_desc(const void *a, const void *b) {
+    const SizeReportRow *row_a = reinterpret_cast<const SizeReportRow *>(a);
+    const SizeReportRow *row_b = reinterpret_cast<const SizeReportRow *>(b);
+    if (row_a->size > row_b->size)
+        return -1;
+    if (row_a->size < row_b->size)
+        return 1;
+    return strcmp(row_a->name, row_b->name);
+}
+
+static const char *size_report_kind_name(SizeReportKind kind) {
+    switch (kind) {
+        case SizeReportKindFn:
+            return "fn";
+        case SizeReportKindVar:
+            return "var";
+        case SizeReportKindConst:
+            return "const";
+        case SizeReportKindOther:
+            return "other";
+    }
+    zig_unreachable();
+}
+
+static const char *size_report_section_kind_name(ZigLLVMObjectSectionKind kind) {
+    switch (kind) {
+        case ZigLLVMObjectSectionKindCode:
+            return "code";
+        case ZigLLVMObjectSectionKindData:
+            return "data";
+        case ZigLLVMObjectSectionKindBss:
+            return "bss";
+        case ZigLLVMObjectSectionKindOther:
+            return "other";
+    }
+    zig_unreachable();
+}
+
+static const char *size_report_package_name(CodeGen *g, ZigPackage *pkg) {
+    if (pkg == g->root_package || buf_len(&pkg->pkg_path) == 0)
+        return "root";
+    return buf_ptr(&pkg->pkg_path);
+}
+
+// Adds row's size to the entry of `totals` with the same key, creating it if needed.
+static void size_report_add_total(ZigList<SizeReportRow> *totals,
+        HashMap<Buf *, size_t, buf_hash, buf_eql_buf> *index, Buf *key, const SizeReportRow *row)
+{
+    auto entry = index->maybe_get(key);
+    if (entry == nullptr) {
+        index->put(key, totals->length);
+        totals->append(*row);
+        totals->last().symbol_count = 1;
+        return;
+    }
+    SizeReportRow *total = &totals->at(entry->value);
+    total->size += row->size;
+    total->symbol_count += 1;
+}
+
+static void size_report_print_json_rows(JsonWriter *jw, const char *field, ZigList<SizeReportRow> *rows,
+        bool with_kind, bool with_package, bool with_decl, bool with_count)
+{
+    jw_object_field(jw, field);
+    jw_begin_array(jw);
+    for (size_t i = 0; i < rows->length; i += 1) {
+        const SizeReportRow *row = &rows->at(i);
+        jw_array_elem(jw);
+        jw_begin_object(jw);
+        jw_object_field(jw, "name");
+        jw_string(jw, row->name);
+        jw_object_field(jw, "size");
+        jw_int(jw, row->size);
+        if (with_kind) {
+            jw_object_field(jw, "kind");
+            jw_string(jw, row->kind);
+        }
+        if (with_package) {
+            jw_object_field(jw, "package");
+            jw_string(jw, row->package);
+        }
+        if (with_decl) {
+            jw_object_field(jw, "decl");
+            jw_string(jw, row->decl);
+        }
+        if (with_count) {
+            jw_object_field(jw, "symbols");
+            jw_int(jw, row->symbol_count);
+        }
+        jw_end_object(jw);
+    }
+    jw_end_array(jw);
+}
+
+// Each line of the table starts with a size, so any part of it can be piped through `sort -n`.
+static void size_report_print_table_rows(FILE *f, const char *title, ZigList<SizeReportRow> *rows,
+        bool with_symbols)
+{
+    size_t kind_width = 4;
+    size_t package_width = 7;
+    for (size_t i = 0; i < rows->length; i += 1) {
+        kind_width = max(kind_width, strlen(rows->at(i).kind));
+        package_width = max(package_width, strlen(rows->at(i).package));
+    }
+    fprintf(f, "# %s\n", title);
+    if (with_symbols) {
+        fprintf(f, "# %8s  %-*s  %-*s  %s  %s\n", "size", (int)kind_width, "kind", (int)package_width, "package",
+                "decl", "symbol");
+    } else {
+        fprintf(f, "# %8s  %-*s  %-*s  %s\n", "size", (int)kind_width, "kind", (int)package_width, "package",
+                "name");
+    }
+    for (size_t i = 0; i < rows->length; i += 1) {
+        const SizeReportRow *row = &rows->at(i);
+        if (with_symbols) {
+            fprintf(f, "%10" ZIG_PRI_u64 "  %-*s  %-*s  %s  %s\n", row->size, (int)kind_width, row->kind,
+                    (int)package_width, row->package, row->decl, row->name);
+        } else {
+            fprintf(f, "%10" ZIG_PRI_u64 "  %-*s  %-*s  %s\n", row->size, (int)kind_width, row->kind,
+                    (int)package_width, row->package, row->name);
+        }
+    }
+}
+
+void zig_print_size_report(CodeGen *g, FILE *f, bool json) {
+    if (g->size_report_symbols.length == 0 && g->size_report_sections.length == 0) {
+        if (json) {
+            fprintf(f, "{\"error\": \"No object file was generated in this compilation.\"}\n");
+        } else {
+            fprintf(f, "# No object file was generated in this compilation.\n");
+        }
+        return;
+    }
+
+    ZigList<SizeReportRow> symbols = {};
+    ZigList<SizeReportRow> decls = {};
+    ZigList<SizeReportRow> packages = {};
+    ZigList<SizeReportRow> sections = {};
+    HashMap<Buf *, size_t, buf_hash, buf_eql_buf> decl_index = {};
+    HashMap<Buf *, size_t, buf_hash, buf_eql_buf> package_index = {};
+    decl_index.init(64);
+    package_index.init(16);
+    uint64_t total_size = 0;
+
+    for (size_t i = 0; i < g->size_report_symbols.length; i += 1) {
+        const SizeReportSymbol *symbol = &g->size_report_symbols.at(i);
+        SizeReportRow row = {};
+        row.name = (buf_len(symbol->name) == 0) ? "(anonymous)" : buf_ptr(symbol->name);
+        row.kind = size_report_kind_name(symbol->kind);
+        row.package = "";
+        row.decl = "";
+        row.size = symbol->size;
+        if (symbol->fn != nullptr) {
+            row.package = size_report_package_name(g, scope_package(&symbol->fn->fndef_scope->base));
+            // Generic instantiations share the symbol name of the function they come from.
+            row.decl = buf_ptr(&symbol->fn->symbol_name);
+        } else if (symbol->tld != nullptr) {
+            row.package = size_report_package_name(g, scope_package(symbol->tld->parent_scope));
+            Buf *decl_name = buf_alloc();
+            get_fully_qualified_decl_name(g, decl_name, symbol->tld, false);
+            row.decl = buf_ptr(decl_name);
+        }
+        symbols.append(row);
+        total_size += row.size;
+
+        if (row.decl[0] != 0) {
+            SizeReportRow decl_row = row;
+            decl_row.name = row.decl;
+            decl_row.kind = (symbol->kind == SizeReportKindVar) ? "var" : "fn";
+            size_report_add_total(&decls, &decl_index, buf_sprintf("%s:%s", row.package, row.decl), &decl_row);
+        }
+        SizeReportRow package_row = row;
+        package_row.name = (row.package[0] == 0) ? "(none)" : row.package;
+        package_row.kind = "pkg";
+        package_row.package = "";
+        size_report_add_total(&packages, &package_index, buf_create_from_str(package_row.name), &package_row);
+    }
+    for (size_t i = 0; i < g->size_report_sections.length; i += 1) {
+        const SizeReportSection *section = &g->size_report_sections.at(i);
+        SizeReportRow row = {};
+        row.name = buf_ptr(section->name);
+        row.kind = size_report_section_kind_name(section->kind);
+        row.package = "";
+        row.decl = "";
+        row.size = section->size;
+        sections.append(row);
+    }
+
+    qsort(symbols.items, symbols.length, sizeof(SizeReportRow), compare_size_report_rows_desc);
+    qsort(decls.items, decls.length, sizeof(SizeReportRow), compare_size_report_rows_desc);
+    qsort(packages.items, packages.length, sizeof(SizeReportRow), compare_size_report_rows_desc);
+    qsort(sections.items, sections.length, sizeof(SizeReportRow), compare_size_report_rows_desc);
+
+    if (json) {
+        JsonWriter jw;
+        jw_init(&jw, f, " ", "\n");
+        jw_begin_object(&jw);
+        jw_object_field(&jw, "totalSize");
+        jw_int(&jw, total_size);
+        size_report_print_json_rows(&jw, "symbols", &symbols, true, true, true, false);
+        size_report_print_json_rows(&jw, "decls", &decls, true, true, false, true);
+        size_report_print_json_rows(&jw, "packages", &packages, false, false, false, true);
+        size_report_print_json_rows(&jw, "sections", &sections, true, false, false, false);
+        jw_end_object(&jw);
+        fprintf(f, "\n");
+    } else {
+        size_report_print_table_rows(f, "symbols", &symbols, true);
+        size_report_print_table_rows(f, "totals by declaration, including generic instantiations", &decls, false);
+        size_report_print_table_rows(f, "totals by package", &packages, false);
+        size_report_print_table_rows(f, "sections of the linked output", &sections, false);
+        fprintf(f, "# total\n%10" ZIG_PRI_u64 "\n", total_size);
+    }
+
+    symbols.deinit();
+    decls.deinit();
+    packages.deinit();
+    sections.deinit();
+    decl_index.deinit();
+    package_index.deinit();
+}
+
 struct AnalDumpCtx {
     CodeGen *g;
     JsonWriter jw;
@@ -18,13 +18,9 @@ static const ZigGLibCLib glibc_libs[] = {
     {"rt", 1},
 };
 
-Error glibc_load_metadata(ZigGLibCAbi **out_result, Buf *zig_lib_dir, bool verbose) {
+static Error glibc_parse_metadata_txt(ZigGLibCAbi *glibc_abi, bool verbose) {
     Error err;
 
-    ZigGLibCAbi *glibc_abi = allocate<ZigGLibCAbi>(1);
-    glibc_abi->vers_txt_path = buf_sprintf("%s" OS_SEP "libc" OS_SEP "glibc" OS_SEP "vers.txt", buf_ptr(zig_lib_dir));
-    glibc_abi->fns_txt_path = buf_sprintf("%s" OS_SEP "libc" OS_SEP "glibc" OS_SEP "fns.txt", buf_ptr(zig_lib_dir));
-    glibc_abi->abi_txt_path = buf_sprintf("%s" OS_SEP "libc" OS_SEP "glibc" OS_SEP "abi.txt", buf_ptr(zig_lib_dir));
     glibc_abi->version_table.init(16);
 
     Buf *vers_txt_contents = buf_alloc();
@@ -87,7 +83,7 @@ Error glibc_load_metadata(ZigGLibCAbi **out_result, Buf *zig_lib_dir, bool verbo
 
             Buf *this_fn_name = buf_create_from_slice(opt_fn_name.value);
             Buf *this_lib_name = buf_create_from_slice(opt_lib_name.value);
-            glibc_abi->all_functions.append({ this_fn_name, glibc_lib_find(buf_ptr(this_lib_name)) });
+            glibc_abi->all_functions.append({ buf_ptr(this_fn_name), glibc_lib_find(buf_ptr(this_lib_name)) });
         }
     }
     {
@@ -164,10 +160,727 @@ Error glibc_load_metadata(ZigGLibCAbi **out_result, Buf *zig_lib_dir, bool verbo
         }
     }
 
+    return ErrorNone;
+}
+
+// The parsed form of vers.txt, fns.txt and abi.txt is kept in the stage1 cache so that
+// targeting glibc does not cost a parse of ~60k lines on every compilation. The layout,
+// in native byte order since the cache is keyed on the compiler id, is:
+//   GLibCMetadataHeader
+//   ZigGLibCVersion[version_count]
+//   GLibCMetadataFn[fn_count]
+//   GLibCMetadataTarget[target_count]
+//   strings_len bytes of NUL terminated function names, padded to 4 bytes
+//   ZigGLibCVerList[ver_list_count * fn_count]
+// The version lists are used in place; they make up nearly all of the data.
+static const char glibc_metadata_magic[8] = {'z', 'g', 'l', 'i', 'b', 'c', 0, 1};
+
+struct GLibCMetadataHeader {
+    char magic[8];
+    uint32_t version_count;
+    uint32_t fn_count;
+    uint32_t target_count;
+    uint32_t ver_list_count;
+    uint32_t strings_len;
+};
+
+struct GLibCMetadataFn {
+    uint32_t name_offset;
+    uint32_t lib_index;
+};
+
+struct GLibCMetadataTarget {
+    uint32_t arch;
+    uint32_t abi;
+    uint32_t ver_list_index;
+};
+
+static void glibc_metadata_append(Buf *out, const void *ptr, size_t len) {
+    buf_append_mem(out, (const char *)ptr, len);
+}
+
+static void glibc_serialize_metadata(const ZigGLibCAbi *glibc_abi, Buf *out) {
+    ZigList<ZigGLibCVerList *> ver_lists = {};
+    ZigList<GLibCMetadataTarget> targets = {};
+    auto it = glibc_abi->version_table.entry_iterator();
+    for (;;) {
+        auto *entry = it.next();
+        if (entry == nullptr)
+            break;
+        uint32_t ver_list_index = 0;
+        while (ver_list_index < ver_lists.length && ver_lists.at(ver_list_index) != entry->value) {
+            ver_list_index += 1;
+        }
+        if (ver_list_index == ver_lists.length) {
+            ver_lists.append(entry->value);
+        }
+        targets.append({(uint32_t)entry->key->arch, (uint32_t)entry->key->abi, ver_list_index});
+    }
+
+    Buf *strings = buf_alloc();
+    ZigList<GLibCMetadataFn> fns = {};
+    for (size_t fn_i = 0; fn_i < glibc_abi->all_functions.length; fn_i += 1) {
+        const ZigGLibCFn *libc_fn = &glibc_abi->all_functions.at(fn_i);
+        fns.append({(uint32_t)buf_len(strings), (uint32_t)(libc_fn->lib - glibc_libs)});
+        buf_append_str(strings, libc_fn->name);
+        buf_append_char(strings, 0);
+    }
+    while (buf_len(strings) % 4 != 0) {
+        buf_append_char(strings, 0);
+    }
+
+    GLibCMetadataHeader header = {};
+    memcpy(header.magic, glibc_metadata_magic, sizeof(glibc_metadata_magic));
+    header.version_count = glibc_abi->all_versions.length;
+    header.fn_count = glibc_abi->all_functions.length;
+    header.target_count = targets.length;
+    header.ver_list_count = ver_lists.length;
+    header.strings_len = buf_len(strings);
+
+    buf_resize(out, 0);
+    glibc_metadata_append(out, &header, sizeof(header));
+    glibc_metadata_append(out, glibc_abi->all_versions.items, header.version_count * sizeof(ZigGLibCVersion));
+    glibc_metadata_append(out, fns.items, fns.length * sizeof(GLibCMetadataFn));
+    glibc_metadata_append(out, targets.items, targets.length * sizeof(GLibCMetadataTarget));
+    buf_append_buf(out, strings);
+    for (size_t i = 0; i < ver_lists.length; i += 1) {
+        glibc_metadata_append(out, ver_lists.at(i), header.fn_count * sizeof(ZigGLibCVerList));
+    }
+
+    ver_lists.deinit();
+    targets.deinit();
+    fns.deinit();
+    buf_destroy(strings);
+}
+
+// Returns false if the contents are truncated or inconsistent, in which case the
+// text files are parsed again. On success glibc_abi points into contents.
+static bool glibc_deserialize_metadata(ZigGLibCAbi *glibc_abi, Buf *contents) {
+    const char *base = buf_ptr(contents);
+    size_t len = buf_len(contents);
+    GLibCMetadataHeader header;
+    if (len < sizeof(header))
+        return false;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, glibc_metadata_magic, sizeof(glibc_metadata_magic)) != 0)
+        return false;
+
+    size_t versions_offset = sizeof(header);
+    size_t fns_offset = versions_offset + header.version_count * sizeof(ZigGLibCVersion);
+    size_t targets_offset = fns_offset + header.fn_count * sizeof(GLibCMetadataFn);
+    size_t strings_offset = targets_offset + header.target_count * sizeof(GLibCMetadataTarget);
+    size_t ver_lists_offset = strings_offset + header.strings_len;
+    size_t end_offset = ver_lists_offset + (size_t)header.ver_list_count * header.fn_count * sizeof(ZigGLibCVerList);
+    if (end_offset != len || header.strings_len == 0 || base[ver_lists_offset - 1] != 0)
+        return false;
+
+    const char *strings = base + strings_offset;
+    const ZigGLibCVerList *ver_lists = (const ZigGLibCVerList *)(base + ver_lists_offset);
+    for (size_t i = 0; i < (size_t)header.ver_list_count * header.fn_count; i += 1) {
+        const ZigGLibCVerList *ver_list = &ver_lists[i];
+        if (ver_list->len > array_length(ver_list->versions))
+            return false;
+        for (uint8_t ver_i = 0; ver_i < ver_list->len; ver_i += 1) {
+            if (ver_list->versions[ver_i] >= header.version_count)
+                return false;
+        }
+    }
+
+    glibc_abi->all_versions.resize(header.version_count);
+    memcpy(glibc_abi->all_versions.items, base + versions_offset, header.version_count * sizeof(ZigGLibCVersion));
+
+    glibc_abi->all_functions.resize(header.fn_count);
+    for (size_t fn_i = 0; fn_i < header.fn_count; fn_i += 1) {
+        GLibCMetadataFn fn;
+        memcpy(&fn, base + fns_offset + fn_i * sizeof(GLibCMetadataFn), sizeof(GLibCMetadataFn));
+        if (fn.name_offset >= header.strings_len || fn.lib_index >= array_length(glibc_libs))
+            return false;
+        glibc_abi->all_functions.at(fn_i) = {strings + fn.name_offset, &glibc_libs[fn.lib_index]};
+    }
+
+    glibc_abi->version_table.init(16);
+    ZigTarget *targets = allocate<ZigTarget>(header.target_count);
+    for (size_t target_i = 0; target_i < header.target_count; target_i += 1) {
+        GLibCMetadataTarget entry;
+        memcpy(&entry, base + targets_offset + target_i * sizeof(GLibCMetadataTarget), sizeof(GLibCMetadataTarget));
+        if (entry.ver_list_index >= header.ver_list_count)
+            return false;
+        ZigTarget *target = &targets[target_i];
+        target->arch = (ZigLLVM_ArchType)entry.arch;
+        target->os = OsLinux;
+        target->abi = (ZigLLVM_EnvironmentType)entry.abi;
+        // The lists are only ever read through the version table.
+        ZigGLibCVerList *ver_list_base = const_cast<ZigGLibCVerList *>(
+                &ver_lists[(size_t)entry.ver_list_index * header.fn_count]);
+        glibc_abi->version_table.put(target, ver_list_base);
+    }
+    return true;
+}
+
+Error glibc_load_metadata(ZigGLibCAbi **out_result, Buf *zig_lib_dir, bool verbose) {
+    Error err;
+
+    ZigGLibCAbi *glibc_abi = allocate<ZigGLibCAbi>(1);
+    glibc_abi->vers_txt_path = buf_sprintf("%s" OS_SEP "libc" OS_SEP "glibc" OS_SEP "vers.txt", buf_ptr(zig_lib_dir));
+    glibc_abi->fns_txt_path = buf_sprintf("%s" OS_SEP "libc" OS_SEP "glibc" OS_SEP "fns.txt", buf_ptr(zig_lib_dir));
+    glibc_abi->abi_txt_path = buf_sprintf("%s" OS_SEP "libc" OS_SEP "glibc" OS_SEP "abi.txt", buf_ptr(zig_lib_dir));
+
+    Buf *cache_dir = get_stage1_cache_path();
+    Buf *manifest_dir = buf_sprintf("%s" OS_SEP CACHE_HASH_SUBDIR, buf_ptr(cache_dir));
+    CacheHash *cache_hash = allocate<CacheHash>(1);
+    cache_init(cache_hash, manifest_dir);
+
+    Buf *compiler_id;
+    if ((err = get_compiler_id(&compiler_id))) {
+        if (verbose) {
+            fprintf(stderr, "unable to get compiler id: %s\n", err_str(err));
+        }
+        return err;
+    }
+    cache_str(cache_hash, "glibc metadata");
+    cache_buf(cache_hash, compiler_id);
+    cache_file(cache_hash, glibc_abi->vers_txt_path);
+    cache_file(cache_hash, glibc_abi->fns_txt_path);
+    cache_file(cache_hash, glibc_abi->abi_txt_path);
+
+    Buf digest = BUF_INIT;
+    buf_resize(&digest, 0);
+    if ((err = cache_hit(cache_hash, &digest))) {
+        // Treat an invalid format error as a cache miss.
+        if (err != ErrorInvalidFormat)
+            return err;
+    }
+    if (buf_len(&digest) != 0) {
+        Buf *bin_path = buf_sprintf("%s" OS_SEP CACHE_OUT_SUBDIR OS_SEP "%s" OS_SEP "glibc.bin",
+                buf_ptr(cache_dir), buf_ptr(&digest));
+        Buf *bin_contents = buf_alloc();
+        if (os_fetch_file_path(bin_path, bin_contents) == ErrorNone &&
+            glibc_deserialize_metadata(glibc_abi, bin_contents))
+        {
+            cache_release(cache_hash);
+            *out_result = glibc_abi;
+            return ErrorNone;
+        }
+        // The cached copy is missing or damaged; fall back to the text files and
+        // rewrite it below.
+        buf_destroy(bin_contents);
+        glibc_abi->all_versions.clear();
+        glibc_abi->all_functions.clear();
+        glibc_abi->version_table.deinit();
+    }
+
+    if ((err = glibc_parse_metadata_txt(glibc_abi, verbose)))
+        return err;
+
+    if (buf_len(&digest) == 0) {
+        if ((err = cache_final(cache_hash, &digest))) {
+            if (verbose) {
+                fprintf(stderr, "unable to finalize glibc metadata cache: %s\n", err_str(err));
+            }
+            return err;
+        }
+    }
+    Buf *bin_dir = buf_sprintf("%s" OS_SEP CACHE_OUT_SUBDIR OS_SEP "%s", buf_ptr(cache_dir), buf_ptr(&digest));
+    Buf *bin_path = buf_sprintf("%s" OS_SEP "glibc.bin", buf_ptr(bin_dir));
+    Buf *bin_contents = buf_alloc();
+    glibc_serialize_metadata(glibc_abi, bin_contents);
+    if ((err = os_make_path(bin_dir)) || (err = os_write_file(bin_path, bin_contents))) {
+        if (verbose) {
+            fprintf(stderr, "unable to write %s: %s\n", buf_ptr(bin_path), err_str(err));
+        }
+        return err;
+    }
+    cache_release(cache_hash);
+
     *out_result = glibc_abi;
     return ErrorNone;
 }
 
+struct GLibCStubElf {
+    Buf *buf;
+    bool is_64;
+    bool is_big_endian;
+};
+
+static void stub_elf_u8(GLibCStubElf *elf, uint8_t x) {
+    buf_append_char(elf->buf, x);
+}
+
+static void stub_elf_u16(GLibCStubElf *elf, uint16_t x) {
+    if (elf->is_big_endian) {
+        stub_elf_u8(elf, x >> 8);
+        stub_elf_u8(elf, x);
+    } else {
+        stub_elf_u8(elf, x);
+        stub_elf_u8(elf, x >> 8);
+    }
+}
+
+static void stub_elf_u32(GLibCStubElf *elf, uint32_t x) {
+    if (elf->is_big_endian) {
+        stub_elf_u16(elf, x >> 16);
+        stub_elf_u16(elf, x);
+    } else {
+        stub_elf_u16(elf, x);
+        stub_elf_u16(elf, x >> 16);
+    }
+}
+
+static void stub_elf_u64(GLibCStubElf *elf, uint64_t x) {
+    if (elf->is_big_endian) {
+        stub_elf_u32(elf, x >> 32);
+        stub_elf_u32(elf, x);
+    } else {
+        stub_elf_u32(elf, x);
+        stub_elf_u32(elf, x >> 32);
+    }
+}
+
+// An address, offset or size, which is the width of the ELF class.
+static void stub_elf_word(GLibCStubElf *elf, uint64_t x) {
+    if (elf->is_64) {
+        stub_elf_u64(elf, x);
+    } else {
+        stub_elf_u32(elf, x);
+    }
+}
+
+static void stub_elf_pad(GLibCStubElf *elf, size_t offset) {
+    assert(buf_len(elf->buf) <= offset);
+    while (buf_len(elf->buf) < offset) {
+        stub_elf_u8(elf, 0);
+    }
+}
+
+static size_t stub_elf_align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static uint32_t stub_elf_hash(const char *name) {
+    uint32_t h = 0;
+    for (const uint8_t *p = (const uint8_t *)name; *p != 0; p += 1) {
+        h = (h << 4) + *p;
+        uint32_t g = h & 0xf0000000;
+        if (g != 0)
+            h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+
+static uint32_t stub_elf_add_string(Buf *strtab, HashMap<Buf *, uint32_t, buf_hash, buf_eql_buf> *offsets,
+        Buf *str)
+{
+    auto entry = offsets->maybe_get(str);
+    if (entry != nullptr)
+        return entry->value;
+    uint32_t offset = buf_len(strtab);
+    buf_append_buf(strtab, str);
+    buf_append_char(strtab, 0);
+    offsets->put(str, offset);
+    return offset;
+}
+
+static Error stub_elf_machine(const ZigTarget *target, uint16_t *machine, uint32_t *flags, GLibCStubElf *elf) {
+    elf->is_64 = target_arch_pointer_bit_width(target->arch) == 64;
+    elf->is_big_endian = false;
+    *flags = 0;
+    switch (target->arch) {
+        case ZigLLVM_aarch64_be:
+            elf->is_big_endian = true;
+            // fallthrough
+        case ZigLLVM_aarch64:
+            *machine = 183; // EM_AARCH64
+            return ErrorNone;
+        case ZigLLVM_armeb:
+            elf->is_big_endian = true;
+            // fallthrough
+        case ZigLLVM_arm:
+            *machine = 40; // EM_ARM
+            // EF_ARM_EABI_VER5 with EF_ARM_ABI_FLOAT_HARD or EF_ARM_ABI_FLOAT_SOFT
+            *flags = 0x05000000 | ((target->abi == ZigLLVM_GNUEABIHF || target->abi == ZigLLVM_EABIHF) ? 0x400 : 0x200);
+            return ErrorNone;
+        case ZigLLVM_systemz:
+            elf->is_big_endian = true;
+            *machine = 22; // EM_S390
+            return ErrorNone;
+        case ZigLLVM_sparc:
+            elf->is_big_endian = true;
+            *machine = 2; // EM_SPARC
+            return ErrorNone;
+        case ZigLLVM_sparcel:
+            *machine = 2; // EM_SPARC
+            return ErrorNone;
+        case ZigLLVM_sparcv9:
+            elf->is_big_endian = true;
+            *machine = 43; // EM_SPARCV9
+            return ErrorNone;
+        case ZigLLVM_mips:
+        case ZigLLVM_mips64:
+            elf->is_big_endian = true;
+            // fallthrough
+        case ZigLLVM_mipsel:
+        case ZigLLVM_mips64el:
+            *machine = 8; // EM_MIPS
+            *flags = 0x6; // EF_MIPS_PIC | EF_MIPS_CPIC
+            if (target->arch == ZigLLVM_mips || target->arch == ZigLLVM_mipsel) {
+                *flags |= 0x1000 | 0x50000000; // EF_MIPS_ABI_O32 | EF_MIPS_ARCH_32R2
+            } else if (target->abi == ZigLLVM_GNUABIN32) {
+                elf->is_64 = false;
+                *flags |= 0x20 | 0x80000000; // EF_MIPS_ABI2 | EF_MIPS_ARCH_64R2
+            } else {
+                *flags |= 0x80000000; // EF_MIPS_ARCH_64R2
+            }
+            return ErrorNone;
+        case ZigLLVM_x86:
+            *machine = 3; // EM_386
+            return ErrorNone;
+        case ZigLLVM_x86_64:
+            *machine = 62; // EM_X86_64
+            if (target->abi == ZigLLVM_GNUX32)
+                elf->is_64 = false;
+            return ErrorNone;
+        case ZigLLVM_ppc:
+            elf->is_big_endian = true;
+            *machine = 20; // EM_PPC
+            return ErrorNone;
+        case ZigLLVM_ppc64:
+            elf->is_big_endian = true;
+            *machine = 21; // EM_PPC64
+            *flags = 1; // ELFv1
+            return ErrorNone;
+        case ZigLLVM_ppc64le:
+            *machine = 21; // EM_PPC64
+            *flags = 2; // ELFv2
+            return ErrorNone;
+        case ZigLLVM_riscv32:
+        case ZigLLVM_riscv64:
+            *machine = 243; // EM_RISCV
+            *flags = 0x4; // EF_RISCV_FLOAT_ABI_DOUBLE
+            return ErrorNone;
+        default:
+            return ErrorUnknownArchitecture;
+    }
+}
+
+static void glibc_ver_name(Buf *out, const ZigGLibCVersion *ver) {
+    if (ver->patch == 0) {
+        buf_appendf(out, "GLIBC_%d.%d", ver->major, ver->minor);
+    } else {
+        buf_appendf(out, "GLIBC_%d.%d.%d", ver->major, ver->minor, ver->patch);
+    }
+}
+
+// Writes a shared object that contains nothing but the versioned dynamic symbols of one
+// glibc library: .dynsym, .gnu.version and .gnu.version_d, plus the .dynstr, .hash and
+// .dynamic sections that tie them together. This is all the linker needs to resolve
+// symbols against it and record DT_NEEDED and version requirements in the output.
+static Error glibc_write_stub_so(const ZigGLibCAbi *glibc_abi, const ZigTarget *target,
+        const ZigGLibCVerList *ver_list_base, uint8_t target_ver_index, const ZigGLibCLib *lib, Buf *out)
+{
+    Error err;
+    GLibCStubElf elf = {};
+    elf.buf = out;
+    uint16_t machine;
+    uint32_t e_flags;
+    if ((err = stub_elf_machine(target, &machine, &e_flags, &elf)))
+        return err;
+
+    Buf *dynstr = buf_alloc();
+    buf_append_char(dynstr, 0);
+    HashMap<Buf *, uint32_t, buf_hash, buf_eql_buf> dynstr_offsets = {};
+    dynstr_offsets.init(1024);
+
+    Buf *soname = buf_sprintf("lib%s.so.%d", lib->name, lib->sover);
+    uint32_t soname_offset = stub_elf_add_string(dynstr, &dynstr_offsets, soname);
+
+    // Version index 1 is the library itself; the glibc versions follow in the order of
+    // vers.txt, the same numbering a version script listing all of them would produce.
+    size_t verdef_count = glibc_abi->all_versions.length + 1;
+    uint32_t *verdef_name_offsets = allocate<uint32_t>(verdef_count);
+    uint32_t *verdef_hashes = allocate<uint32_t>(verdef_count);
+    verdef_name_offsets[0] = soname_offset;
+    verdef_hashes[0] = stub_elf_hash(buf_ptr(soname));
+    for (size_t ver_i = 0; ver_i < glibc_abi->all_versions.length; ver_i += 1) {
+        Buf *ver_name = buf_alloc();
+        glibc_ver_name(ver_name, &glibc_abi->all_versions.at(ver_i));
+        verdef_name_offsets[ver_i + 1] = stub_elf_add_string(dynstr, &dynstr_offsets, ver_name);
+        verdef_hashes[ver_i + 1] = stub_elf_hash(buf_ptr(ver_name));
+    }
+
+    struct StubSym {
+        uint32_t name_offset;
+        uint32_t hash;
+        uint16_t versym;
+    };
+    ZigList<StubSym> syms = {};
+    syms.append({0, 0, 0}); // the null symbol, VER_NDX_LOCAL
+    for (size_t fn_i = 0; fn_i < glibc_abi->all_functions.length; fn_i += 1) {
+        const ZigGLibCFn *libc_fn = &glibc_abi->all_functions.at(fn_i);
+        if (libc_fn->lib != lib) continue;
+        const ZigGLibCVerList *ver_list = &ver_list_base[fn_i];
+        // Pick the default symbol version:
+        // - If there are no versions, don't emit it
+        // - Take the greatest one <= than the target one
+        // - If none of them is <= than the
+        //   specified one don't pick any default version
+        if (ver_list->len == 0) continue;
+        uint8_t chosen_def_ver_index = 255;
+        for (uint8_t ver_i = 0; ver_i < ver_list->len; ver_i += 1) {
+            uint8_t ver_index = ver_list->versions[ver_i];
+            if ((chosen_def_ver_index == 255 || ver_index > chosen_def_ver_index) &&
+                target_ver_index >= ver_index)
+            {
+                chosen_def_ver_index = ver_index;
+            }
+        }
+        uint32_t name_offset = stub_elf_add_string(dynstr, &dynstr_offsets, buf_create_from_str(libc_fn->name));
+        uint32_t hash = stub_elf_hash(libc_fn->name);
+        for (uint8_t ver_i = 0; ver_i < ver_list->len; ver_i += 1) {
+            uint8_t ver_index = ver_list->versions[ver_i];
+            uint16_t versym = ver_index + 2;
+            // Non-default versions (sym@VER rather than sym@@VER) are hidden.
+            if (chosen_def_ver_index == 255 || ver_index != chosen_def_ver_index)
+                versym |= 0x8000; // VERSYM_HIDDEN
+            syms.append({name_offset, hash, versym});
+        }
+    }
+
+    const size_t addr_size = elf.is_64 ? 8 : 4;
+    const size_t ehdr_size = elf.is_64 ? 64 : 52;
+    const size_t phdr_size = elf.is_64 ? 56 : 32;
+    const size_t shdr_size = elf.is_64 ? 64 : 40;
+    const size_t sym_size = elf.is_64 ? 24 : 16;
+    const size_t dyn_size = 2 * addr_size;
+    const size_t verdef_size = 20 + 8; // Elf_Verdef followed by one Elf_Verdaux
+    const size_t phdr_count = 2;
+    const size_t dyn_count = 10;
+
+    enum {
+        ShNull,
+        ShHash,
+        ShDynSym,
+        ShDynStr,
+        ShVerSym,
+        ShVerDef,
+        ShText,
+        ShDynamic,
+        ShShStrTab,
+        ShCount,
+    };
+    static const char *section_names[ShCount] = {
+        "", ".hash", ".dynsym", ".dynstr", ".gnu.version", ".gnu.version_d", ".text", ".dynamic", ".shstrtab",
+    };
+    Buf *shstrtab = buf_alloc();
+    uint32_t sh_name[ShCount];
+    for (size_t i = 0; i < ShCount; i += 1) {
+        sh_name[i] = buf_len(shstrtab);
+        buf_append_str(shstrtab, section_names[i]);
+        buf_append_char(shstrtab, 0);
+    }
+
+    size_t nbucket = max<size_t>(1, syms.length / 2);
+    size_t sh_offset[ShCount] = {};
+    size_t sh_size[ShCount] = {};
+    size_t offset = ehdr_size + phdr_count * phdr_size;
+    sh_offset[ShHash] = offset = stub_elf_align(offset, 4);
+    sh_size[ShHash] = (2 + nbucket + syms.length) * 4;
+    sh_offset[ShDynSym] = offset = stub_elf_align(offset + sh_size[ShHash], addr_size);
+    sh_size[ShDynSym] = syms.length * sym_size;
+    sh_offset[ShDynStr] = offset = offset + sh_size[ShDynSym];
+    sh_size[ShDynStr] = buf_len(dynstr);
+    sh_offset[ShVerSym] = offset = stub_elf_align(offset + sh_size[ShDynStr], 2);
+    sh_size[ShVerSym] = syms.length * 2;
+    sh_offset[ShVerDef] = offset = stub_elf_align(offset + sh_size[ShVerSym], 4);
+    sh_size[ShVerDef] = verdef_count * verdef_size;
+    sh_offset[ShText] = offset = stub_elf_align(offset + sh_size[ShVerDef], 16);
+    sh_size[ShText] = 0;
+    sh_offset[ShDynamic] = offset = stub_elf_align(offset, addr_size);
+    sh_size[ShDynamic] = dyn_count * dyn_size;
+    sh_offset[ShShStrTab] = offset = offset + sh_size[ShDynamic];
+    sh_size[ShShStrTab] = buf_len(shstrtab);
+    size_t load_end = sh_offset[ShShStrTab];
+    size_t shdrs_offset = stub_elf_align(offset + sh_size[ShShStrTab], addr_size);
+
+    // ELF header
+    stub_elf_u8(&elf, 0x7f);
+    stub_elf_u8(&elf, 'E');
+    stub_elf_u8(&elf, 'L');
+    stub_elf_u8(&elf, 'F');
+    stub_elf_u8(&elf, elf.is_64 ? 2 : 1); // ELFCLASS64 : ELFCLASS32
+    stub_elf_u8(&elf, elf.is_big_endian ? 2 : 1); // ELFDATA2MSB : ELFDATA2LSB
+    stub_elf_u8(&elf, 1); // EV_CURRENT
+    stub_elf_pad(&elf, 16);
+    stub_elf_u16(&elf, 3); // ET_DYN
+    stub_elf_u16(&elf, machine);
+    stub_elf_u32(&elf, 1); // EV_CURRENT
+    stub_elf_word(&elf, 0); // e_entry
+    stub_elf_word(&elf, ehdr_size); // e_phoff
+    stub_elf_word(&elf, shdrs_offset); // e_shoff
+    stub_elf_u32(&elf, e_flags);
+    stub_elf_u16(&elf, ehdr_size);
+    stub_elf_u16(&elf, phdr_size);
+    stub_elf_u16(&elf, phdr_count);
+    stub_elf_u16(&elf, shdr_size);
+    stub_elf_u16(&elf, ShCount);
+    stub_elf_u16(&elf, ShShStrTab);
+
+    // Program headers: PT_LOAD of everything up to .shstrtab, and PT_DYNAMIC.
+    struct {
+        uint32_t type;
+        uint32_t flags;
+        size_t offset;
+        size_t size;
+        size_t align;
+    } phdrs[phdr_count] = {
+        {1, 4 | 2 | 1, 0, load_end, 0x1000},
+        {2, 4 | 2, sh_offset[ShDynamic], sh_size[ShDynamic], addr_size},
+    };
+    for (size_t i = 0; i < phdr_count; i += 1) {
+        stub_elf_u32(&elf, phdrs[i].type);
+        if (elf.is_64)
+            stub_elf_u32(&elf, phdrs[i].flags);
+        stub_elf_word(&elf, phdrs[i].offset); // p_offset
+        stub_elf_word(&elf, phdrs[i].offset); // p_vaddr
+        stub_elf_word(&elf, phdrs[i].offset); // p_paddr
+        stub_elf_word(&elf, phdrs[i].size); // p_filesz
+        stub_elf_word(&elf, phdrs[i].size); // p_memsz
+        if (!elf.is_64)
+            stub_elf_u32(&elf, phdrs[i].flags);
+        stub_elf_word(&elf, phdrs[i].align);
+    }
+
+    // .hash
+    stub_elf_pad(&elf, sh_offset[ShHash]);
+    uint32_t *buckets = allocate<uint32_t>(nbucket);
+    uint32_t *chains = allocate<uint32_t>(syms.length);
+    for (size_t i = syms.length - 1; i >= 1; i -= 1) {
+        size_t bucket = syms.at(i).hash % nbucket;
+        chains[i] = buckets[bucket];
+        buckets[bucket] = i;
+    }
+    stub_elf_u32(&elf, nbucket);
+    stub_elf_u32(&elf, syms.length);
+    for (size_t i = 0; i < nbucket; i += 1) {
+        stub_elf_u32(&elf, buckets[i]);
+    }
+    for (size_t i = 0; i < syms.length; i += 1) {
+        stub_elf_u32(&elf, chains[i]);
+    }
+    deallocate(buckets, nbucket);
+    deallocate(chains, syms.length);
+
+    // .dynsym
+    stub_elf_pad(&elf, sh_offset[ShDynSym]);
+    for (size_t i = 0; i < syms.length; i += 1) {
+        bool is_null = (i == 0);
+        uint8_t info = is_null ? 0 : ((1 << 4) | 2); // STB_GLOBAL, STT_FUNC
+        uint16_t shndx = is_null ? 0 : ShText;
+        uint64_t value = is_null ? 0 : sh_offset[ShText];
+        stub_elf_u32(&elf, syms.at(i).name_offset);
+        if (elf.is_64) {
+            stub_elf_u8(&elf, info);
+            stub_elf_u8(&elf, 0); // STV_DEFAULT
+            stub_elf_u16(&elf, shndx);
+            stub_elf_u64(&elf, value);
+            stub_elf_u64(&elf, 0);
+        } else {
+            stub_elf_u32(&elf, value);
+            stub_elf_u32(&elf, 0);
+            stub_elf_u8(&elf, info);
+            stub_elf_u8(&elf, 0); // STV_DEFAULT
+            stub_elf_u16(&elf, shndx);
+        }
+    }
+
+    // .dynstr
+    stub_elf_pad(&elf, sh_offset[ShDynStr]);
+    buf_append_buf(elf.buf, dynstr);
+
+    // .gnu.version
+    stub_elf_pad(&elf, sh_offset[ShVerSym]);
+    for (size_t i = 0; i < syms.length; i += 1) {
+        stub_elf_u16(&elf, syms.at(i).versym);
+    }
+
+    // .gnu.version_d
+    stub_elf_pad(&elf, sh_offset[ShVerDef]);
+    for (size_t i = 0; i < verdef_count; i += 1) {
+        stub_elf_u16(&elf, 1); // VER_DEF_CURRENT
+        stub_elf_u16(&elf, (i == 0) ? 1 : 0); // VER_FLG_BASE
+        stub_elf_u16(&elf, i + 1); // vd_ndx
+        stub_elf_u16(&elf, 1); // vd_cnt
+        stub_elf_u32(&elf, verdef_hashes[i]);
+        stub_elf_u32(&elf, 20); // vd_aux
+        stub_elf_u32(&elf, (i + 1 == verdef_count) ? 0 : verdef_size); // vd_next
+        stub_elf_u32(&elf, verdef_name_offsets[i]); // vda_name
+        stub_elf_u32(&elf, 0); // vda_next
+    }
+
+    // .dynamic
+    stub_elf_pad(&elf, sh_offset[ShDynamic]);
+    uint64_t dyns[dyn_count][2] = {
+        {14, soname_offset}, // DT_SONAME
+        {4, sh_offset[ShHash]}, // DT_HASH
+        {5, sh_offset[ShDynStr]}, // DT_STRTAB
+        {6, sh_offset[ShDynSym]}, // DT_SYMTAB
+        {10, sh_size[ShDynStr]}, // DT_STRSZ
+        {11, sym_size}, // DT_SYMENT
+        {0x6ffffff0, sh_offset[ShVerSym]}, // DT_VERSYM
+        {0x6ffffffc, sh_offset[ShVerDef]}, // DT_VERDEF
+        {0x6ffffffd, verdef_count}, // DT_VERDEFNUM
+        {0, 0}, // DT_NULL
+    };
+    for (size_t i = 0; i < dyn_count; i += 1) {
+        stub_elf_word(&elf, dyns[i][0]);
+        stub_elf_word(&elf, dyns[i][1]);
+    }
+
+    // .shstrtab
+    stub_elf_pad(&elf, sh_offset[ShShStrTab]);
+    buf_append_buf(elf.buf, shstrtab);
+
+    // Section headers
+    stub_elf_pad(&elf, shdrs_offset);
+    struct {
+        uint32_t type;
+        uint64_t flags;
+        uint32_t link;
+        uint32_t info;
+        size_t align;
+        size_t entsize;
+    } shdrs[ShCount] = {
+        {0, 0, 0, 0, 0, 0},
+        {5, 2, ShDynSym, 0, 4, 4}, // SHT_HASH, SHF_ALLOC
+        {11, 2, ShDynStr, 1, addr_size, sym_size}, // SHT_DYNSYM, SHF_ALLOC
+        {3, 2, 0, 0, 1, 0}, // SHT_STRTAB, SHF_ALLOC
+        {0x6fffffff, 2, ShDynSym, 0, 2, 2}, // SHT_GNU_versym, SHF_ALLOC
+        {0x6ffffffd, 2, ShDynStr, (uint32_t)verdef_count, 4, 0}, // SHT_GNU_verdef, SHF_ALLOC
+        {1, 2 | 4, 0, 0, 16, 0}, // SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR
+        {6, 2 | 1, ShDynStr, 0, addr_size, dyn_size}, // SHT_DYNAMIC, SHF_ALLOC | SHF_WRITE
+        {3, 0, 0, 0, 1, 0}, // SHT_STRTAB
+    };
+    for (size_t i = 0; i < ShCount; i += 1) {
+        bool is_alloc = (shdrs[i].flags & 2) != 0;
+        stub_elf_u32(&elf, sh_name[i]);
+        stub_elf_u32(&elf, shdrs[i].type);
+        stub_elf_word(&elf, shdrs[i].flags);
+        stub_elf_word(&elf, is_alloc ? sh_offset[i] : 0); // sh_addr
+        stub_elf_word(&elf, sh_offset[i]);
+        stub_elf_word(&elf, sh_size[i]);
+        stub_elf_u32(&elf, shdrs[i].link);
+        stub_elf_u32(&elf, shdrs[i].info);
+        stub_elf_word(&elf, shdrs[i].align);
+        stub_elf_word(&elf, shdrs[i].entsize);
+    }
+
+    syms.deinit();
+    dynstr_offsets.deinit();
+    deallocate(verdef_name_offsets, verdef_count);
+    deallocate(verdef_hashes, verdef_count);
+    return ErrorNone;
+}
+
 Error glibc_build_dummies_and_maps(CodeGen *g, const ZigGLibCAbi *glibc_abi, const ZigTarget *target,
         Buf **out_dir, bool verbose, Stage2ProgressNode *progress_node)
 {
@@ -244,102 +957,23 @@ Error glibc_build_dummies_and_maps(CodeGen *g, const ZigGLibCAbi *glibc_abi, con
         return ErrorUnknownABI;
     }
 
-    Buf *map_file_path = buf_sprintf("%s" OS_SEP "all.map", buf_ptr(dummy_dir));
-    Buf *map_contents = buf_alloc();
-
-    for (uint8_t ver_i = 0; ver_i < glibc_abi->all_versions.length; ver_i += 1) {
-        const ZigGLibCVersion *ver = &glibc_abi->all_versions.at(ver_i);
-        if (ver->patch == 0) {
-            buf_appendf(map_contents, "GLIBC_%d.%d { };\n", ver->major, ver->minor);
-        } else {
-            buf_appendf(map_contents, "GLIBC_%d.%d.%d { };\n", ver->major, ver->minor, ver->patch);
-        }
-    }
-
-    if ((err = os_write_file(map_file_path, map_contents))) {
-        if (verbose) {
-            fprintf(stderr, "unable to write %s: %s", buf_ptr(map_file_path), err_str(err));
-        }
-        return err;
-    }
-
-
     for (size_t lib_i = 0; lib_i < array_length(glibc_libs); lib_i += 1) {
         const ZigGLibCLib *lib = &glibc_libs[lib_i];
-        Buf *zig_file_path = buf_sprintf("%s" OS_SEP "%s.zig", buf_ptr(dummy_dir), lib->name);
-        Buf *zig_body = buf_alloc();
-        Buf *zig_footer = buf_alloc();
-
-        buf_appendf(zig_body, "comptime {\n");
-        buf_appendf(zig_body, "    asm (\n");
-
-        for (size_t fn_i = 0; fn_i < glibc_abi->all_functions.length; fn_i += 1) {
-            const ZigGLibCFn *libc_fn = &glibc_abi->all_functions.at(fn_i);
-            if (libc_fn->lib != lib) continue;
-            ZigGLibCVerList *ver_list = &ver_list_base[fn_i];
-            // Pick the default symbol version:
-            // - If there are no versions, don't emit it
-            // - Take the greatest one <= than the target one
-            // - If none of them is <= than the
-            //   specified one don't pick any default version
-            if (ver_list->len == 0) continue;
-            uint8_t chosen_def_ver_index = 255;
-            for (uint8_t ver_i = 0; ver_i < ver_list->len; ver_i += 1) {
-                uint8_t ver_index = ver_list->versions[ver_i];
-                if ((chosen_def_ver_index == 255 || ver_index > chosen_def_ver_index) &&
-                    target_ver_index >= ver_index)
-                {
-                    chosen_def_ver_index = ver_index;
-                }
-            }
-            for (uint8_t ver_i = 0; ver_i < ver_list->len; ver_i += 1) {
-                uint8_t ver_index = ver_list->versions[ver_i];
-
-                Buf *stub_name;
-                const ZigGLibCVersion *ver = &glibc_abi->all_versions.at(ver_index);
-                const char *sym_name = buf_ptr(libc_fn->name);
-                if (ver->patch == 0) {
-                    stub_name = buf_sprintf("%s_%d_%d", sym_name, ver->major, ver->minor);
-                } else {
-                    stub_name = buf_sprintf("%s_%d_%d_%d", sym_name, ver->major, ver->minor, ver->patch);
-                }
-
-                buf_appendf(zig_footer, "export fn %s() void {}\n", buf_ptr(stub_name));
-
-                // Default symbol version definition vs normal symbol version definition
-                const char *at_sign_str = (chosen_def_ver_index != 255 &&
-                        ver_index == chosen_def_ver_index) ? "@@" : "@";
-                if (ver->patch == 0) {
-                    buf_appendf(zig_body, "        \\\\ .symver %s, %s%sGLIBC_%d.%d\n",
-                            buf_ptr(stub_name), sym_name, at_sign_str, ver->major, ver->minor);
-                } else {
-                    buf_appendf(zig_body, "        \\\\ .symver %s, %s%sGLIBC_%d.%d.%d\n",
-                            buf_ptr(stub_name), sym_name, at_sign_str, ver->major, ver->minor, ver->patch);
-                }
-                // Hide the stub to keep the symbol table clean
-                buf_appendf(zig_body, "        \\\\ .hidden %s\n", buf_ptr(stub_name));
+        Buf *so_path = buf_sprintf("%s" OS_SEP "lib%s.so.%d.0.0", buf_ptr(dummy_dir), lib->name, lib->sover);
+        Buf *so_contents = buf_alloc();
+        if ((err = glibc_write_stub_so(glibc_abi, target, ver_list_base, target_ver_index, lib, so_contents))) {
+            if (verbose) {
+                fprintf(stderr, "unable to generate %s: %s\n", buf_ptr(so_path), err_str(err));
             }
+            return err;
         }
-
-        buf_appendf(zig_body, "    );\n");
-        buf_appendf(zig_body, "}\n");
-        buf_append_buf(zig_body, zig_footer);
-
-        if ((err = os_write_file(zig_file_path, zig_body))) {
+        if ((err = os_write_file(so_path, so_contents))) {
             if (verbose) {
-                fprintf(stderr, "unable to write %s: %s", buf_ptr(zig_file_path), err_str(err));
+                fprintf(stderr, "unable to write %s: %s\n", buf_ptr(so_path), err_str(err));
             }
             return err;
         }
-
-        CodeGen *child_gen = create_child_codegen(g, zig_file_path, OutTypeLib, nullptr, lib->name, progress_node);
-        codegen_set_lib_version(child_gen, lib->sover, 0, 0);
-        child_gen->is_dynamic = true;
-        child_gen->is_dummy_so = true;
-        child_gen->version_script_path = map_file_path;
-        child_gen->enable_cache = false;
-        child_gen->output_dir = dummy_dir;
-        codegen_build_and_link(child_gen);
+        buf_destroy(so_contents);
     }
 
     if ((err = os_write_file(test_if_exists_path, buf_alloc()))) {
@@ -411,10 +1045,17 @@ const ZigGLibCLib *glibc_lib_enum(size_t index) {
 }
 
 const ZigGLibCLib *glibc_lib_find(const char *name) {
-    for (size_t i = 0; i < array_length(glibc_libs); i += 1) {
-        if (strcmp(glibc_libs[i].name, name) == 0) {
-            return &glibc_libs[i];
-        }
+    // The first letter of each name in glibc_libs is unique, which makes it a perfect
+    // hash; keep this in sync with that table.
+    size_t index;
+    switch (name[0]) {
+        case 'c': index = 0; break;
+        case 'm': index = 1; break;
+        case 'p': index = 2; break;
+        case 'd': index = 3; break;
+        case 'r': index = 4; break;
+        default: return nullptr;
     }
-    return nullptr;
+    const ZigGLibCLib *lib = &glibc_libs[index];
+    return (strcmp(lib->name, name) == 0) ? lib : nullptr;
 }
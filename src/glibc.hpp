@@ -16,7 +16,7 @@ struct ZigGLibCLib {
 };
 
 struct ZigGLibCFn {
-    Buf *name;
+    const char *name;
     const ZigGLibCLib *lib;
 };
 
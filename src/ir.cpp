@@ -7,6 +7,7 @@
 
 #include "analyze.hpp"
 #include "ast_render.hpp"
+#include "codegen.hpp"
 #include "error.hpp"
 #include "ir.hpp"
 #include "ir_print.hpp"
@@ -26948,3 +26949,470 @@ Error ir_resolve_lazy(CodeGen *codegen, AstNode *source_node, ConstExprValue *va
     }
     return ErrorNone;
 }
+
+// Redundant runtime safety check elimination. This runs over the analyzed IR of a function and
+// turns off safety checks that an earlier check, or the condition of a branch that was taken,
+// already proves on every path to them. Facts only flow forward through the basic block list;
+// a block with a predecessor later in the list is a loop header and starts with no facts.
+// Hoisting checks out of loops is not done: a loop body only benefits from the loop condition,
+// as in `while (i < a.len) : (i += 1) a[i]`.
+
+enum SafetyFactId {
+    SafetyFactIdInBounds,
+    SafetyFactIdNoOverflow,
+    SafetyFactIdNonNull,
+    SafetyFactIdUnionField,
+};
+
+struct SafetyFact {
+    SafetyFactId id;
+    // InBounds: the index. NoOverflow: the first operand. NonNull, UnionField: the variable.
+    const void *a;
+    // InBounds: the slice variable, or null for a comptime-known length.
+    // NoOverflow: the second operand. UnionField: the field.
+    const void *b;
+    // InBounds: the comptime-known length. NoOverflow: the IrBinOp.
+    uint64_t n;
+};
+
+struct SafetyEdge {
+    size_t from_index;
+    // When true, the edge is only taken when the branch condition at the end of the predecessor
+    // is true.
+    bool on_true;
+};
+
+struct SafetyElim {
+    CodeGen *codegen;
+    // Constant locals that have their own storage, and constant parameters. After being
+    // initialized they only change when the for loop index is incremented, which is a store
+    // through a VarPtr.
+    HashMap<const void *, bool, ptr_hash, ptr_eq> stable_vars;
+    // Mutable integer locals whose address is only ever loaded from and stored to, such as a
+    // while loop counter. Only stores through a VarPtr change them.
+    HashMap<const void *, bool, ptr_hash, ptr_eq> counter_vars;
+    // Loads of counter variables in the current block with no store to the variable after them.
+    // They still hold the variable's value.
+    ZigList<IrInstruction *> fresh_loads;
+    size_t removed_count;
+};
+
+static ZigVar *safety_stable_var(SafetyElim *se, IrInstruction *ptr) {
+    if (ptr->id != IrInstructionIdVarPtr)
+        return nullptr;
+    ZigVar *var = reinterpret_cast<IrInstructionVarPtr *>(ptr)->var;
+    if (var->src_is_const && (var->src_arg_index != SIZE_MAX || se->stable_vars.maybe_get(var) != nullptr))
+        return var;
+    return nullptr;
+}
+
+static ZigVar *safety_counter_var(SafetyElim *se, IrInstruction *ptr) {
+    if (ptr->id != IrInstructionIdVarPtr)
+        return nullptr;
+    ZigVar *var = reinterpret_cast<IrInstructionVarPtr *>(ptr)->var;
+    if (se->counter_vars.maybe_get(var) != nullptr)
+        return var;
+    return nullptr;
+}
+
+// Uses of a runtime value get the same key when they hold the same value: the same instruction,
+// loads of the same stable variable, or fresh loads of the same counter variable.
+static const void *safety_value_key(SafetyElim *se, IrInstruction *value) {
+    if (value->id == IrInstructionIdLoadPtrGen) {
+        IrInstruction *ptr = reinterpret_cast<IrInstructionLoadPtrGen *>(value)->ptr;
+        ZigVar *var = safety_stable_var(se, ptr);
+        if (var != nullptr)
+            return var;
+        var = safety_counter_var(se, ptr);
+        if (var != nullptr) {
+            for (size_t i = 0; i < se->fresh_loads.length; i += 1) {
+                if (se->fresh_loads.at(i) == value)
+                    return var;
+            }
+        }
+    }
+    return value;
+}
+
+// The length a bounds check compares against, or false if it cannot be tracked.
+static bool safety_len(SafetyElim *se, IrInstruction *len, SafetyFact *fact) {
+    if (len->value.special != ConstValSpecialRuntime) {
+        if (len->value.type->id != ZigTypeIdInt && len->value.type->id != ZigTypeIdComptimeInt)
+            return false;
+        if (!bigint_fits_in_bits(&len->value.data.x_bigint, 64, false))
+            return false;
+        fact->b = nullptr;
+        fact->n = bigint_as_u64(&len->value.data.x_bigint);
+        return true;
+    }
+    if (len->id != IrInstructionIdLoadPtrGen)
+        return false;
+    IrInstruction *len_ptr = reinterpret_cast<IrInstructionLoadPtrGen *>(len)->ptr;
+    if (len_ptr->id != IrInstructionIdStructFieldPtr)
+        return false;
+    IrInstructionStructFieldPtr *field_ptr = reinterpret_cast<IrInstructionStructFieldPtr *>(len_ptr);
+    ZigType *struct_type = field_ptr->struct_ptr->value.type->data.pointer.child_type;
+    if (!is_slice(struct_type) || field_ptr->field != &struct_type->data.structure.fields[slice_len_index])
+        return false;
+    ZigVar *var = safety_stable_var(se, field_ptr->struct_ptr);
+    if (var == nullptr)
+        return false;
+    fact->b = var;
+    fact->n = 0;
+    return true;
+}
+
+static bool safety_fact_known(ZigList<SafetyFact> *facts, const SafetyFact *fact) {
+    for (size_t i = 0; i < facts->length; i += 1) {
+        const SafetyFact *known = &facts->at(i);
+        if (known->id != fact->id || known->a != fact->a || known->b != fact->b)
+            continue;
+        if (fact->id == SafetyFactIdInBounds && fact->b == nullptr) {
+            // Being below a shorter comptime-known length implies being below a longer one.
+            if (known->n <= fact->n)
+                return true;
+        } else if (known->n == fact->n) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void safety_add_fact(ZigList<SafetyFact> *facts, const SafetyFact &fact) {
+    if (!safety_fact_known(facts, &fact))
+        facts->append(fact);
+}
+
+static void safety_add_condition_facts(SafetyElim *se, ZigList<SafetyFact> *facts, IrInstruction *condition) {
+    if (condition->id == IrInstructionIdTestNonNull) {
+        IrInstruction *value = reinterpret_cast<IrInstructionTestNonNull *>(condition)->value;
+        if (value->id != IrInstructionIdLoadPtrGen)
+            return;
+        ZigVar *var = safety_stable_var(se, reinterpret_cast<IrInstructionLoadPtrGen *>(value)->ptr);
+        if (var != nullptr)
+            safety_add_fact(facts, {SafetyFactIdNonNull, var, nullptr, 0});
+        return;
+    }
+    if (condition->id != IrInstructionIdBinOp)
+        return;
+    IrInstructionBinOp *bin_op = reinterpret_cast<IrInstructionBinOp *>(condition);
+    IrInstruction *index;
+    IrInstruction *len;
+    if (bin_op->op_id == IrBinOpCmpLessThan) {
+        index = bin_op->op1;
+        len = bin_op->op2;
+    } else if (bin_op->op_id == IrBinOpCmpGreaterThan) {
+        index = bin_op->op2;
+        len = bin_op->op1;
+    } else {
+        return;
+    }
+    ZigType *index_type = index->value.type;
+    if (index_type->id != ZigTypeIdInt || index_type->data.integral.is_signed)
+        return;
+    SafetyFact fact = {SafetyFactIdInBounds, safety_value_key(se, index), nullptr, 0};
+    if (safety_len(se, len, &fact))
+        safety_add_fact(facts, fact);
+}
+
+// Returns true if the check is redundant. Otherwise the check establishes its fact for the
+// instructions after it.
+static bool safety_check(SafetyElim *se, ZigList<SafetyFact> *facts, const SafetyFact &fact) {
+    if (safety_fact_known(facts, &fact)) {
+        se->removed_count += 1;
+        return true;
+    }
+    facts->append(fact);
+    return false;
+}
+
+static void safety_elim_elem_ptr(SafetyElim *se, ZigList<SafetyFact> *facts, IrInstructionElemPtr *elem_ptr) {
+    ZigType *array_ptr_type = elem_ptr->array_ptr->value.type;
+    ZigType *array_type = array_ptr_type->data.pointer.child_type;
+    if (!type_has_bits(array_type))
+        return;
+    SafetyFact fact = {SafetyFactIdInBounds, safety_value_key(se, elem_ptr->elem_index), nullptr, 0};
+    if (array_type->id == ZigTypeIdPointer && array_type->data.pointer.ptr_len == PtrLenSingle)
+        array_type = array_type->data.pointer.child_type;
+    if (array_type->id == ZigTypeIdArray) {
+        fact.n = array_type->data.array.len;
+    } else if (is_slice(array_type) && type_has_bits(elem_ptr->base.value.type)) {
+        ZigVar *var = safety_stable_var(se, elem_ptr->array_ptr);
+        if (var == nullptr)
+            return;
+        fact.b = var;
+    } else {
+        return;
+    }
+    if (safety_check(se, facts, fact))
+        elem_ptr->safety_check_on = false;
+}
+
+static void safety_elim_bin_op(SafetyElim *se, ZigList<SafetyFact> *facts, IrInstructionBinOp *bin_op) {
+    if (bin_op->op_id != IrBinOpAdd && bin_op->op_id != IrBinOpSub && bin_op->op_id != IrBinOpMult)
+        return;
+    ZigType *type = bin_op->base.value.type;
+    if (type->id != ZigTypeIdInt)
+        return;
+    const void *key1 = safety_value_key(se, bin_op->op1);
+    const void *key2 = safety_value_key(se, bin_op->op2);
+    if (bin_op->op_id == IrBinOpAdd && !type->data.integral.is_signed) {
+        // Anything known to be below some length is below the maximum, so adding one cannot
+        // overflow.
+        IrInstruction *one = nullptr;
+        const void *other_key = nullptr;
+        if (bin_op->op2->value.special != ConstValSpecialRuntime) {
+            one = bin_op->op2;
+            other_key = key1;
+        } else if (bin_op->op1->value.special != ConstValSpecialRuntime) {
+            one = bin_op->op1;
+            other_key = key2;
+        }
+        if (one != nullptr && bigint_cmp_zero(&one->value.data.x_bigint) != CmpLT &&
+            bigint_fits_in_bits(&one->value.data.x_bigint, 1, false))
+        {
+            for (size_t i = 0; i < facts->length; i += 1) {
+                if (facts->at(i).id == SafetyFactIdInBounds && facts->at(i).a == other_key) {
+                    se->removed_count += 1;
+                    bin_op->safety_check_on = false;
+                    return;
+                }
+            }
+        }
+    }
+    if (safety_check(se, facts, {SafetyFactIdNoOverflow, key1, key2, (uint64_t)bin_op->op_id}))
+        bin_op->safety_check_on = false;
+}
+
+static void safety_kill_var(SafetyElim *se, ZigList<SafetyFact> *facts, ZigVar *var) {
+    size_t kept = 0;
+    for (size_t i = 0; i < facts->length; i += 1) {
+        if (facts->at(i).a != var && facts->at(i).b != var) {
+            facts->items[kept] = facts->at(i);
+            kept += 1;
+        }
+    }
+    facts->resize(kept);
+
+    kept = 0;
+    for (size_t i = 0; i < se->fresh_loads.length; i += 1) {
+        IrInstruction *ptr = reinterpret_cast<IrInstructionLoadPtrGen *>(se->fresh_loads.at(i))->ptr;
+        if (reinterpret_cast<IrInstructionVarPtr *>(ptr)->var != var) {
+            se->fresh_loads.items[kept] = se->fresh_loads.at(i);
+            kept += 1;
+        }
+    }
+    se->fresh_loads.resize(kept);
+}
+
+static void safety_elim_instruction(SafetyElim *se, ZigList<SafetyFact> *facts, IrInstruction *instruction) {
+    // Codegen skips these, checks included.
+    if (instruction->ref_count == 0 && !ir_has_side_effects(instruction))
+        return;
+
+    switch (instruction->id) {
+        case IrInstructionIdElemPtr: {
+            IrInstructionElemPtr *elem_ptr = reinterpret_cast<IrInstructionElemPtr *>(instruction);
+            if (elem_ptr->safety_check_on && ir_want_runtime_safety_scope(se->codegen, instruction->scope))
+                safety_elim_elem_ptr(se, facts, elem_ptr);
+            return;
+        }
+        case IrInstructionIdBinOp: {
+            IrInstructionBinOp *bin_op = reinterpret_cast<IrInstructionBinOp *>(instruction);
+            if (bin_op->safety_check_on && ir_want_runtime_safety_scope(se->codegen, instruction->scope))
+                safety_elim_bin_op(se, facts, bin_op);
+            return;
+        }
+        case IrInstructionIdOptionalUnwrapPtr: {
+            IrInstructionOptionalUnwrapPtr *unwrap = reinterpret_cast<IrInstructionOptionalUnwrapPtr *>(instruction);
+            if (!unwrap->safety_check_on || unwrap->initializing ||
+                !ir_want_runtime_safety_scope(se->codegen, instruction->scope))
+            {
+                return;
+            }
+            ZigVar *var = safety_stable_var(se, unwrap->base_ptr);
+            if (var != nullptr && safety_check(se, facts, {SafetyFactIdNonNull, var, nullptr, 0}))
+                unwrap->safety_check_on = false;
+            return;
+        }
+        case IrInstructionIdUnionFieldPtr: {
+            IrInstructionUnionFieldPtr *field_ptr = reinterpret_cast<IrInstructionUnionFieldPtr *>(instruction);
+            if (!field_ptr->safety_check_on || field_ptr->initializing ||
+                !ir_want_runtime_safety_scope(se->codegen, instruction->scope))
+            {
+                return;
+            }
+            ZigVar *var = safety_stable_var(se, field_ptr->union_ptr);
+            if (var != nullptr && safety_check(se, facts, {SafetyFactIdUnionField, var, field_ptr->field, 0}))
+                field_ptr->safety_check_on = false;
+            return;
+        }
+        case IrInstructionIdLoadPtrGen: {
+            if (safety_counter_var(se, reinterpret_cast<IrInstructionLoadPtrGen *>(instruction)->ptr) != nullptr)
+                se->fresh_loads.append(instruction);
+            return;
+        }
+        case IrInstructionIdStorePtr: {
+            IrInstruction *ptr = reinterpret_cast<IrInstructionStorePtr *>(instruction)->ptr;
+            if (ptr->id == IrInstructionIdVarPtr)
+                safety_kill_var(se, facts, reinterpret_cast<IrInstructionVarPtr *>(ptr)->var);
+            return;
+        }
+        case IrInstructionIdDeclVarGen:
+            // A local declared in a loop body is initialized again on every iteration.
+            safety_kill_var(se, facts, reinterpret_cast<IrInstructionDeclVarGen *>(instruction)->var);
+            return;
+        default:
+            return;
+    }
+}
+
+size_t ir_remove_redundant_safety_checks(CodeGen *codegen, IrExecutable *exec) {
+    size_t block_count = exec->basic_block_list.length;
+    if (block_count == 0)
+        return 0;
+
+    SafetyElim se = {};
+    se.codegen = codegen;
+    se.stable_vars.init(16);
+    se.counter_vars.init(16);
+
+    // How many uses of each VarPtr only load from it or store to it.
+    HashMap<const void *, size_t, ptr_hash, ptr_eq> var_ptr_uses = {};
+    var_ptr_uses.init(16);
+    ZigList<IrInstructionVarPtr *> var_ptrs = {};
+
+    ZigList<SafetyEdge> *preds = allocate<ZigList<SafetyEdge>>(block_count);
+    for (size_t block_i = 0; block_i < block_count; block_i += 1) {
+        exec->basic_block_list.at(block_i)->index = block_i;
+    }
+    for (size_t block_i = 0; block_i < block_count; block_i += 1) {
+        IrBasicBlock *block = exec->basic_block_list.at(block_i);
+        for (size_t instr_i = 0; instr_i < block->instruction_list.length; instr_i += 1) {
+            IrInstruction *instruction = block->instruction_list.at(instr_i);
+            switch (instruction->id) {
+                case IrInstructionIdDeclVarGen: {
+                    IrInstructionDeclVarGen *decl_var = reinterpret_cast<IrInstructionDeclVarGen *>(instruction);
+                    if (decl_var->var_ptr->id != IrInstructionIdAllocaGen)
+                        break;
+                    if (decl_var->var->src_is_const) {
+                        se.stable_vars.put(decl_var->var, true);
+                    } else if (decl_var->var->var_type->id == ZigTypeIdInt) {
+                        se.counter_vars.put(decl_var->var, true);
+                    }
+                    break;
+                }
+                case IrInstructionIdVarPtr:
+                    var_ptrs.append(reinterpret_cast<IrInstructionVarPtr *>(instruction));
+                    break;
+                case IrInstructionIdLoadPtrGen:
+                case IrInstructionIdStorePtr: {
+                    IrInstruction *ptr = (instruction->id == IrInstructionIdLoadPtrGen) ?
+                        reinterpret_cast<IrInstructionLoadPtrGen *>(instruction)->ptr :
+                        reinterpret_cast<IrInstructionStorePtr *>(instruction)->ptr;
+                    if (ptr->id != IrInstructionIdVarPtr)
+                        break;
+                    auto entry = var_ptr_uses.maybe_get(ptr);
+                    var_ptr_uses.put(ptr, (entry == nullptr) ? 1 : entry->value + 1);
+                    break;
+                }
+                case IrInstructionIdBr: {
+                    IrInstructionBr *br = reinterpret_cast<IrInstructionBr *>(instruction);
+                    preds[br->dest_block->index].append({block_i, false});
+                    break;
+                }
+                case IrInstructionIdCondBr: {
+                    IrInstructionCondBr *cond_br = reinterpret_cast<IrInstructionCondBr *>(instruction);
+                    preds[cond_br->then_block->index].append({block_i, true});
+                    preds[cond_br->else_block->index].append({block_i, false});
+                    break;
+                }
+                case IrInstructionIdSwitchBr: {
+                    IrInstructionSwitchBr *switch_br = reinterpret_cast<IrInstructionSwitchBr *>(instruction);
+                    preds[switch_br->else_block->index].append({block_i, false});
+                    for (size_t case_i = 0; case_i < switch_br->case_count; case_i += 1) {
+                        preds[switch_br->cases[case_i].block->index].append({block_i, false});
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+    // A counter variable whose address is used for anything else may change behind our back.
+    for (size_t i = 0; i < var_ptrs.length; i += 1) {
+        auto entry = var_ptr_uses.maybe_get(&var_ptrs.at(i)->base);
+        if (entry == nullptr || entry->value != var_ptrs.at(i)->base.ref_count)
+            se.counter_vars.maybe_remove(var_ptrs.at(i)->var);
+    }
+
+    ZigList<SafetyFact> *facts_out = allocate<ZigList<SafetyFact>>(block_count);
+    // What the branch condition at the end of each block proves when it is true.
+    ZigList<SafetyFact> *condition_facts = allocate<ZigList<SafetyFact>>(block_count);
+    ZigList<SafetyFact> edge_facts = {};
+    for (size_t block_i = 0; block_i < block_count; block_i += 1) {
+        IrBasicBlock *block = exec->basic_block_list.at(block_i);
+        ZigList<SafetyFact> *facts = &facts_out[block_i];
+
+        bool loop_header = (block_i == 0 || preds[block_i].length == 0);
+        for (size_t pred_i = 0; pred_i < preds[block_i].length; pred_i += 1) {
+            if (preds[block_i].at(pred_i).from_index >= block_i)
+                loop_header = true;
+        }
+        for (size_t pred_i = 0; !loop_header && pred_i < preds[block_i].length; pred_i += 1) {
+            const SafetyEdge &edge = preds[block_i].at(pred_i);
+            edge_facts.clear();
+            for (size_t fact_i = 0; fact_i < facts_out[edge.from_index].length; fact_i += 1) {
+                edge_facts.append(facts_out[edge.from_index].at(fact_i));
+            }
+            if (edge.on_true) {
+                for (size_t fact_i = 0; fact_i < condition_facts[edge.from_index].length; fact_i += 1) {
+                    safety_add_fact(&edge_facts, condition_facts[edge.from_index].at(fact_i));
+                }
+            }
+
+            if (pred_i == 0) {
+                for (size_t fact_i = 0; fact_i < edge_facts.length; fact_i += 1) {
+                    facts->append(edge_facts.at(fact_i));
+                }
+            } else {
+                size_t kept = 0;
+                for (size_t fact_i = 0; fact_i < facts->length; fact_i += 1) {
+                    if (safety_fact_known(&edge_facts, &facts->at(fact_i))) {
+                        facts->items[kept] = facts->at(fact_i);
+                        kept += 1;
+                    }
+                }
+                facts->resize(kept);
+            }
+        }
+
+        se.fresh_loads.clear();
+        for (size_t instr_i = 0; instr_i < block->instruction_list.length; instr_i += 1) {
+            safety_elim_instruction(&se, facts, block->instruction_list.at(instr_i));
+        }
+        // Computed here, while the loads of counter variables in this block are known to be fresh.
+        IrInstruction *terminator = block->instruction_list.last();
+        if (terminator->id == IrInstructionIdCondBr) {
+            IrInstruction *condition = reinterpret_cast<IrInstructionCondBr *>(terminator)->condition;
+            safety_add_condition_facts(&se, &condition_facts[block_i], condition);
+        }
+    }
+
+    for (size_t block_i = 0; block_i < block_count; block_i += 1) {
+        preds[block_i].deinit();
+        facts_out[block_i].deinit();
+        condition_facts[block_i].deinit();
+    }
+    deallocate(preds, block_count);
+    deallocate(facts_out, block_count);
+    deallocate(condition_facts, block_count);
+    edge_facts.deinit();
+    var_ptrs.deinit();
+    var_ptr_uses.deinit();
+    se.fresh_loads.deinit();
+    se.stable_vars.deinit();
+    se.counter_vars.deinit();
+    return se.removed_count;
+}
@@ -1504,6 +1504,10 @@ static Buf *build_a_raw(CodeGen *parent_gen, const char *aname, Buf *full_path,
 
     child_gen->function_sections = true;
     child_gen->want_stack_check = WantStackCheckDisabled;
+    // As bitcode these take part in ThinLTO with the rest of the program. LLD pulls in
+    // bitcode definitions of runtime library calls before running the LTO backend, so
+    // calls that only appear during code generation still resolve.
+    child_gen->thin_lto = parent_gen->thin_lto;
 
     codegen_build_and_link(child_gen);
     return &child_gen->output_file_path;
@@ -1628,6 +1632,40 @@ static void add_glibc_libs(LinkJob *lj) {
     }
 }
 
+static const char *thin_lto_opt_level(CodeGen *g) {
+    switch (g->build_mode) {
+        case BuildModeDebug:
+            return "0";
+        case BuildModeSmallRelease:
+            return "2";
+        case BuildModeFastRelease:
+        case BuildModeSafeRelease:
+            return "3";
+    }
+    zig_unreachable();
+}
+
+// Code generated by the ThinLTO backend is cached per module, so a rebuild only
+// recompiles the modules whose bitcode or imports changed.
+static const char *thin_lto_cache_dir(CodeGen *g) {
+    return buf_ptr(buf_sprintf("%s" OS_SEP CACHE_THINLTO_SUBDIR, buf_ptr(g->cache_dir)));
+}
+
+// The output path changes with every cache hash, so the state of incremental
+// links is kept per output name and target rather than next to the output.
+static const char *incremental_state_path(CodeGen *g) {
+    Buf *dir = buf_sprintf("%s" OS_SEP CACHE_INCREMENTAL_SUBDIR, buf_ptr(g->cache_dir));
+    Error err;
+    if ((err = os_make_path(dir))) {
+        fprintf(stderr, "Unable to create directory '%s': %s\n", buf_ptr(dir), err_str(err));
+        exit(1);
+    }
+    Buf triple_buf = BUF_INIT;
+    target_triple_zig(&triple_buf, g->zig_target);
+    return buf_ptr(buf_sprintf("%s" OS_SEP "%s-%s.state", buf_ptr(dir), buf_ptr(g->root_out_name),
+                buf_ptr(&triple_buf)));
+}
+
 static void construct_linker_job_elf(LinkJob *lj) {
     CodeGen *g = lj->codegen;
 
@@ -1647,6 +1685,38 @@ static void construct_linker_job_elf(LinkJob *lj) {
         lj->args.append("--gc-sections");
     }
 
+    if (g->linker_compress_debug_sections && !g->strip_debug_symbols) {
+        lj->args.append("--compress-debug-sections=zlib");
+    }
+
+    if (g->linker_icf != LinkerIcfNone && g->out_type != OutTypeObj) {
+        lj->args.append((g->linker_icf == LinkerIcfSafe) ? "--icf=safe" : "--icf=all");
+        if (g->verbose_link) {
+            // Lists the folded sections and the total number of bytes saved.
+            lj->args.append("--print-icf-sections");
+        }
+    }
+
+    if (g->linker_incremental && g->out_type != OutTypeObj) {
+        lj->args.append("--incremental");
+        lj->args.append(buf_ptr(buf_sprintf("--incremental-state=%s", incremental_state_path(g))));
+    }
+
+    if (g->symbol_ordering_file_path != nullptr && g->out_type != OutTypeObj) {
+        // Lay out profiled functions hottest first, and keep the .text.hot and
+        // .text.unlikely groups that codegen assigned from the same profile.
+        lj->args.append("--symbol-ordering-file");
+        lj->args.append(buf_ptr(g->symbol_ordering_file_path));
+        lj->args.append("--no-warn-symbol-ordering");
+        lj->args.append("-z");
+        lj->args.append("keep-text-section-prefix");
+    }
+
+    if (g->thin_lto) {
+        lj->args.append(buf_ptr(buf_sprintf("--lto-O%s", thin_lto_opt_level(g))));
+        lj->args.append(buf_ptr(buf_sprintf("--thinlto-cache-dir=%s", thin_lto_cache_dir(g))));
+    }
+
     lj->args.append("-m");
     lj->args.append(getLDMOption(g->zig_target));
 
@@ -1755,7 +1825,7 @@ static void construct_linker_job_elf(LinkJob *lj) {
         lj->args.append((const char *)buf_ptr(g->link_objects.at(i)));
     }
 
-    if (!g->is_dummy_so && (g->out_type == OutTypeExe || is_dyn_lib)) {
+    if (g->out_type == OutTypeExe || is_dyn_lib) {
         if (g->libc_link_lib == nullptr) {
             Buf *libc_a_path = build_c(g, OutTypeLib, lj->build_dep_prog_node);
             lj->args.append(buf_ptr(libc_a_path));
@@ -1860,6 +1930,10 @@ static void construct_linker_job_wasm(LinkJob *lj) {
         }
     }
     lj->args.append("--allow-undefined");
+    if (g->thin_lto) {
+        lj->args.append(buf_ptr(buf_sprintf("--lto-O%s", thin_lto_opt_level(g))));
+        lj->args.append(buf_ptr(buf_sprintf("--thinlto-cache-dir=%s", thin_lto_cache_dir(g))));
+    }
     lj->args.append("-o");
     lj->args.append(buf_ptr(&g->output_file_path));
 
@@ -2218,7 +2292,9 @@ static void construct_linker_job_coff(LinkJob *lj) {
     lj->args.append("-NOLOGO");
 
     if (!g->strip_debug_symbols) {
-        lj->args.append("-DEBUG");
+        // Our objects carry .debug$H global type hashes, which lets LLD merge
+        // CodeView types in parallel.
+        lj->args.append("-DEBUG:GHASH");
     }
 
     if (g->out_type == OutTypeExe) {
@@ -2228,6 +2304,11 @@ static void construct_linker_job_coff(LinkJob *lj) {
 
     coff_append_machine_arg(g, &lj->args);
 
+    if (g->thin_lto) {
+        lj->args.append(buf_ptr(buf_sprintf("-OPT:lldlto=%s", thin_lto_opt_level(g))));
+        lj->args.append(buf_ptr(buf_sprintf("-lldltocache:%s", thin_lto_cache_dir(g))));
+    }
+
     bool is_library = g->out_type == OutTypeLib;
     if (is_library && g->is_dynamic) {
         lj->args.append("-DLL");
@@ -2300,7 +2381,7 @@ static void construct_linker_job_coff(LinkJob *lj) {
     }
 
     if (g->out_type == OutTypeExe || (g->out_type == OutTypeLib && g->is_dynamic)) {
-        if (g->libc_link_lib == nullptr && !g->is_dummy_so) {
+        if (g->libc_link_lib == nullptr) {
             Buf *libc_a_path = build_c(g, OutTypeLib, lj->build_dep_prog_node);
             lj->args.append(buf_ptr(libc_a_path));
         }
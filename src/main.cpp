@@ -64,12 +64,24 @@ static int print_full_usage(const char *arg0, FILE *file, int return_code) {
         "  -fno-PIC                     disable Position Independent Code\n"
         "  -ftime-report                print timing diagnostics\n"
         "  -fstack-report               print stack size diagnostics\n"
+        "  -fdedup-report               print functions merged by -fdedup-fns (implies it)\n"
+        "  -fsafety-report              print runtime safety checks removed as redundant\n"
+        "  -fsize-report[=json]         print the code and data size of each symbol\n"
 #ifdef ZIG_ENABLE_MEM_PROFILE
         "  -fmem-report                 print memory usage diagnostics\n"
 #endif
         "  -fdump-analysis              write analysis.json file with type information\n"
         "  -femit-docs                  create a docs/ dir with html documentation\n"
         "  -fno-emit-bin                skip emitting machine code\n"
+        "  -femit-asm[=path]            also output assembly from the same compilation\n"
+        "  -femit-llvm-ir[=path]        also output LLVM IR from the same compilation\n"
+        "  -femit-llvm-bc[=path]        also output LLVM bitcode from the same compilation\n"
+        "  -fprofile-generate[=dir]     instrument function entries; running the exe writes a profile\n"
+        "  -fprofile-use=[file]         optimize and lay out code using a recorded profile\n"
+        "  -flto=thin                   emit ThinLTO bitcode and optimize across objects when linking\n"
+        "  -fdebug-fast                 (experimental) skip IR passes in Debug builds, line tables only\n"
+        "  -fdedup-fns                  emit functions that lower to identical code only once\n"
+        "  -fcall-graph-profile         (ELF) let the linker order functions by static call weights\n"
         "  --libc [file]                Provide a file which specifies libc paths\n"
         "  --name [name]                override output name\n"
         "  --output-dir [dir]           override output directory (defaults to cwd)\n"
@@ -82,8 +94,12 @@ static int print_full_usage(const char *arg0, FILE *file, int return_code) {
         "  --single-threaded            source may assume it is only used single-threaded\n"
         "  -dynamic                     create a shared library (.so; .dll; .dylib)\n"
         "  --strip                      exclude debug symbols\n"
+        "  -gline-tables-only           debug info for stack traces only: no types or variables\n"
+        "  -gsplit-dwarf                (ELF) move debug info into a .dwo file next to the output\n"
         "  -target [name]               <arch><sub>-<os>-<abi> see the targets command\n"
         "  -target-glibc [version]      target a specific glibc version (default: 2.17)\n"
+        "  -mcpu=[name]                 generate code for a specific CPU model\n"
+        "  -mattr=[+feat,-feat]         enable or disable CPU features on top of the CPU model\n"
         "  --verbose-tokenize           enable compiler debug output for tokenization\n"
         "  --verbose-ast                enable compiler debug output for AST parsing\n"
         "  --verbose-link               enable compiler debug output for linking\n"
@@ -112,6 +128,9 @@ static int print_full_usage(const char *arg0, FILE *file, int return_code) {
         "  -L[dir]                      alias for --library-path\n"
         "  -l[lib]                      alias for --library\n"
         "  -rdynamic                    add all symbols to the dynamic symbol table\n"
+        "  -fcompress-debug-sections    (ELF) zlib-compress the .debug_* sections of the output\n"
+        "  -fincremental-link           (ELF) patch the previous output when few objects changed\n"
+        "  --icf [none|safe|all]        (ELF) fold identical functions in the linker\n"
         "  -rpath [path]                add directory to the runtime library search path\n"
         "  --subsystem [subsystem]      (windows) /SUBSYSTEM:<subsystem> to the linker\n"
         "  -F[dir]                      (darwin) add search path for frameworks\n"
@@ -298,6 +317,54 @@ static bool get_cache_opt(CacheOpt opt, bool default_value) {
     zig_unreachable();
 }
 
+// Matches `flag` alone or `flag=path`.
+static bool match_flag_with_path(const char *arg, const char *flag, const char **path) {
+    size_t flag_len = strlen(flag);
+    if (strncmp(arg, flag, flag_len) != 0)
+        return false;
+    if (arg[flag_len] == 0) {
+        *path = nullptr;
+        return true;
+    }
+    if (arg[flag_len] == '=' && arg[flag_len + 1] != 0) {
+        *path = arg + flag_len + 1;
+        return true;
+    }
+    return false;
+}
+
+// The extra outputs are produced in the output directory, which is inside the cache when
+// caching is on. Those given an explicit path are copied there; the rest are printed along
+// with the main output path when `print_paths` is set.
+static bool install_extra_output(bool emit, Buf *src_path, const char *dest_path, bool print_paths) {
+    if (!emit)
+        return true;
+    if (dest_path == nullptr) {
+        if (print_paths) {
+#if defined(ZIG_OS_WINDOWS)
+            buf_replace(src_path, '/', '\\');
+#endif
+            if (printf("%s\n", buf_ptr(src_path)) < 0)
+                return false;
+        }
+        return true;
+    }
+    Error err;
+    if ((err = os_copy_file(src_path, buf_create_from_str(dest_path)))) {
+        fprintf(stderr, "Unable to copy %s to %s: %s\n", buf_ptr(src_path), dest_path, err_str(err));
+        return false;
+    }
+    return true;
+}
+
+static bool install_extra_outputs(CodeGen *g, const char *asm_path, const char *llvm_ir_path,
+        const char *llvm_bc_path, bool print_paths)
+{
+    return install_extra_output(g->emit_asm, &g->asm_output_path, asm_path, print_paths) &&
+        install_extra_output(g->emit_llvm_ir, &g->llvm_ir_output_path, llvm_ir_path, print_paths) &&
+        install_extra_output(g->emit_llvm_bc, &g->llvm_bc_output_path, llvm_bc_path, print_paths);
+}
+
 static int zig_error_no_build_file(void) {
     fprintf(stderr,
         "No 'build.zig' file found, in the current directory or any parent directories.\n"
@@ -467,6 +534,11 @@ int main(int argc, char **argv) {
     const char *in_file = nullptr;
     Buf *output_dir = nullptr;
     bool strip = false;
+    bool debug_line_tables_only = false;
+    bool debug_split_dwarf = false;
+    bool compress_debug_sections = false;
+    bool incremental_link = false;
+    LinkerIcf icf = LinkerIcfNone;
     bool is_dynamic = false;
     OutType out_type = OutTypeUnknown;
     const char *out_name = nullptr;
@@ -506,9 +578,24 @@ int main(int argc, char **argv) {
     size_t ver_patch = 0;
     bool timing_info = false;
     bool stack_report = false;
+    bool dedup_report = false;
+    bool safety_report = false;
+    bool size_report = false;
+    bool size_report_json = false;
     bool enable_dump_analysis = false;
     bool enable_doc_generation = false;
     bool disable_bin_generation = false;
+    bool emit_asm = false;
+    bool emit_llvm_ir = false;
+    bool emit_llvm_bc = false;
+    const char *emit_asm_path = nullptr;
+    const char *emit_llvm_ir_path = nullptr;
+    const char *emit_llvm_bc_path = nullptr;
+    bool profile_generate = false;
+    const char *profile_generate_dir = nullptr;
+    const char *profile_use_path = nullptr;
+    const char *mcpu = nullptr;
+    const char *mattr = nullptr;
     const char *cache_dir = nullptr;
     CliPkg *cur_pkg = allocate<CliPkg>(1);
     BuildMode build_mode = BuildModeDebug;
@@ -525,6 +612,10 @@ int main(int argc, char **argv) {
     WantPIC want_pic = WantPICAuto;
     WantStackCheck want_stack_check = WantStackCheckAuto;
     bool function_sections = false;
+    bool thin_lto = false;
+    bool debug_fast = false;
+    bool call_graph_profile = false;
+    bool dedup_fns = false;
 
     ZigList<const char *> llvm_argv = {0};
     llvm_argv.append("zig (LLVM option parsing)");
@@ -671,8 +762,16 @@ int main(int argc, char **argv) {
                 } else {
                     return print_full_usage(arg0, stdout, EXIT_SUCCESS);
                 }
+            } else if (strcmp(arg, "-gline-tables-only") == 0) {
+                debug_line_tables_only = true;
+            } else if (strcmp(arg, "-gsplit-dwarf") == 0) {
+                debug_split_dwarf = true;
             } else if (strcmp(arg, "--strip") == 0) {
                 strip = true;
+            } else if (strcmp(arg, "-fcompress-debug-sections") == 0) {
+                compress_debug_sections = true;
+            } else if (strcmp(arg, "-fincremental-link") == 0) {
+                incremental_link = true;
             } else if (strcmp(arg, "-dynamic") == 0) {
                 is_dynamic = true;
             } else if (strcmp(arg, "--verbose-tokenize") == 0) {
@@ -697,6 +796,15 @@ int main(int argc, char **argv) {
                 timing_info = true;
             } else if (strcmp(arg, "-fstack-report") == 0) {
                 stack_report = true;
+            } else if (strcmp(arg, "-fdedup-report") == 0) {
+                dedup_report = true;
+            } else if (strcmp(arg, "-fsafety-report") == 0) {
+                safety_report = true;
+            } else if (strcmp(arg, "-fsize-report") == 0) {
+                size_report = true;
+            } else if (strcmp(arg, "-fsize-report=json") == 0) {
+                size_report = true;
+                size_report_json = true;
             } else if (strcmp(arg, "-fmem-report") == 0) {
 #ifdef ZIG_ENABLE_MEM_PROFILE
                 mem_report = true;
@@ -710,6 +818,28 @@ int main(int argc, char **argv) {
                 enable_doc_generation = true;
             } else if (strcmp(arg, "-fno-emit-bin") == 0) {
                 disable_bin_generation = true;
+            } else if (match_flag_with_path(arg, "-femit-asm", &emit_asm_path)) {
+                emit_asm = true;
+            } else if (match_flag_with_path(arg, "-femit-llvm-ir", &emit_llvm_ir_path)) {
+                emit_llvm_ir = true;
+            } else if (match_flag_with_path(arg, "-femit-llvm-bc", &emit_llvm_bc_path)) {
+                emit_llvm_bc = true;
+            } else if (match_flag_with_path(arg, "-fprofile-generate", &profile_generate_dir)) {
+                profile_generate = true;
+            } else if (strncmp(arg, "-fprofile-use=", 14) == 0 && arg[14] != 0) {
+                profile_use_path = arg + 14;
+            } else if (strncmp(arg, "-mcpu=", 6) == 0 && arg[6] != 0) {
+                mcpu = arg + 6;
+            } else if (strncmp(arg, "-mattr=", 7) == 0 && arg[7] != 0) {
+                mattr = arg + 7;
+            } else if (strcmp(arg, "-flto=thin") == 0) {
+                thin_lto = true;
+            } else if (strcmp(arg, "-fdebug-fast") == 0) {
+                debug_fast = true;
+            } else if (strcmp(arg, "-fdedup-fns") == 0) {
+                dedup_fns = true;
+            } else if (strcmp(arg, "-fcall-graph-profile") == 0) {
+                call_graph_profile = true;
             } else if (strcmp(arg, "--enable-valgrind") == 0) {
                 valgrind_support = ValgrindSupportEnabled;
             } else if (strcmp(arg, "--disable-valgrind") == 0) {
@@ -896,6 +1026,17 @@ int main(int argc, char **argv) {
                     ver_patch = atoi(argv[i]);
                 } else if (strcmp(arg, "--test-cmd") == 0) {
                     test_exec_args.append(argv[i]);
+                } else if (strcmp(arg, "--icf") == 0) {
+                    if (strcmp(argv[i], "none") == 0) {
+                        icf = LinkerIcfNone;
+                    } else if (strcmp(argv[i], "safe") == 0) {
+                        icf = LinkerIcfSafe;
+                    } else if (strcmp(argv[i], "all") == 0) {
+                        icf = LinkerIcfAll;
+                    } else {
+                        fprintf(stderr, "--icf options are 'none', 'safe', or 'all'\n");
+                        return print_error_usage(arg0);
+                    }
                 } else if (strcmp(arg, "--subsystem") == 0) {
                     if (strcmp(argv[i], "console") == 0) {
                         subsystem = TargetSubsystemConsole;
@@ -1062,6 +1203,102 @@ int main(int argc, char **argv) {
         return print_error_usage(arg0);
     }
 
+    if (profile_generate && profile_use_path != nullptr) {
+        fprintf(stderr, "`-fprofile-generate` and `-fprofile-use` are mutually exclusive\n");
+        return print_error_usage(arg0);
+    }
+
+    if (profile_generate && (out_type != OutTypeExe || in_file == nullptr)) {
+        fprintf(stderr, "`-fprofile-generate` requires building an executable from a root source file\n");
+        return print_error_usage(arg0);
+    }
+
+    if (profile_generate && (target.os == OsWindows || target.os == OsUefi ||
+                target.os == OsFreestanding || target_is_wasm(&target)))
+    {
+        Buf triple_buf = BUF_INIT;
+        target_triple_zig(&triple_buf, &target);
+        fprintf(stderr, "`-fprofile-generate` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+        return print_error_usage(arg0);
+    }
+
+    if (thin_lto && (out_type == OutTypeObj || (out_type == OutTypeLib && !is_dynamic) ||
+                system_linker_hack))
+    {
+        fprintf(stderr, "`-flto=thin` requires linking an executable or dynamic library with LLD\n");
+        return print_error_usage(arg0);
+    }
+
+    if (thin_lto) {
+        switch (target_object_format(&target)) {
+            case ZigLLVM_COFF:
+            case ZigLLVM_ELF:
+            case ZigLLVM_Wasm:
+                break;
+            default: {
+                Buf triple_buf = BUF_INIT;
+                target_triple_zig(&triple_buf, &target);
+                fprintf(stderr, "`-flto=thin` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+                return print_error_usage(arg0);
+            }
+        }
+    }
+
+    if (debug_split_dwarf && target_object_format(&target) != ZigLLVM_ELF) {
+        Buf triple_buf = BUF_INIT;
+        target_triple_zig(&triple_buf, &target);
+        fprintf(stderr, "`-gsplit-dwarf` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+        return print_error_usage(arg0);
+    }
+
+    if (compress_debug_sections && target_object_format(&target) != ZigLLVM_ELF) {
+        Buf triple_buf = BUF_INIT;
+        target_triple_zig(&triple_buf, &target);
+        fprintf(stderr, "`-fcompress-debug-sections` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+        return print_error_usage(arg0);
+    }
+
+    if (incremental_link && target_object_format(&target) != ZigLLVM_ELF) {
+        Buf triple_buf = BUF_INIT;
+        target_triple_zig(&triple_buf, &target);
+        fprintf(stderr, "`-fincremental-link` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+        return print_error_usage(arg0);
+    }
+
+    if (icf != LinkerIcfNone && target_object_format(&target) != ZigLLVM_ELF) {
+        Buf triple_buf = BUF_INIT;
+        target_triple_zig(&triple_buf, &target);
+        fprintf(stderr, "`--icf` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+        return print_error_usage(arg0);
+    }
+
+    if (call_graph_profile && target_object_format(&target) != ZigLLVM_ELF) {
+        Buf triple_buf = BUF_INIT;
+        target_triple_zig(&triple_buf, &target);
+        fprintf(stderr, "`-fcall-graph-profile` is not supported for target '%s'\n", buf_ptr(&triple_buf));
+        return print_error_usage(arg0);
+    }
+
+    if (icf != LinkerIcfNone && incremental_link) {
+        fprintf(stderr, "`--icf` and `-fincremental-link` are mutually exclusive\n");
+        return print_error_usage(arg0);
+    }
+
+    if (debug_split_dwarf && thin_lto) {
+        fprintf(stderr, "`-gsplit-dwarf` and `-flto=thin` are mutually exclusive\n");
+        return print_error_usage(arg0);
+    }
+
+    if (debug_fast && build_mode != BuildModeDebug) {
+        fprintf(stderr, "`-fdebug-fast` is only available in Debug builds\n");
+        return print_error_usage(arg0);
+    }
+
+    if ((emit_asm || emit_llvm_ir || emit_llvm_bc) && in_file == nullptr) {
+        fprintf(stderr, "A root source file is required when using `-femit-asm`, `-femit-llvm-ir` or `-femit-llvm-bc`\n");
+        return print_error_usage(arg0);
+    }
+
     if (llvm_argv.length > 1) {
         llvm_argv.append(nullptr);
         ZigLLVMParseCommandLineOptions(llvm_argv.length - 1, llvm_argv.items);
@@ -1094,6 +1331,10 @@ int main(int argc, char **argv) {
         g->want_pic = want_pic;
         g->want_stack_check = want_stack_check;
         g->want_single_threaded = want_single_threaded;
+        if (mcpu != nullptr)
+            g->mcpu = buf_create_from_str(mcpu);
+        if (mattr != nullptr)
+            g->mattr = buf_create_from_str(mattr);
         Buf *builtin_source = codegen_generate_builtin_source(g);
         if (fwrite(buf_ptr(builtin_source), 1, buf_len(builtin_source), stdout) != buf_len(builtin_source)) {
             fprintf(stderr, "unable to write to stdout: %s\n", strerror(ferror(stdout)));
@@ -1196,9 +1437,18 @@ int main(int argc, char **argv) {
 
             g->enable_time_report = timing_info;
             g->enable_stack_report = stack_report;
+            g->enable_size_report = size_report;
             g->enable_dump_analysis = enable_dump_analysis;
             g->enable_doc_generation = enable_doc_generation;
             g->disable_bin_generation = disable_bin_generation;
+            g->emit_asm = emit_asm;
+            g->emit_llvm_ir = emit_llvm_ir;
+            g->emit_llvm_bc = emit_llvm_bc;
+            g->profile_generate = profile_generate;
+            if (profile_generate_dir != nullptr)
+                g->profile_generate_dir = buf_create_from_str(profile_generate_dir);
+            if (profile_use_path != nullptr)
+                g->profile_use_path = buf_create_from_str(profile_use_path);
             codegen_set_out_name(g, buf_out_name);
             codegen_set_lib_version(g, ver_major, ver_minor, ver_patch);
             g->want_single_threaded = want_single_threaded;
@@ -1224,7 +1474,19 @@ int main(int argc, char **argv) {
             g->bundle_compiler_rt = bundle_compiler_rt;
             codegen_set_errmsg_color(g, color);
             g->system_linker_hack = system_linker_hack;
-            g->function_sections = function_sections;
+            // One section per function lets the linker work at function granularity.
+            g->function_sections = function_sections || debug_fast || icf != LinkerIcfNone ||
+                call_graph_profile;
+            g->thin_lto = thin_lto;
+            g->debug_fast = debug_fast;
+            g->call_graph_profile = call_graph_profile;
+            g->debug_line_tables_only = debug_line_tables_only;
+            g->debug_split_dwarf = debug_split_dwarf;
+            g->dedup_fns = dedup_fns || dedup_report;
+            if (mcpu != nullptr)
+                g->mcpu = buf_create_from_str(mcpu);
+            if (mattr != nullptr)
+                g->mattr = buf_create_from_str(mattr);
 
             for (size_t i = 0; i < lib_dirs.length; i += 1) {
                 codegen_add_lib_dir(g, lib_dirs.at(i));
@@ -1248,6 +1510,9 @@ int main(int argc, char **argv) {
             }
 
             codegen_set_rdynamic(g, rdynamic);
+            g->linker_compress_debug_sections = compress_debug_sections;
+            g->linker_incremental = incremental_link;
+            g->linker_icf = icf;
             if (mmacosx_version_min && mios_version_min) {
                 fprintf(stderr, "-mmacosx-version-min and -mios-version-min options not allowed together\n");
                 return main_exit(root_progress_node, EXIT_FAILURE);
@@ -1292,8 +1557,17 @@ int main(int argc, char **argv) {
                     codegen_print_timing_report(g, stdout);
                 if (stack_report)
                     zig_print_stack_report(g, stdout);
+                if (dedup_report)
+                    zig_print_dedup_report(g, stdout);
+                if (safety_report)
+                    zig_print_safety_report(g, stdout);
+                if (size_report)
+                    zig_print_size_report(g, stdout, size_report_json);
 
                 if (cmd == CmdRun) {
+                    if (!install_extra_outputs(g, emit_asm_path, emit_llvm_ir_path, emit_llvm_bc_path, false))
+                        return main_exit(root_progress_node, EXIT_FAILURE);
+
 #ifdef ZIG_ENABLE_MEM_PROFILE
                     memprof_dump_stats(stderr);
 #endif
@@ -1323,6 +1597,11 @@ int main(int argc, char **argv) {
                         if (printf("%s\n", buf_ptr(&g->output_file_path)) < 0)
                             return main_exit(root_progress_node, EXIT_FAILURE);
                     }
+                    if (!install_extra_outputs(g, emit_asm_path, emit_llvm_ir_path, emit_llvm_bc_path,
+                                g->enable_cache))
+                    {
+                        return main_exit(root_progress_node, EXIT_FAILURE);
+                    }
                     return main_exit(root_progress_node, EXIT_SUCCESS);
                 } else {
                     zig_unreachable();
@@ -1353,6 +1632,21 @@ int main(int argc, char **argv) {
                     zig_print_stack_report(g, stdout);
                 }
 
+                if (dedup_report) {
+                    zig_print_dedup_report(g, stdout);
+                }
+
+                if (safety_report) {
+                    zig_print_safety_report(g, stdout);
+                }
+
+                if (size_report) {
+                    zig_print_size_report(g, stdout, size_report_json);
+                }
+
+                if (!install_extra_outputs(g, emit_asm_path, emit_llvm_ir_path, emit_llvm_bc_path, false))
+                    return main_exit(root_progress_node, EXIT_FAILURE);
+
                 if (g->disable_bin_generation) {
                     fprintf(stderr, "Semantic analysis complete. No binary produced due to -fno-emit-bin.\n");
                     return main_exit(root_progress_node, EXIT_SUCCESS);
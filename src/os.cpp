@@ -49,6 +49,8 @@ typedef SSIZE_T ssize_t;
 #include <fcntl.h>
 #include <limits.h>
 #include <spawn.h>
+#include <poll.h>
+#include <pthread.h>
 
 #endif
 
@@ -784,79 +786,112 @@ Error os_file_exists(Buf *full_path, bool *result) {
 }
 
 #if defined(ZIG_OS_POSIX)
+// Reads stdout and stderr of the child together, so that neither can fill up its pipe and
+// block the child while we wait on the other.
+static Error os_drain_pipes(int stdout_fd, int stderr_fd, Buf *out_stdout, Buf *out_stderr) {
+    static const size_t chunk_size = 0x2000;
+    buf_resize(out_stdout, 0);
+    buf_resize(out_stderr, 0);
+
+    struct pollfd fds[2];
+    fds[0].fd = stdout_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stderr_fd;
+    fds[1].events = POLLIN;
+    Buf *bufs[2] = {out_stdout, out_stderr};
+    size_t open_count = 2;
+
+    while (open_count != 0) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            return ErrorFileSystem;
+        }
+        for (size_t i = 0; i < 2; i += 1) {
+            if (fds[i].fd == -1 || fds[i].revents == 0)
+                continue;
+            Buf *buf = bufs[i];
+            size_t old_len = buf_len(buf);
+            buf_resize(buf, old_len + chunk_size);
+            ssize_t amt_read = read(fds[i].fd, buf_ptr(buf) + old_len, chunk_size);
+            if (amt_read == -1) {
+                buf_resize(buf, old_len);
+                if (errno == EINTR || errno == EAGAIN)
+                    continue;
+                return ErrorFileSystem;
+            }
+            buf_resize(buf, old_len + amt_read);
+            if (amt_read == 0) {
+                // poll ignores negative descriptors
+                fds[i].fd = -1;
+                open_count -= 1;
+            }
+        }
+    }
+    return ErrorNone;
+}
+
+// posix_spawn rather than fork: the compiler may have a heap of several gigabytes by the
+// time it runs a child, and fork has to duplicate the page tables for all of it just to
+// throw them away at exec.
 static Error os_exec_process_posix(ZigList<const char *> &args,
         Termination *term, Buf *out_stderr, Buf *out_stdout)
 {
-    int stdin_pipe[2];
     int stdout_pipe[2];
     int stderr_pipe[2];
-    int err_pipe[2];
 
-    int err;
-    if ((err = pipe(stdin_pipe)))
+    if (pipe(stdout_pipe) == -1)
         zig_panic("pipe failed");
-    if ((err = pipe(stdout_pipe)))
+    if (pipe(stderr_pipe) == -1)
         zig_panic("pipe failed");
-    if ((err = pipe(stderr_pipe)))
-        zig_panic("pipe failed");
-    if ((err = pipe(err_pipe)))
-        zig_panic("pipe failed");
-
-    pid_t pid = fork();
-    if (pid == -1)
-        zig_panic("fork failed: %s", strerror(errno));
-    if (pid == 0) {
-        // child
-        if (dup2(stdin_pipe[0], STDIN_FILENO) == -1)
-            zig_panic("dup2 failed");
-
-        if (dup2(stdout_pipe[1], STDOUT_FILENO) == -1)
-            zig_panic("dup2 failed");
 
-        if (dup2(stderr_pipe[1], STDERR_FILENO) == -1)
-            zig_panic("dup2 failed");
-
-        const char **argv = allocate<const char *>(args.length + 1);
-        argv[args.length] = nullptr;
-        for (size_t i = 0; i < args.length; i += 1) {
-            argv[i] = args.at(i);
-        }
-        execvp(argv[0], const_cast<char * const *>(argv));
-        Error report_err = ErrorUnexpected;
-        if (errno == ENOENT) {
-            report_err = ErrorFileNotFound;
-        }
-        write(err_pipe[1], &report_err, sizeof(Error));
-        exit(1);
-    } else {
-        // parent
-        close(stdin_pipe[0]);
-        close(stdin_pipe[1]);
-        close(stdout_pipe[1]);
-        close(stderr_pipe[1]);
+    posix_spawn_file_actions_t actions;
+    int rc;
+    if ((rc = posix_spawn_file_actions_init(&actions)))
+        zig_panic("posix_spawn_file_actions_init failed: %s", strerror(rc));
+    if ((rc = posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0)))
+        zig_panic("posix_spawn_file_actions_addopen failed: %s", strerror(rc));
+    if ((rc = posix_spawn_file_actions_adddup2(&actions, stdout_pipe[1], STDOUT_FILENO)))
+        zig_panic("posix_spawn_file_actions_adddup2 failed: %s", strerror(rc));
+    if ((rc = posix_spawn_file_actions_adddup2(&actions, stderr_pipe[1], STDERR_FILENO)))
+        zig_panic("posix_spawn_file_actions_adddup2 failed: %s", strerror(rc));
+    int pipe_fds[4] = {stdout_pipe[0], stdout_pipe[1], stderr_pipe[0], stderr_pipe[1]};
+    for (size_t i = 0; i < 4; i += 1) {
+        if ((rc = posix_spawn_file_actions_addclose(&actions, pipe_fds[i])))
+            zig_panic("posix_spawn_file_actions_addclose failed: %s", strerror(rc));
+    }
 
-        int status;
-        waitpid(pid, &status, 0);
-        populate_termination(term, status);
+    const char **argv = allocate<const char *>(args.length + 1);
+    argv[args.length] = nullptr;
+    for (size_t i = 0; i < args.length; i += 1) {
+        argv[i] = args.at(i);
+    }
 
-        FILE *stdout_f = fdopen(stdout_pipe[0], "rb");
-        FILE *stderr_f = fdopen(stderr_pipe[0], "rb");
-        Error err1 = os_fetch_file(stdout_f, out_stdout);
-        Error err2 = os_fetch_file(stderr_f, out_stderr);
+    pid_t pid;
+    rc = posix_spawnp(&pid, argv[0], &actions, nullptr, const_cast<char * const *>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    deallocate(argv, args.length + 1);
+    close(stdout_pipe[1]);
+    close(stderr_pipe[1]);
 
-        fclose(stdout_f);
-        fclose(stderr_f);
+    if (rc != 0) {
+        close(stdout_pipe[0]);
+        close(stderr_pipe[0]);
+        return (rc == ENOENT) ? ErrorFileNotFound : ErrorUnexpected;
+    }
 
-        if (err1) return err1;
-        if (err2) return err2;
+    Error err = os_drain_pipes(stdout_pipe[0], stderr_pipe[0], out_stdout, out_stderr);
+    close(stdout_pipe[0]);
+    close(stderr_pipe[0]);
 
-        Error child_err = ErrorNone;
-        write(err_pipe[1], &child_err, sizeof(Error));
-        close(err_pipe[1]);
-        read(err_pipe[0], &child_err, sizeof(Error));
-        close(err_pipe[0]);
-        return child_err;
+    int status;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR)
+            zig_panic("waitpid failed: %s", strerror(errno));
     }
+    populate_termination(term, status);
+
+    return err;
 }
 #endif
 
@@ -2104,6 +2139,77 @@ void os_file_close(OsFile *file) {
 #endif
 }
 
+size_t os_cpu_count(void) {
+#if defined(ZIG_OS_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return max((size_t)info.dwNumberOfProcessors, (size_t)1);
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count < 1) ? 1 : (size_t)count;
+#endif
+}
+
+struct OsThread {
+    OsThreadStartFn start_fn;
+    void *context;
+#if defined(ZIG_OS_WINDOWS)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+};
+
+#if defined(ZIG_OS_WINDOWS)
+static DWORD WINAPI os_thread_start_windows(LPVOID param) {
+    OsThread *thread = reinterpret_cast<OsThread *>(param);
+    thread->start_fn(thread->context);
+    return 0;
+}
+#else
+static void *os_thread_start_posix(void *param) {
+    OsThread *thread = reinterpret_cast<OsThread *>(param);
+    thread->start_fn(thread->context);
+    return nullptr;
+}
+#endif
+
+Error os_thread_spawn(OsThreadStartFn start_fn, void *context, OsThread **out_thread) {
+    OsThread *thread = allocate<OsThread>(1, "OsThread");
+    thread->start_fn = start_fn;
+    thread->context = context;
+#if defined(ZIG_OS_WINDOWS)
+    thread->handle = CreateThread(nullptr, 0, os_thread_start_windows, thread, 0, nullptr);
+    if (thread->handle == nullptr) {
+        destroy(thread, "OsThread");
+        return ErrorSystemResources;
+    }
+#else
+    // The compiler recurses deeply during analysis; match the main thread's stack.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 16 * 1024 * 1024);
+    int rc = pthread_create(&thread->handle, &attr, os_thread_start_posix, thread);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        destroy(thread, "OsThread");
+        return (rc == EAGAIN) ? ErrorSystemResources : ErrorUnexpected;
+    }
+#endif
+    *out_thread = thread;
+    return ErrorNone;
+}
+
+void os_thread_join(OsThread *thread) {
+#if defined(ZIG_OS_WINDOWS)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, nullptr);
+#endif
+    destroy(thread, "OsThread");
+}
+
 #ifdef ZIG_OS_LINUX
 const char *possible_ld_names[] = {
 #if defined(ZIG_ARCH_X86_64)
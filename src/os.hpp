@@ -102,6 +102,9 @@ struct OsFileAttr {
     uint64_t inode;
 };
 
+struct OsThread;
+typedef void (*OsThreadStartFn)(void *context);
+
 int os_init(void);
 
 void os_spawn_process(ZigList<const char *> &args, Termination *term);
@@ -158,4 +161,8 @@ Error ATTRIBUTE_MUST_USE os_get_win32_kern32_path(ZigWindowsSDK *sdk, Buf *outpu
 
 Error ATTRIBUTE_MUST_USE os_self_exe_shared_libs(ZigList<Buf *> &paths);
 
+size_t os_cpu_count(void);
+Error ATTRIBUTE_MUST_USE os_thread_spawn(OsThreadStartFn start_fn, void *context, OsThread **out_thread);
+void os_thread_join(OsThread *thread);
+
 #endif
@@ -1154,6 +1154,10 @@ const char *target_llvm_ir_file_ext(const ZigTarget *target) {
     return ".ll";
 }
 
+const char *target_llvm_bc_file_ext(const ZigTarget *target) {
+    return ".bc";
+}
+
 const char *target_exe_file_ext(const ZigTarget *target) {
     if (target->os == OsWindows) {
         return ".exe";
@@ -162,6 +162,7 @@ uint32_t target_c_type_size_in_bits(const ZigTarget *target, CIntType id);
 const char *target_o_file_ext(const ZigTarget *target);
 const char *target_asm_file_ext(const ZigTarget *target);
 const char *target_llvm_ir_file_ext(const ZigTarget *target);
+const char *target_llvm_bc_file_ext(const ZigTarget *target);
 const char *target_exe_file_ext(const ZigTarget *target);
 const char *target_lib_file_prefix(const ZigTarget *target);
 const char *target_lib_file_ext(const ZigTarget *target, bool is_static,
@@ -5044,11 +5044,11 @@ static AstNode *parse_ctok_prefix_op_expr(Context *c, CTokenize *ctok, size_t *t
     }
 }
 
-static void process_macro(Context *c, CTokenize *ctok, Buf *name, const char *char_ptr) {
+static AstNode *trans_macro(Context *c, CTokenize *ctok, Buf *name, const char *char_ptr) {
     tokenize_c_macro(ctok, (const uint8_t *)char_ptr);
 
     if (ctok->error) {
-        return;
+        return nullptr;
     }
 
     size_t tok_i = 0;
@@ -5058,25 +5058,88 @@ static void process_macro(Context *c, CTokenize *ctok, Buf *name, const char *ch
 
     AstNode *result_node = parse_ctok_suffix_op_expr(c, ctok, &tok_i);
     if (result_node == nullptr) {
-        return;
+        return nullptr;
     }
     CTok *eof_tok = &ctok->tokens.at(tok_i);
     if (eof_tok->id != CTokIdEOF) {
-        return;
+        return nullptr;
     }
     if (result_node->type == NodeTypeSymbol) {
         // if it equals itself, ignore. for example, from stdio.h:
         // #define stdin stdin
         Buf *symbol_name = result_node->data.symbol_expr.symbol;
         if (buf_eql_buf(name, symbol_name)) {
-            return;
+            return nullptr;
         }
     }
-    c->macro_table.put(name, result_node);
+    return result_node;
 }
 
-static void process_preprocessor_entities(Context *c, ZigClangASTUnit *unit) {
+struct MacroJob {
+    Buf *name;
+    const char *char_ptr;
+    AstNode *result_node;
+};
+
+struct MacroWorker {
+    Context *c;
+    MacroJob *jobs;
+    size_t jobs_len;
+};
+
+// Below this many macros the cost of spawning threads outweighs the work.
+static const size_t macro_jobs_per_thread_min = 512;
+
+static void trans_macro_worker(void *context) {
+    MacroWorker *worker = reinterpret_cast<MacroWorker *>(context);
     CTokenize ctok = {{0}};
+    for (size_t i = 0; i < worker->jobs_len; i += 1) {
+        MacroJob *job = &worker->jobs[i];
+        job->result_node = trans_macro(worker->c, &ctok, job->name, job->char_ptr);
+    }
+}
+
+// Macro translation only tokenizes the macro text and builds fresh AST nodes, so unlike
+// decl visitation (which queries and caches into the clang ASTContext and the decl/global
+// tables) it can be split across threads. Each worker owns a contiguous range of jobs.
+static void trans_macro_jobs(Context *c, ZigList<MacroJob> *jobs) {
+    size_t thread_count = min(os_cpu_count(), jobs->length / macro_jobs_per_thread_min);
+#ifdef ZIG_ENABLE_MEM_PROFILE
+    // The memory profiler's usage table is not thread-safe.
+    thread_count = 0;
+#endif
+    if (thread_count <= 1) {
+        MacroWorker worker = {c, jobs->items, jobs->length};
+        trans_macro_worker(&worker);
+        return;
+    }
+
+    MacroWorker *workers = allocate<MacroWorker>(thread_count);
+    OsThread **threads = allocate<OsThread *>(thread_count);
+    size_t chunk_len = (jobs->length + thread_count - 1) / thread_count;
+    for (size_t i = 0; i < thread_count; i += 1) {
+        size_t start = min(i * chunk_len, jobs->length);
+        size_t end = min(start + chunk_len, jobs->length);
+        workers[i].c = c;
+        workers[i].jobs = jobs->items + start;
+        workers[i].jobs_len = end - start;
+        if (os_thread_spawn(trans_macro_worker, &workers[i], &threads[i]) != ErrorNone) {
+            // Fall back to doing this chunk on the calling thread.
+            threads[i] = nullptr;
+            trans_macro_worker(&workers[i]);
+        }
+    }
+    for (size_t i = 0; i < thread_count; i += 1) {
+        if (threads[i] != nullptr) {
+            os_thread_join(threads[i]);
+        }
+    }
+    deallocate(threads, thread_count);
+    deallocate(workers, thread_count);
+}
+
+static void process_preprocessor_entities(Context *c, ZigClangASTUnit *unit) {
+    ZigList<MacroJob> jobs = {0};
 
     // TODO if we see #undef, delete it from the table
     for (ZigClangPreprocessingRecord_iterator it = ZigClangASTUnit_getLocalPreprocessingEntities_begin(unit),
@@ -5106,11 +5169,27 @@ static void process_preprocessor_entities(Context *c, ZigClangASTUnit *unit) {
                         continue;
                     }
 
-                    const char *begin_c = ZigClangSourceManager_getCharacterData(c->source_manager, begin_loc);
-                    process_macro(c, &ctok, name, begin_c);
+                    MacroJob *job = jobs.add_one();
+                    job->name = name;
+                    job->char_ptr = ZigClangSourceManager_getCharacterData(c->source_manager, begin_loc);
+                    job->result_node = nullptr;
                 }
         }
     }
+
+    trans_macro_jobs(c, &jobs);
+
+    // Merge in source order so that the first successfully translated definition of a
+    // macro wins, exactly as when the macros are translated one at a time.
+    for (size_t i = 0; i < jobs.length; i += 1) {
+        MacroJob *job = &jobs.at(i);
+        if (job->result_node == nullptr)
+            continue;
+        if (c->macro_table.maybe_get(job->name) != nullptr)
+            continue;
+        c->macro_table.put(job->name, job->result_node);
+    }
+    jobs.deinit();
 }
 
 Error parse_h_file(CodeGen *codegen, AstNode **out_root_node,
@@ -185,6 +185,11 @@ static int PrintSupportedCPUs(std::string TargetStr) {
   return 0;
 }
 
+// Set by ZigClang_cc_in_process while -cc1 jobs run on worker threads.
+extern bool ZigClangInProcess;
+// The diagnostics buffer of the in-process job running on this thread.
+extern LLVM_THREAD_LOCAL llvm::raw_ostream *ZigClangInProcessErrs;
+
 int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   ensureSufficientStack();
 
@@ -197,10 +202,14 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   PCHOps->registerReader(llvm::make_unique<ObjectFilePCHContainerReader>());
 
   // Initialize targets first, so that --version shows registered targets.
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmPrinters();
-  llvm::InitializeAllAsmParsers();
+  // When running in-process the caller has already done this on its own
+  // thread, and the registry must not be mutated from worker threads.
+  if (!ZigClangInProcess) {
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    llvm::InitializeAllAsmParsers();
+  }
 
   // Buffer diagnostics from argument parsing so that we can output them using a
   // well formed diagnostic object.
@@ -224,14 +233,20 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
       CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
 
   // Create the actual diagnostics engine.
-  Clang->createDiagnostics();
+  if (ZigClangInProcess)
+    Clang->createDiagnostics(new TextDiagnosticPrinter(
+        *ZigClangInProcessErrs, &Clang->getDiagnosticOpts()));
+  else
+    Clang->createDiagnostics();
   if (!Clang->hasDiagnostics())
     return 1;
 
   // Set an error handler, so that any LLVM backend diagnostics go through our
-  // error handler.
-  llvm::install_fatal_error_handler(LLVMErrorHandler,
-                                  static_cast<void*>(&Clang->getDiagnostics()));
+  // error handler. The handler is process-wide, so in-process compilations
+  // share the one installed by the caller instead.
+  if (!ZigClangInProcess)
+    llvm::install_fatal_error_handler(LLVMErrorHandler,
+                                    static_cast<void*>(&Clang->getDiagnostics()));
 
   DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
   if (!Success)
@@ -271,7 +286,8 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   // Our error handler depends on the Diagnostics object, which we're
   // potentially about to delete. Uninstall the handler now so that any
   // later errors use the default handling behavior instead.
-  llvm::remove_fatal_error_handler();
+  if (!ZigClangInProcess)
+    llvm::remove_fatal_error_handler();
 
   // When running with -disable-free, don't do any destruction or shutdown.
   if (Clang->getFrontendOpts().DisableFree) {
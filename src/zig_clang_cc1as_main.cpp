@@ -322,6 +322,15 @@ getOutputStream(StringRef Path, DiagnosticsEngine &Diags, bool Binary) {
   return Out;
 }
 
+// Set by ZigClang_cc_in_process while -cc1as jobs run on worker threads.
+extern bool ZigClangInProcess;
+// The diagnostics buffer of the in-process job running on this thread.
+extern LLVM_THREAD_LOCAL raw_ostream *ZigClangInProcessErrs;
+
+static void InProcessSourceMgrDiagHandler(const SMDiagnostic &D, void *Context) {
+  D.print(nullptr, *ZigClangInProcessErrs);
+}
+
 static bool ExecuteAssembler(AssemblerInvocation &Opts,
                              DiagnosticsEngine &Diags) {
   // Get the target specific parser.
@@ -339,6 +348,8 @@ static bool ExecuteAssembler(AssemblerInvocation &Opts,
   }
 
   SourceMgr SrcMgr;
+  if (ZigClangInProcess)
+    SrcMgr.setDiagHandler(InProcessSourceMgrDiagHandler);
 
   // Tell SrcMgr about this buffer, which is what the parser will pick up.
   unsigned BufferIndex = SrcMgr.AddNewSourceBuffer(std::move(*Buffer), SMLoc());
@@ -545,23 +556,27 @@ static void LLVMErrorHandler(void *UserData, const std::string &Message,
 }
 
 int cc1as_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
-  // Initialize targets and assembly printers/parsers.
-  InitializeAllTargetInfos();
-  InitializeAllTargetMCs();
-  InitializeAllAsmParsers();
+  // Initialize targets and assembly printers/parsers. When running in-process
+  // the caller has already done this on its own thread.
+  if (!ZigClangInProcess) {
+    InitializeAllTargetInfos();
+    InitializeAllTargetMCs();
+    InitializeAllAsmParsers();
+  }
 
   // Construct our diagnostic client.
   IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
-  TextDiagnosticPrinter *DiagClient
-    = new TextDiagnosticPrinter(errs(), &*DiagOpts);
+  TextDiagnosticPrinter *DiagClient = new TextDiagnosticPrinter(
+      ZigClangInProcess ? *ZigClangInProcessErrs : errs(), &*DiagOpts);
   DiagClient->setPrefix("clang -cc1as");
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
   DiagnosticsEngine Diags(DiagID, &*DiagOpts, DiagClient);
 
   // Set an error handler, so that any LLVM backend diagnostics go through our
-  // error handler.
-  ScopedFatalErrorHandler FatalErrorHandler
-    (LLVMErrorHandler, static_cast<void*>(&Diags));
+  // error handler. In-process compilations share the caller's handler.
+  Optional<ScopedFatalErrorHandler> FatalErrorHandler;
+  if (!ZigClangInProcess)
+    FatalErrorHandler.emplace(LLVMErrorHandler, static_cast<void*>(&Diags));
 
   // Parse the arguments.
   AssemblerInvocation Asm;
@@ -29,6 +29,7 @@
 #include "llvm/Option/OptTable.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
@@ -40,6 +41,7 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <memory>
@@ -198,6 +200,11 @@ static void ApplyQAOverride(SmallVectorImpl<const char*> &Args,
   }
 }
 
+bool ZigClangInProcess = false;
+// Where cc1_main and cc1as_main write diagnostics while ZigClangInProcess is
+// set; each in-process job buffers its own so that jobs do not interleave.
+LLVM_THREAD_LOCAL llvm::raw_ostream *ZigClangInProcessErrs = nullptr;
+
 extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
                     void *MainAddr);
 extern int cc1as_main(ArrayRef<const char *> Argv, const char *Argv0,
@@ -509,3 +516,178 @@ int ZigClang_main(int argc_, const char **argv_) {
   // failing command.
   return Res;
 }
+
+// Returned for a command line that crashed and was recovered, or that cannot
+// run in-process at all. The caller is expected to re-run it out of process,
+// which also gets clang's crash diagnostics.
+static const int ZigClangInProcessCrashed = -2;
+
+// Matches the stack clang requests for itself in ensureSufficientStack.
+static const unsigned ZigClangInProcessStackSize = 8 << 20;
+
+// Other jobs may be in the middle of writing their outputs, so a fatal error
+// must only abandon the job that hit it. The command line is then re-run as a
+// child process, which reports the error itself.
+static void ZigClangInProcessFatalError(void *UserData, const std::string &Message,
+                                        bool GenCrashDiag) {
+  if (llvm::CrashRecoveryContext *CRC = llvm::CrashRecoveryContext::GetCurrent())
+    CRC->HandleCrash();
+  // Not reached from a job; there is nothing to recover to.
+  llvm::errs() << "error: " << Message << "\n";
+  exit(1);
+}
+
+// Whether a -cc1 or -cc1as job would mutate LLVM's process-wide state, such as
+// the cl::opt registry (-mllvm, which the driver may add on its own, e.g.
+// -arm-add-build-attributes), the time trace profiler, timer groups, or the set
+// of loaded plugins. Such jobs must not run concurrently with others.
+static bool ZigClangJobNeedsOwnProcess(const llvm::opt::ArgStringList &Args) {
+  for (const char *Arg : Args) {
+    StringRef A(Arg);
+    if (A == "-mllvm" || A.startswith("-ftime-trace") || A == "-ftime-report" ||
+        A == "-load")
+      return true;
+  }
+  return false;
+}
+
+static int ZigClangRunJobsInProcess(const std::string &Path, const Compilation &C,
+                                    llvm::raw_ostream &OS) {
+  // Check every job before running any, so that a command line is never run
+  // partly in-process and partly in a child process.
+  for (const auto &J : C.getJobs()) {
+    const Command *Cmd = dyn_cast<Command>(&J);
+    if (Cmd != nullptr && ZigClangJobNeedsOwnProcess(Cmd->getArguments()))
+      return ZigClangInProcessCrashed;
+  }
+
+  for (const auto &J : C.getJobs()) {
+    const Command *Cmd = dyn_cast<Command>(&J);
+    if (Cmd == nullptr)
+      return 1;
+    const llvm::opt::ArgStringList &Args = Cmd->getArguments();
+    if (Args.empty() || !StringRef(Args[0]).startswith("-cc1")) {
+      // Not an integrated tool; let the driver run it as usual.
+      std::string ErrMsg;
+      bool ExecutionFailed;
+      int Res = Cmd->Execute({}, &ErrMsg, &ExecutionFailed);
+      if (ExecutionFailed) {
+        OS << "error: " << ErrMsg << "\n";
+        return 1;
+      }
+      if (Res != 0)
+        return Res;
+      continue;
+    }
+
+    SmallVector<const char *, 256> Argv;
+    Argv.push_back(Path.c_str());
+    for (const char *Arg : Args) {
+      // The job's memory is only reclaimed at process exit with -disable-free,
+      // which would leak every compilation when running in-process.
+      if (strcmp(Arg, "-disable-free") == 0)
+        continue;
+      Argv.push_back(Arg);
+    }
+
+    int Res = 1;
+    llvm::CrashRecoveryContext CRC;
+    bool Ok = CRC.RunSafelyOnThread([&]() {
+      ZigClangInProcessErrs = &OS;
+      Res = ExecuteCC1Tool(Argv, Argv[1] + 4);
+    }, ZigClangInProcessStackSize);
+    if (!Ok)
+      return ZigClangInProcessCrashed;
+    if (Res != 0)
+      return Res;
+  }
+  return 0;
+}
+
+// Runs `zig cc` command lines (as built for `zig cc`, starting with the zig
+// executable path followed by "cc") without spawning a new zig process for
+// each one. The driver runs on the calling thread to compute the -cc1 and
+// -cc1as jobs for every command line, and then each command line's jobs run
+// in order on one of `thread_count` worker threads, each compilation isolated
+// in its own CompilerInstance and CrashRecoveryContext. The diagnostics of the
+// jobs are buffered and printed in command line order once all of them are
+// done. Writes the exit code of each command line to `out_results`;
+// ZigClangInProcessCrashed marks a crash or a fatal error.
+extern "C" void ZigClang_cc_in_process(const char ***argvs, const size_t *argcs, int *out_results,
+        size_t count, size_t thread_count);
+void ZigClang_cc_in_process(const char ***argvs, const size_t *argcs, int *out_results,
+        size_t count, size_t thread_count)
+{
+  if (count == 0)
+    return;
+
+  llvm::InitializeAllTargetInfos();
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmPrinters();
+  llvm::InitializeAllAsmParsers();
+
+  std::string Path = GetExecutablePath(argvs[0][0], true);
+
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  std::vector<std::unique_ptr<Compilation>> Compilations(count);
+  std::vector<std::unique_ptr<Driver>> Drivers(count);
+  std::vector<std::unique_ptr<DiagnosticsEngine>> DiagEngines(count);
+  std::vector<IntrusiveRefCntPtr<DiagnosticOptions>> DiagOptions(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    // Skip the zig executable path; like ZigClang_main, "cc" stands in for
+    // the program name.
+    SmallVector<const char *, 256> argv(argvs[i] + 1, argvs[i] + argcs[i]);
+
+    DiagOptions[i] = CreateAndPopulateDiagOpts(argv);
+    TextDiagnosticPrinter *DiagClient = new TextDiagnosticPrinter(llvm::errs(), &*DiagOptions[i]);
+    FixupDiagPrefixExeName(DiagClient, Path);
+    DiagEngines[i].reset(new DiagnosticsEngine(DiagID, &*DiagOptions[i], DiagClient));
+    ProcessWarningOptions(*DiagEngines[i], *DiagOptions[i], /*ReportDiags=*/false);
+
+    Drivers[i].reset(new Driver(Path, llvm::sys::getDefaultTargetTriple(), *DiagEngines[i]));
+    SetInstallDir(argv, *Drivers[i], true);
+    Drivers[i]->setTargetAndMode(ToolChain::getTargetAndModeFromProgramName(argv[0]));
+    Compilations[i].reset(Drivers[i]->BuildCompilation(argv));
+    if (!Compilations[i] || Compilations[i]->containsError()) {
+      out_results[i] = 1;
+      Compilations[i].reset();
+    }
+  }
+
+  ZigClangInProcess = true;
+  llvm::install_fatal_error_handler(ZigClangInProcessFatalError, nullptr);
+  llvm::CrashRecoveryContext::Enable();
+  std::vector<std::string> Outputs(count);
+  {
+    llvm::ThreadPool Pool(std::max<unsigned>(1, std::min<size_t>(thread_count, count)));
+    for (size_t i = 0; i < count; ++i) {
+      if (!Compilations[i])
+        continue;
+      Pool.async([&, i]() {
+        llvm::raw_string_ostream OS(Outputs[i]);
+        out_results[i] = ZigClangRunJobsInProcess(Path, *Compilations[i], OS);
+      });
+    }
+    Pool.wait();
+  }
+  llvm::CrashRecoveryContext::Disable();
+  llvm::remove_fatal_error_handler();
+  ZigClangInProcess = false;
+
+  for (size_t i = 0; i < count; ++i) {
+    // A command line that is re-run as a child process prints its diagnostics
+    // again there.
+    if (out_results[i] != ZigClangInProcessCrashed)
+      llvm::errs() << Outputs[i];
+    if (Compilations[i]) {
+      // Mirror Driver::ExecuteCompilation's cleanup of partial outputs and temporaries.
+      if (out_results[i] != 0)
+        Compilations[i]->CleanupFileMap(Compilations[i]->getFailureResultFiles(), nullptr, true);
+      if (!Drivers[i]->isSaveTempsEnabled())
+        Compilations[i]->CleanupFileList(Compilations[i]->getTempFiles(), true);
+    }
+    DiagEngines[i]->getClient()->finish();
+  }
+}
@@ -20,25 +20,38 @@
 #pragma GCC diagnostic ignored "-Winit-list-lifetime"
 #endif
 
+#include <llvm/ADT/MapVector.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/BranchProbabilityInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Dominators.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/InlineAsm.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/InitializePasses.h>
+#include <llvm/MC/MCSubtargetInfo.h>
 #include <llvm/MC/SubtargetFeature.h>
 #include <llvm/Object/Archive.h>
 #include <llvm/Object/ArchiveWriter.h>
 #include <llvm/Object/COFF.h>
 #include <llvm/Object/COFFImportFile.h>
 #include <llvm/Object/COFFModuleDefinition.h>
+#include <llvm/Object/ELFObjectFile.h>
+#include <llvm/Object/ObjectFile.h>
 #include <llvm/PassRegistry.h>
+#include <llvm/ProfileData/InstrProf.h>
+#include <llvm/ProfileData/ProfileCommon.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SmallVectorMemoryBuffer.h>
 #include <llvm/Support/TargetParser.h>
 #include <llvm/Support/Timer.h>
 #include <llvm/Support/raw_ostream.h>
@@ -50,8 +63,11 @@
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/FunctionComparator.h>
 
 #include <lld/Common/Driver.h>
+#include <lld/Common/Filesystem.h>
 
 #if __GNUC__ >= 9
 #pragma GCC diagnostic pop
@@ -87,6 +103,37 @@ char *ZigLLVMGetNativeFeatures(void) {
     return strdup((const char *)StringRef(features.getString()).bytes_begin());
 }
 
+bool ZigLLVMValidateCPUAndFeatures(LLVMTargetRef T, const char *triple, const char *cpu,
+        const char *features, char **error_message)
+{
+    const Target *target = reinterpret_cast<const Target *>(T);
+    std::unique_ptr<MCSubtargetInfo> sti(target->createMCSubtargetInfo(triple, "", ""));
+    if (sti == nullptr) {
+        *error_message = strdup("target has no subtarget information");
+        return true;
+    }
+    if (cpu[0] != 0 && !sti->isCPUStringValid(cpu)) {
+        *error_message = strdup((std::string("unknown CPU '") + cpu + "'").c_str());
+        return true;
+    }
+    for (const std::string &feature : SubtargetFeatures(features).getFeatures()) {
+        if (!SubtargetFeatures::hasFlag(feature)) {
+            *error_message = strdup(("feature '" + feature + "' must start with '+' or '-'").c_str());
+            return true;
+        }
+        // Toggling leaves the bits alone for names that are not in the feature table.
+        std::string name(SubtargetFeatures::StripFlag(feature));
+        FeatureBitset before = sti->getFeatureBits();
+        FeatureBitset after = sti->ToggleFeature(name);
+        sti->setFeatureBits(before);
+        if (after == before) {
+            *error_message = strdup(("unknown CPU feature '" + name + "'").c_str());
+            return true;
+        }
+    }
+    return false;
+}
+
 static void addDiscriminatorsPass(const PassManagerBuilder &Builder, legacy::PassManagerBase &PM) {
     PM.add(createAddDiscriminatorsPass());
 }
@@ -146,6 +193,9 @@ LLVMTargetMachineRef ZigLLVMCreateTargetMachine(LLVMTargetRef T, const char *Tri
 
     TargetOptions opt;
     opt.FunctionSections = function_sections;
+    // Like clang, always emit address-significance tables. They let the
+    // linker fold identical functions whose address is never taken.
+    opt.EmitAddrsig = true;
 
     TargetMachine *TM = reinterpret_cast<Target*>(T)->createTargetMachine(Triple, CPU, Features, opt, RM, CM,
             OL, JIT);
@@ -156,23 +206,24 @@ unsigned ZigLLVMDataLayoutGetStackAlignment(LLVMTargetDataRef TD) {
     return unwrap(TD)->getStackAlignment();
 }
 
-bool ZigLLVMTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref, LLVMModuleRef module_ref,
-        const char *filename, ZigLLVM_EmitOutputType output_type, char **error_message, bool is_debug,
-        bool is_small, bool time_report)
+static bool emit_code(TargetMachine *target_machine, Module *module, TargetLibraryInfoImpl &tlii,
+        raw_pwrite_stream &dest, raw_pwrite_stream *dwo_dest, TargetMachine::CodeGenFileType ft,
+        char **error_message)
 {
-    TimePassesIsEnabled = time_report;
-
-    std::error_code EC;
-    raw_fd_ostream dest(filename, EC, sys::fs::F_None);
-    if (EC) {
-        *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+    legacy::PassManager CGPM;
+    CGPM.add(new(std::nothrow) TargetLibraryInfoWrapperPass(tlii));
+    CGPM.add(createTargetTransformInfoWrapperPass(target_machine->getTargetIRAnalysis()));
+    if (target_machine->addPassesToEmitFile(CGPM, dest, dwo_dest, ft)) {
+        *error_message = strdup("TargetMachine can't emit a file of this type");
         return true;
     }
-    TargetMachine* target_machine = reinterpret_cast<TargetMachine*>(targ_machine_ref);
-    target_machine->setO0WantsFastISel(true);
-
-    Module* module = unwrap(module_ref);
+    CGPM.run(*module);
+    return false;
+}
 
+static bool optimize_module(TargetMachine *target_machine, Module *module, TargetLibraryInfoImpl &tlii,
+        char **error_message, bool is_debug, bool is_small, bool thin_lto)
+{
     PassManagerBuilder *PMBuilder = new(std::nothrow) PassManagerBuilder();
     if (PMBuilder == nullptr) {
         *error_message = strdup("memory allocation failure");
@@ -193,10 +244,9 @@ bool ZigLLVMTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref, LLVMM
     PMBuilder->VerifyOutput = assertions_on;
     PMBuilder->MergeFunctions = !is_debug;
     PMBuilder->PrepareForLTO = false;
-    PMBuilder->PrepareForThinLTO = false;
+    PMBuilder->PrepareForThinLTO = thin_lto;
     PMBuilder->PerformThinLTO = false;
 
-    TargetLibraryInfoImpl tlii(Triple(module->getTargetTriple()));
     PMBuilder->LibraryInfo = &tlii;
 
     if (is_debug) {
@@ -223,26 +273,6 @@ bool ZigLLVMTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref, LLVMM
     MPM.add(createTargetTransformInfoWrapperPass(target_machine->getTargetIRAnalysis()));
     PMBuilder->populateModulePassManager(MPM);
 
-    // Set output pass.
-    TargetMachine::CodeGenFileType ft;
-    if (output_type != ZigLLVM_EmitLLVMIr) {
-        switch (output_type) {
-            case ZigLLVM_EmitAssembly:
-                ft = TargetMachine::CGFT_AssemblyFile;
-                break;
-            case ZigLLVM_EmitBinary:
-                ft = TargetMachine::CGFT_ObjectFile;
-                break;
-            default:
-                abort();
-        }
-
-        if (target_machine->addPassesToEmitFile(MPM, dest, nullptr, ft)) {
-            *error_message = strdup("TargetMachine can't emit a file of this type");
-            return true;
-        }
-    }
-
     // run per function optimization passes
     FPM.doInitialization();
     for (Function &F : *module)
@@ -251,19 +281,254 @@ bool ZigLLVMTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref, LLVMM
     FPM.doFinalization();
 
     MPM.run(*module);
+    return false;
+}
 
-    if (output_type == ZigLLVM_EmitLLVMIr) {
-        if (LLVMPrintModuleToFile(module_ref, filename, error_message)) {
+// Records the direct calls between functions of the optimized module as "CG Profile" module
+// metadata, the same form the CGProfile pass produces from PGO data. Instead of measured counts,
+// each call is weighted by the static frequency estimate of its block, which grows with loop
+// nesting and shrinks on paths to cold functions and unreachable code, relative to the entry of
+// the caller. The ELF backend emits this as a .llvm.call-graph-profile section, and LLD uses it
+// to place callers next to their hottest callees.
+static void add_static_call_graph_profile(Module *module) {
+    MapVector<std::pair<Function *, Function *>, uint64_t> counts;
+    for (Function &F : *module) {
+        if (F.isDeclaration() || F.hasFnAttribute(Attribute::Cold))
+            continue;
+        DominatorTree DT(F);
+        LoopInfo LI(DT);
+        BranchProbabilityInfo BPI(F, LI);
+        BlockFrequencyInfo BFI(F, BPI, LI);
+        // A call that runs once per call of the caller weighs 16.
+        uint64_t unit = std::max<uint64_t>(1, BFI.getEntryFreq() / 16);
+        for (BasicBlock &BB : F) {
+            uint64_t weight = BFI.getBlockFreq(&BB).getFrequency() / unit;
+            if (weight == 0)
+                continue;
+            for (Instruction &I : BB) {
+                CallBase *call = dyn_cast<CallBase>(&I);
+                if (call == nullptr)
+                    continue;
+                Function *callee = call->getCalledFunction();
+                if (callee == nullptr || callee->isIntrinsic() || callee->hasFnAttribute(Attribute::Cold))
+                    continue;
+                counts[std::make_pair(&F, callee)] += weight;
+            }
+        }
+    }
+    if (counts.empty())
+        return;
+
+    LLVMContext &context = module->getContext();
+    MDBuilder md_builder(context);
+    std::vector<Metadata *> nodes;
+    for (auto &entry : counts) {
+        Metadata *vals[] = {
+            ValueAsMetadata::get(entry.first.first),
+            ValueAsMetadata::get(entry.first.second),
+            md_builder.createConstant(ConstantInt::get(Type::getInt64Ty(context), entry.second)),
+        };
+        nodes.push_back(MDNode::get(context, vals));
+    }
+    module->addModuleFlag(Module::Append, "CG Profile", MDNode::get(context, nodes));
+}
+
+// Optimizes the module once, then produces each requested output from the result. Code generation
+// lowers the IR in place, so when both assembly and an object file are wanted, the assembly is
+// generated from a copy of the optimized module and both listings match.
+// With `thin_lto`, the object file is ThinLTO bitcode with a module summary, and machine code is
+// generated later by the linker.
+// With `dwo_dest`, the object file's split DWARF sections go there instead of into `bin_dest`.
+// With `debug_fast`, the optimizer pipeline is skipped. The always-inliner still runs, because
+// `inline` functions must be inlined in every build mode, and then the IR goes straight to instruction
+// selection.
+// With `call_graph_profile`, the static call graph of the optimized module is attached for the linker.
+static bool emit_module(LLVMTargetMachineRef targ_machine_ref, LLVMModuleRef module_ref,
+        raw_pwrite_stream *asm_dest, raw_pwrite_stream *bin_dest, raw_pwrite_stream *dwo_dest,
+        const char *llvm_ir_filename, const char *bitcode_filename, char **error_message, bool is_debug,
+        bool is_small, bool thin_lto, bool debug_fast, bool call_graph_profile)
+{
+    TargetMachine* target_machine = reinterpret_cast<TargetMachine*>(targ_machine_ref);
+    target_machine->setO0WantsFastISel(true);
+
+    Module* module = unwrap(module_ref);
+
+    TargetLibraryInfoImpl tlii(Triple(module->getTargetTriple()));
+
+    // GlobalISel is the faster selector at -O0 where it is mature. Functions it cannot
+    // handle fall back to SelectionDAG. The target machine may be shared between
+    // compilations, so the selector is chosen explicitly on every emission.
+    bool global_isel = debug_fast && Triple(module->getTargetTriple()).getArch() == Triple::aarch64;
+    target_machine->setGlobalISel(global_isel);
+    target_machine->setGlobalISelAbort(global_isel ? GlobalISelAbortMode::Disable : GlobalISelAbortMode::Enable);
+
+    if (debug_fast) {
+        legacy::PassManager MPM;
+        MPM.add(createAlwaysInlinerLegacyPass(false));
+        MPM.run(*module);
+    } else if (optimize_module(target_machine, module, tlii, error_message, is_debug, is_small, thin_lto)) {
+        return true;
+    }
+
+    if (call_graph_profile) {
+        add_static_call_graph_profile(module);
+    }
+
+    if (llvm_ir_filename != nullptr) {
+        if (LLVMPrintModuleToFile(module_ref, llvm_ir_filename, error_message)) {
+            return true;
+        }
+    }
+
+    if (bitcode_filename != nullptr) {
+        std::error_code EC;
+        raw_fd_ostream dest(bitcode_filename, EC, sys::fs::F_None);
+        if (EC) {
+            *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+            return true;
+        }
+        WriteBitcodeToFile(*module, dest);
+    }
+
+    if (asm_dest != nullptr) {
+        if (bin_dest != nullptr) {
+            std::unique_ptr<Module> asm_module = CloneModule(*module);
+            if (emit_code(target_machine, asm_module.get(), tlii, *asm_dest, nullptr,
+                        TargetMachine::CGFT_AssemblyFile, error_message))
+            {
+                return true;
+            }
+        } else if (emit_code(target_machine, module, tlii, *asm_dest, nullptr,
+                    TargetMachine::CGFT_AssemblyFile, error_message))
+        {
             return true;
         }
     }
 
+    if (bin_dest != nullptr) {
+        if (thin_lto) {
+            legacy::PassManager BCPM;
+            BCPM.add(createWriteThinLTOBitcodePass(*bin_dest));
+            BCPM.run(*module);
+        } else if (emit_code(target_machine, module, tlii, *bin_dest, dwo_dest,
+                    TargetMachine::CGFT_ObjectFile, error_message))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The skeleton compile unit in the object file names the .dwo file, so that debuggers can find it.
+static void set_split_dwarf_file(LLVMTargetMachineRef targ_machine_ref, const char *dwo_filename) {
+    TargetMachine* target_machine = reinterpret_cast<TargetMachine*>(targ_machine_ref);
+    target_machine->Options.MCOptions.SplitDwarfFile = (dwo_filename != nullptr) ? dwo_filename : "";
+}
+
+bool ZigLLVMTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref, LLVMModuleRef module_ref,
+        char **error_message, bool is_debug, bool is_small, bool time_report, bool thin_lto,
+        bool debug_fast, bool call_graph_profile, const char *asm_filename, const char *bin_filename,
+        const char *llvm_ir_filename, const char *bitcode_filename, const char *dwo_filename)
+{
+    TimePassesIsEnabled = time_report;
+
+    std::error_code EC;
+    std::unique_ptr<raw_fd_ostream> asm_dest;
+    if (asm_filename != nullptr) {
+        asm_dest.reset(new(std::nothrow) raw_fd_ostream(asm_filename, EC, sys::fs::F_None));
+        if (EC) {
+            *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+            return true;
+        }
+    }
+    std::unique_ptr<raw_fd_ostream> bin_dest;
+    if (bin_filename != nullptr) {
+        bin_dest.reset(new(std::nothrow) raw_fd_ostream(bin_filename, EC, sys::fs::F_None));
+        if (EC) {
+            *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+            return true;
+        }
+    }
+    std::unique_ptr<raw_fd_ostream> dwo_dest;
+    if (dwo_filename != nullptr && bin_filename != nullptr) {
+        dwo_dest.reset(new(std::nothrow) raw_fd_ostream(dwo_filename, EC, sys::fs::F_None));
+        if (EC) {
+            *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+            return true;
+        }
+    }
+    set_split_dwarf_file(targ_machine_ref, dwo_dest != nullptr ? dwo_filename : nullptr);
+
+    if (emit_module(targ_machine_ref, module_ref, asm_dest.get(), bin_dest.get(), dwo_dest.get(),
+                llvm_ir_filename, bitcode_filename, error_message, is_debug, is_small, thin_lto, debug_fast,
+                call_graph_profile))
+    {
+        return true;
+    }
+
     if (time_report) {
         TimerGroup::printAll(errs());
     }
     return false;
 }
 
+bool ZigLLVMTargetMachineEmitToLinkerMemory(LLVMTargetMachineRef targ_machine_ref, LLVMModuleRef module_ref,
+        const char *bin_filename, const char **out_ptr, size_t *out_len, char **error_message, bool is_debug,
+        bool is_small, bool time_report, bool thin_lto, bool debug_fast, bool call_graph_profile,
+        const char *asm_filename,
+        const char *llvm_ir_filename, const char *bitcode_filename, const char *dwo_filename)
+{
+    TimePassesIsEnabled = time_report;
+
+    std::error_code EC;
+    std::unique_ptr<raw_fd_ostream> asm_dest;
+    if (asm_filename != nullptr) {
+        asm_dest.reset(new(std::nothrow) raw_fd_ostream(asm_filename, EC, sys::fs::F_None));
+        if (EC) {
+            *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+            return true;
+        }
+    }
+
+    std::unique_ptr<raw_fd_ostream> dwo_dest;
+    if (dwo_filename != nullptr) {
+        dwo_dest.reset(new(std::nothrow) raw_fd_ostream(dwo_filename, EC, sys::fs::F_None));
+        if (EC) {
+            *error_message = strdup((const char *)StringRef(EC.message()).bytes_begin());
+            return true;
+        }
+    }
+    set_split_dwarf_file(targ_machine_ref, dwo_filename);
+
+    SmallVector<char, 0> object;
+    raw_svector_ostream bin_dest(object);
+    if (emit_module(targ_machine_ref, module_ref, asm_dest.get(), &bin_dest, dwo_dest.get(),
+                llvm_ir_filename, bitcode_filename, error_message, is_debug, is_small, thin_lto, debug_fast,
+                call_graph_profile))
+    {
+        return true;
+    }
+
+    std::unique_ptr<MemoryBuffer> mb(new(std::nothrow) SmallVectorMemoryBuffer(std::move(object), bin_filename));
+    if (mb == nullptr) {
+        *error_message = strdup("memory allocation failure");
+        return true;
+    }
+    *out_ptr = mb->getBufferStart();
+    *out_len = mb->getBufferSize();
+    lld::addInMemoryFile(bin_filename, std::move(mb));
+
+    if (time_report) {
+        TimerGroup::printAll(errs());
+    }
+    return false;
+}
+
+void ZigLLDRemoveInMemoryFile(const char *filename) {
+    lld::removeInMemoryFile(filename);
+}
+
 ZIG_EXTERN_C LLVMTypeRef ZigLLVMTokenTypeInContext(LLVMContextRef context_ref) {
   return wrap(Type::getTokenTy(*unwrap(context_ref)));
 }
@@ -646,14 +911,18 @@ ZigLLVMDIScope *ZigLLVMTypeToScope(ZigLLVMDIType *type) {
 ZigLLVMDICompileUnit *ZigLLVMCreateCompileUnit(ZigLLVMDIBuilder *dibuilder,
         unsigned lang, ZigLLVMDIFile *difile, const char *producer,
         bool is_optimized, const char *flags, unsigned runtime_version, const char *split_name,
-        uint64_t dwo_id, bool emit_debug_info)
+        uint64_t dwo_id, bool emit_debug_info, bool line_tables_only)
 {
+    DICompileUnit::DebugEmissionKind emission_kind = DICompileUnit::DebugEmissionKind::NoDebug;
+    if (emit_debug_info) {
+        emission_kind = line_tables_only ? DICompileUnit::DebugEmissionKind::LineTablesOnly :
+            DICompileUnit::DebugEmissionKind::FullDebug;
+    }
     DICompileUnit *result = reinterpret_cast<DIBuilder*>(dibuilder)->createCompileUnit(
             lang,
             reinterpret_cast<DIFile*>(difile),
             producer, is_optimized, flags, runtime_version, split_name,
-            (emit_debug_info ? DICompileUnit::DebugEmissionKind::FullDebug : DICompileUnit::DebugEmissionKind::NoDebug),
-            dwo_id);
+            emission_kind, dwo_id);
     return reinterpret_cast<ZigLLVMDICompileUnit*>(result);
 }
 
@@ -865,6 +1134,9 @@ void ZigLLVMAddModuleDebugInfoFlag(LLVMModuleRef module) {
 
 void ZigLLVMAddModuleCodeViewFlag(LLVMModuleRef module) {
     unwrap(module)->addModuleFlag(Module::Warning, "CodeView", 1);
+    // Emit .debug$H global type hashes, which LLD uses with /DEBUG:GHASH to
+    // merge type records without hashing them again.
+    unwrap(module)->addModuleFlag(Module::Warning, "CodeViewGHash", 1);
 }
 
 static AtomicOrdering mapFromLLVMOrdering(LLVMAtomicOrdering Ordering) {
@@ -922,6 +1194,107 @@ void ZigLLVMFunctionSetPrefixData(LLVMValueRef function, LLVMValueRef data) {
     unwrap<Function>(function)->setPrefixData(unwrap<Constant>(data));
 }
 
+void ZigLLVMSetFunctionEntryCounts(LLVMModuleRef module_ref, LLVMValueRef *fns, const uint64_t *counts,
+        size_t count)
+{
+    InstrProfSummaryBuilder builder(ProfileSummaryBuilder::DefaultCutoffs);
+    for (size_t i = 0; i < count; i += 1) {
+        unwrap<Function>(fns[i])->setEntryCount(Function::ProfileCount(counts[i], Function::PCT_Real));
+        builder.addRecord(InstrProfRecord(std::vector<uint64_t>(1, counts[i])));
+    }
+    Module *module = unwrap(module_ref);
+    module->addModuleFlag(Module::Error, "ProfileSummary", builder.getSummary()->getMD(module->getContext()));
+}
+
+size_t ZigLLVMMergeIdenticalFunctions(LLVMValueRef *fns, size_t fn_count, bool create_aliases,
+        size_t *out_kept_index, size_t *out_instruction_counts)
+{
+    // Only functions that nothing outside the module can observe are candidates: local linkage,
+    // and unnamed_addr so that two of them sharing an address is allowed.
+    std::vector<std::pair<FunctionComparator::FunctionHash, size_t>> candidates;
+    for (size_t i = 0; i < fn_count; i += 1) {
+        out_kept_index[i] = SIZE_MAX;
+        out_instruction_counts[i] = 0;
+        Function *fn = (fns[i] == nullptr) ? nullptr : unwrap<Function>(fns[i]);
+        if (fn == nullptr || fn->isDeclaration() || !fn->hasLocalLinkage() || !fn->hasGlobalUnnamedAddr())
+            continue;
+        candidates.push_back(std::make_pair(0, i));
+    }
+
+    // Replacing a function with its twin can make its callers identical too, so keep going
+    // until a round merges nothing.
+    size_t merged_count = 0;
+    for (;;) {
+        for (auto &candidate : candidates) {
+            candidate.first = FunctionComparator::functionHash(*unwrap<Function>(fns[candidate.second]));
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        GlobalNumberState global_numbers;
+        std::vector<std::pair<FunctionComparator::FunctionHash, size_t>> survivors;
+        size_t round_merged_count = 0;
+        size_t bucket_start = 0;
+        while (bucket_start < candidates.size()) {
+            size_t bucket_end = bucket_start + 1;
+            while (bucket_end < candidates.size() && candidates[bucket_end].first == candidates[bucket_start].first)
+                bucket_end += 1;
+
+            size_t kept_start = survivors.size();
+            for (size_t cand_i = bucket_start; cand_i < bucket_end; cand_i += 1) {
+                size_t index = candidates[cand_i].second;
+                Function *fn = unwrap<Function>(fns[index]);
+                Function *keep = nullptr;
+                size_t keep_index = SIZE_MAX;
+                for (size_t kept_i = kept_start; kept_i < survivors.size(); kept_i += 1) {
+                    keep_index = survivors[kept_i].second;
+                    Function *other = unwrap<Function>(fns[keep_index]);
+                    if (FunctionComparator(other, fn, &global_numbers).compare() == 0) {
+                        keep = other;
+                        break;
+                    }
+                }
+                if (keep == nullptr) {
+                    survivors.push_back(candidates[cand_i]);
+                    continue;
+                }
+
+                out_kept_index[index] = keep_index;
+                out_instruction_counts[index] = fn->getInstructionCount();
+                if (fn->getAlignment() > keep->getAlignment())
+                    keep->setAlignment(fn->getAlignment());
+
+                Constant *replacement = ConstantExpr::getBitCast(keep, fn->getType());
+                fn->replaceAllUsesWith(replacement);
+                if (create_aliases) {
+                    GlobalAlias *alias = GlobalAlias::create(fn->getValueType(), fn->getAddressSpace(),
+                            fn->getLinkage(), "", replacement, fn->getParent());
+                    alias->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+                    alias->takeName(fn);
+                    fns[index] = wrap(alias);
+                } else {
+                    fns[index] = nullptr;
+                }
+                fn->eraseFromParent();
+                round_merged_count += 1;
+            }
+            bucket_start = bucket_end;
+        }
+        candidates.swap(survivors);
+        merged_count += round_merged_count;
+        if (round_merged_count == 0)
+            break;
+    }
+
+    // A function kept in one round may itself have been merged in a later one.
+    for (size_t i = 0; i < fn_count; i += 1) {
+        if (out_kept_index[i] == SIZE_MAX)
+            continue;
+        while (out_kept_index[out_kept_index[i]] != SIZE_MAX) {
+            out_kept_index[i] = out_kept_index[out_kept_index[i]];
+        }
+    }
+    return merged_count;
+}
 
 class MyOStream: public raw_ostream {
     public:
@@ -1057,6 +1430,143 @@ bool ZigLLVMWriteArchive(const char *archive_name, const char **file_names, size
     return false;
 }
 
+namespace {
+struct ObjectSymbolEntry {
+    StringRef name;
+    uint64_t address;
+    uint64_t size;
+    uint64_t section_index;
+    bool is_function;
+};
+}
+
+bool ZigLLVMReadObjectSymbols(const char *data, size_t data_len,
+        ZigLLVMObjectSymbol **out_symbols, size_t *out_symbol_count,
+        ZigLLVMObjectSection **out_sections, size_t *out_section_count, char **error_message)
+{
+    MemoryBufferRef buffer_ref(StringRef(data, data_len), "");
+    Expected<std::unique_ptr<object::ObjectFile>> obj_or_err = object::ObjectFile::createObjectFile(buffer_ref);
+    if (!obj_or_err) {
+        *error_message = strdup(toString(obj_or_err.takeError()).c_str());
+        return true;
+    }
+    object::ObjectFile *obj = obj_or_err->get();
+    bool is_elf = isa<object::ELFObjectFileBase>(obj);
+
+    std::vector<object::SectionRef> sections;
+    for (const object::SectionRef &section : obj->sections()) {
+        sections.push_back(section);
+    }
+
+    std::vector<ObjectSymbolEntry> entries;
+    for (const object::SymbolRef &symbol : obj->symbols()) {
+        uint32_t flags = symbol.getFlags();
+        if ((flags & object::SymbolRef::SF_Undefined) || (flags & object::SymbolRef::SF_FormatSpecific))
+            continue;
+        Expected<object::SymbolRef::Type> type = symbol.getType();
+        if (!type) {
+            consumeError(type.takeError());
+            continue;
+        }
+        if (*type != object::SymbolRef::ST_Function && *type != object::SymbolRef::ST_Data)
+            continue;
+        Expected<StringRef> name = symbol.getName();
+        Expected<uint64_t> address = symbol.getAddress();
+        Expected<object::section_iterator> section = symbol.getSection();
+        if (!name || !address || !section || *section == obj->section_end()) {
+            if (!name) consumeError(name.takeError());
+            if (!address) consumeError(address.takeError());
+            if (!section) consumeError(section.takeError());
+            continue;
+        }
+        ObjectSymbolEntry entry;
+        entry.name = *name;
+        entry.address = *address;
+        entry.size = is_elf ? object::ELFSymbolRef(symbol).getSize() : 0;
+        entry.section_index = (*section)->getIndex();
+        entry.is_function = (*type == object::SymbolRef::ST_Function);
+        entries.push_back(entry);
+    }
+
+    // Formats other than ELF do not record symbol sizes, so a symbol is assumed to extend
+    // to the next symbol in its section, or to the end of the section. Aliases share the
+    // address of their target and are counted once.
+    std::stable_sort(entries.begin(), entries.end(), [](const ObjectSymbolEntry &a, const ObjectSymbolEntry &b) {
+        if (a.section_index != b.section_index)
+            return a.section_index < b.section_index;
+        return a.address < b.address;
+    });
+    for (size_t i = 0; i < entries.size(); i += 1) {
+        ObjectSymbolEntry *entry = &entries[i];
+        if (i != 0 && entries[i - 1].section_index == entry->section_index &&
+            entries[i - 1].address == entry->address)
+        {
+            entry->size = 0;
+            continue;
+        }
+        if (entry->size != 0)
+            continue;
+        size_t next_i = i + 1;
+        while (next_i < entries.size() && entries[next_i].section_index == entry->section_index &&
+                entries[next_i].address == entry->address)
+        {
+            next_i += 1;
+        }
+        if (next_i < entries.size() && entries[next_i].section_index == entry->section_index) {
+            entry->size = entries[next_i].address - entry->address;
+        } else {
+            for (const object::SectionRef &section : sections) {
+                if (section.getIndex() != entry->section_index)
+                    continue;
+                uint64_t section_end = section.getAddress() + section.getSize();
+                if (section_end > entry->address)
+                    entry->size = section_end - entry->address;
+                break;
+            }
+        }
+    }
+
+    ZigLLVMObjectSymbol *symbols = (ZigLLVMObjectSymbol *)calloc(entries.size() + 1, sizeof(ZigLLVMObjectSymbol));
+    for (size_t i = 0; i < entries.size(); i += 1) {
+        symbols[i].name = strdup(entries[i].name.str().c_str());
+        symbols[i].size = entries[i].size;
+        symbols[i].is_function = entries[i].is_function;
+    }
+    *out_symbols = symbols;
+    *out_symbol_count = entries.size();
+
+    ZigLLVMObjectSection *out = (ZigLLVMObjectSection *)calloc(sections.size() + 1, sizeof(ZigLLVMObjectSection));
+    size_t section_count = 0;
+    for (const object::SectionRef &section : sections) {
+        Expected<StringRef> name = section.getName();
+        if (!name) {
+            consumeError(name.takeError());
+            continue;
+        }
+        if (name->empty())
+            continue;
+        ZigLLVMObjectSection *out_section = &out[section_count];
+        section_count += 1;
+        out_section->name = strdup(name->str().c_str());
+        out_section->size = section.getSize();
+        if (section.isText()) {
+            out_section->kind = ZigLLVMObjectSectionKindCode;
+        } else if (section.isBSS()) {
+            out_section->kind = ZigLLVMObjectSectionKindBss;
+        } else if (section.isData()) {
+            out_section->kind = ZigLLVMObjectSectionKindData;
+        } else {
+            out_section->kind = ZigLLVMObjectSectionKindOther;
+        }
+        if (is_elf && !(object::ELFSectionRef(section).getFlags() & ELF::SHF_ALLOC)) {
+            out_section->kind = ZigLLVMObjectSectionKindOther;
+        }
+    }
+    *out_sections = out;
+    *out_section_count = section_count;
+    return false;
+}
+
 
 bool ZigLLDLink(ZigLLVM_ObjectFormatType oformat, const char **args, size_t arg_count,
         void (*append_diagnostic)(void *, const char *, size_t), void *context)
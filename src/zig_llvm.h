@@ -46,17 +46,31 @@ ZIG_EXTERN_C void ZigLLVMInitializeLowerIntrinsicsPass(LLVMPassRegistryRef R);
 ZIG_EXTERN_C char *ZigLLVMGetHostCPUName(void);
 ZIG_EXTERN_C char *ZigLLVMGetNativeFeatures(void);
 
-// We use a custom enum here since LLVM does not expose LLVMIr as an emit
-// output through the same mechanism as assembly/binary.
-enum ZigLLVM_EmitOutputType {
-    ZigLLVM_EmitAssembly,
-    ZigLLVM_EmitBinary,
-    ZigLLVM_EmitLLVMIr,
-};
-
+// Checks `cpu` and each entry of the comma separated `features` ("+name" or "-name") against
+// LLVM's tables for `triple`. Returns true and sets `error_message` for the first unknown one.
+ZIG_EXTERN_C bool ZigLLVMValidateCPUAndFeatures(LLVMTargetRef T, const char *triple, const char *cpu,
+        const char *features, char **error_message);
+
+// Optimizes the module once and writes every output whose filename is non-null. With `thin_lto`
+// the object file is ThinLTO summary bitcode rather than machine code. With `debug_fast` the
+// optimizer is skipped and only `inline` functions are inlined before instruction selection.
+// A non-null `dwo_filename` moves the object file's debug info into that split DWARF file.
+// With `call_graph_profile`, calls are recorded with static weights for the linker to order
+// functions by, as with a call graph profile from PGO.
 ZIG_EXTERN_C bool ZigLLVMTargetMachineEmitToFile(LLVMTargetMachineRef targ_machine_ref, LLVMModuleRef module_ref,
-        const char *filename, enum ZigLLVM_EmitOutputType output_type, char **error_message, bool is_debug,
-        bool is_small, bool time_report);
+        char **error_message, bool is_debug, bool is_small, bool time_report, bool thin_lto,
+        bool debug_fast, bool call_graph_profile, const char *asm_filename, const char *bin_filename,
+        const char *llvm_ir_filename, const char *bitcode_filename, const char *dwo_filename);
+
+// Like ZigLLVMTargetMachineEmitToFile, but the object file is kept in memory and registered with
+// the embedded LLD under `bin_filename`, so that ZigLLDLink uses the buffer when `bin_filename` is
+// one of its inputs. The buffer stays valid until ZigLLDRemoveInMemoryFile is called with the same
+// name. The other outputs are still written to disk.
+ZIG_EXTERN_C bool ZigLLVMTargetMachineEmitToLinkerMemory(LLVMTargetMachineRef targ_machine_ref,
+        LLVMModuleRef module_ref, const char *bin_filename, const char **out_ptr, size_t *out_len,
+        char **error_message, bool is_debug, bool is_small, bool time_report, bool thin_lto,
+        bool debug_fast, bool call_graph_profile, const char *asm_filename, const char *llvm_ir_filename,
+        const char *bitcode_filename, const char *dwo_filename);
 
 ZIG_EXTERN_C LLVMTargetMachineRef ZigLLVMCreateTargetMachine(LLVMTargetRef T, const char *Triple,
     const char *CPU, const char *Features, LLVMCodeGenOptLevel Level, LLVMRelocMode Reloc,
@@ -185,7 +199,7 @@ ZIG_EXTERN_C struct ZigLLVMDILexicalBlock *ZigLLVMCreateLexicalBlock(struct ZigL
 ZIG_EXTERN_C struct ZigLLVMDICompileUnit *ZigLLVMCreateCompileUnit(struct ZigLLVMDIBuilder *dibuilder,
         unsigned lang, struct ZigLLVMDIFile *difile, const char *producer,
         bool is_optimized, const char *flags, unsigned runtime_version, const char *split_name,
-        uint64_t dwo_id, bool emit_debug_info);
+        uint64_t dwo_id, bool emit_debug_info, bool line_tables_only);
 
 ZIG_EXTERN_C struct ZigLLVMDIFile *ZigLLVMCreateFile(struct ZigLLVMDIBuilder *dibuilder, const char *filename,
         const char *directory);
@@ -214,6 +228,20 @@ ZIG_EXTERN_C void ZigLLVMSetFastMath(LLVMBuilderRef builder_wrapped, bool on_sta
 ZIG_EXTERN_C void ZigLLVMSetTailCall(LLVMValueRef Call);
 ZIG_EXTERN_C void ZigLLVMFunctionSetPrefixData(LLVMValueRef fn, LLVMValueRef data);
 
+// Attaches profiled entry counts to the functions and a matching profile summary to the
+// module, which is what lets the optimizer and code generator tell hot code from cold.
+ZIG_EXTERN_C void ZigLLVMSetFunctionEntryCounts(LLVMModuleRef module, LLVMValueRef *fns,
+        const uint64_t *counts, size_t count);
+
+// Merges functions whose bodies are identical once signedness and pointee types are erased.
+// Each duplicate's uses are redirected to the function that is kept and the duplicate is
+// deleted, leaving an alias with its name when `create_aliases` is set. `fns` is updated to the
+// alias, or null. For every merged function, `out_kept_index` holds the index in `fns` of the
+// function it was merged into (SIZE_MAX otherwise) and `out_instruction_counts` its size.
+// Returns the number of merged functions.
+ZIG_EXTERN_C size_t ZigLLVMMergeIdenticalFunctions(LLVMValueRef *fns, size_t fn_count, bool create_aliases,
+        size_t *out_kept_index, size_t *out_instruction_counts);
+
 ZIG_EXTERN_C void ZigLLVMAddFunctionAttr(LLVMValueRef fn, const char *attr_name, const char *attr_value);
 ZIG_EXTERN_C void ZigLLVMAddByValAttr(LLVMValueRef fn_ref, unsigned ArgNo, LLVMTypeRef type_val);
 ZIG_EXTERN_C void ZigLLVMAddFunctionAttrCold(LLVMValueRef fn);
@@ -461,10 +489,38 @@ ZIG_EXTERN_C const char *ZigLLVMGetEnvironmentTypeName(enum ZigLLVM_EnvironmentT
 
 ZIG_EXTERN_C bool ZigLLDLink(enum ZigLLVM_ObjectFormatType oformat, const char **args, size_t arg_count,
         void (*append_diagnostic)(void *, const char *, size_t), void *context);
+ZIG_EXTERN_C void ZigLLDRemoveInMemoryFile(const char *filename);
 
 ZIG_EXTERN_C bool ZigLLVMWriteArchive(const char *archive_name, const char **file_names, size_t file_name_count,
         enum ZigLLVM_OSType os_type);
 
+struct ZigLLVMObjectSymbol {
+    const char *name;
+    uint64_t size;
+    bool is_function;
+};
+
+enum ZigLLVMObjectSectionKind {
+    ZigLLVMObjectSectionKindCode,
+    ZigLLVMObjectSectionKindData,
+    ZigLLVMObjectSectionKindBss,
+    ZigLLVMObjectSectionKindOther,
+};
+
+struct ZigLLVMObjectSection {
+    const char *name;
+    uint64_t size;
+    enum ZigLLVMObjectSectionKind kind;
+};
+
+// Lists the functions and data objects defined by an object file or linked binary, and its
+// sections. Where the format does not record symbol sizes, a symbol is assumed to extend to
+// the next symbol in its section. Sections that are not loaded at runtime are reported as
+// ZigLLVMObjectSectionKindOther. The returned arrays and strings are allocated with malloc.
+ZIG_EXTERN_C bool ZigLLVMReadObjectSymbols(const char *data, size_t data_len,
+        struct ZigLLVMObjectSymbol **out_symbols, size_t *out_symbol_count,
+        struct ZigLLVMObjectSection **out_sections, size_t *out_section_count, char **error_message);
+
 bool ZigLLVMWriteImportLibrary(const char *def_path, const ZigLLVM_ArchType arch,
                                const char *output_lib_path, const bool kill_at);
 
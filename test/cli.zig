@@ -35,6 +35,9 @@ pub fn main() !void {
         testZigInitExe,
         testGodboltApi,
         testMissingOutputPath,
+        testEmitMultiple,
+        testSizeReport,
+        testSafetyReport,
     };
     for (test_fns) |testFn| {
         try fs.deleteTree(dir_path);
@@ -139,3 +142,148 @@ fn testMissingOutputPath(zig_exe: []const u8, dir_path: []const u8) !void {
         zig_exe, "build-exe", source_path, "--output-dir", output_path,
     });
 }
+
+fn testEmitMultiple(zig_exe: []const u8, dir_path: []const u8) !void {
+    const example_zig_path = try fs.path.join(a, [_][]const u8{ dir_path, "example.zig" });
+    const example_ll_path = try fs.path.join(a, [_][]const u8{ dir_path, "example.ll" });
+    const listing_s_path = try fs.path.join(a, [_][]const u8{ dir_path, "listing.s" });
+
+    try std.io.writeFile(example_zig_path,
+        \\export fn square(num: i32) i32 {
+        \\    return num * num;
+        \\}
+    );
+
+    const args = [_][]const u8{
+        zig_exe,           "build-obj",
+        "--cache-dir",     dir_path,
+        "--name",          "example",
+        "--output-dir",    dir_path,
+        "-femit-llvm-ir",  try std.fmt.allocPrint(a, "-femit-asm={}", listing_s_path),
+        example_zig_path,  "--disable-gen-h",
+    };
+    _ = try exec(dir_path, args);
+
+    const o_ext = if (builtin.os == .windows) ".obj" else ".o";
+    const out_obj = try fs.path.join(a, [_][]const u8{ dir_path, "example" ++ o_ext });
+    _ = try std.io.readFileAlloc(a, out_obj);
+    const out_ll = try std.io.readFileAlloc(a, example_ll_path);
+    testing.expect(std.mem.indexOf(u8, out_ll, "@square") != null);
+    const out_asm = try std.io.readFileAlloc(a, listing_s_path);
+    testing.expect(std.mem.indexOf(u8, out_asm, "square") != null);
+}
+
+fn testSizeReport(zig_exe: []const u8, dir_path: []const u8) !void {
+    const example_zig_path = try fs.path.join(a, [_][]const u8{ dir_path, "example.zig" });
+
+    try std.io.writeFile(example_zig_path,
+        \\const table = blk: {
+        \\    var result: [256]u32 = undefined;
+        \\    for (result) |*x, i| x.* = @intCast(u32, i * i);
+        \\    break :blk result;
+        \\};
+        \\export fn lookup(i: u8) u32 {
+        \\    return table[i];
+        \\}
+        \\pub fn main() void {}
+    );
+
+    const result = try exec(dir_path, [_][]const u8{
+        zig_exe,        "build-exe",
+        "--cache-dir",  dir_path,
+        "--output-dir", dir_path,
+        "--name",       "example",
+        "--release-small",
+        "-fsize-report=json",
+        example_zig_path,
+    });
+    var parser = std.json.Parser.init(a, false);
+    const tree = try parser.parse(result.stdout);
+    const report = tree.root.Object;
+
+    // The 1 KiB comptime table has no symbol of its own; it is charged to `lookup`.
+    const lookup = findSizeReportRow(report.get("decls").?.value, "lookup").?;
+    testing.expect(lookup.get("size").?.value.Integer >= 256 * @sizeOf(u32));
+
+    var symbol_total: i64 = 0;
+    for (report.get("symbols").?.value.Array.toSliceConst()) |symbol| {
+        symbol_total += symbol.Object.get("size").?.value.Integer;
+    }
+    testing.expect(symbol_total == report.get("totalSize").?.value.Integer);
+
+    const root_pkg = findSizeReportRow(report.get("packages").?.value, "root").?;
+    testing.expect(root_pkg.get("size").?.value.Integer >= lookup.get("size").?.value.Integer);
+    testing.expect(report.get("sections").?.value.Array.len != 0);
+}
+
+fn testSafetyReport(zig_exe: []const u8, dir_path: []const u8) !void {
+    const example_zig_path = try fs.path.join(a, [_][]const u8{ dir_path, "example.zig" });
+
+    try std.io.writeFile(example_zig_path,
+        \\fn addTwice(items: []const u8, i: usize) u8 {
+        \\    return items[i] +% items[i];
+        \\}
+        \\fn sumWhile(items: []const u8) u8 {
+        \\    var total: u8 = 0;
+        \\    var i: usize = 0;
+        \\    while (i < items.len) : (i += 1) {
+        \\        total +%= items[i];
+        \\    }
+        \\    return total;
+        \\}
+        \\fn sumEscaped(items: []const u8) u8 {
+        \\    var total: u8 = 0;
+        \\    var i: usize = 0;
+        \\    const p = &i;
+        \\    while (i < items.len) : (i += 1) {
+        \\        total +%= items[p.*];
+        \\    }
+        \\    return total;
+        \\}
+        \\export fn entry(ptr: [*]const u8, len: usize) u8 {
+        \\    const items = ptr[0..len];
+        \\    return addTwice(items, 0) +% sumWhile(items) +% sumEscaped(items);
+        \\}
+    );
+
+    const result = try exec(dir_path, [_][]const u8{
+        zig_exe,        "build-obj",
+        "--cache-dir",  dir_path,
+        "--output-dir", dir_path,
+        "--name",       "example",
+        "-fsafety-report",
+        example_zig_path,
+    });
+    var parser = std.json.Parser.init(a, false);
+    const tree = try parser.parse(result.stdout);
+    const report = tree.root.Object;
+
+    // The second bounds check on the same index.
+    testing.expect(findSafetyReportCount(report, "addTwice").? == 1);
+    // The bounds check in the body and the overflow check on `i += 1`, both implied by the
+    // loop condition.
+    testing.expect(findSafetyReportCount(report, "sumWhile").? == 2);
+    // Taking the counter's address keeps its checks.
+    testing.expect(findSafetyReportCount(report, "sumEscaped") == null);
+
+    var fn_total: i64 = 0;
+    for (report.get("fns").?.value.Array.toSliceConst()) |row| {
+        fn_total += row.Object.get("removedChecks").?.value.Integer;
+    }
+    testing.expect(fn_total == report.get("removedChecks").?.value.Integer);
+}
+
+fn findSafetyReportCount(report: std.json.ObjectMap, name: []const u8) ?i64 {
+    for (report.get("fns").?.value.Array.toSliceConst()) |row| {
+        if (std.mem.endsWith(u8, row.Object.get("fn").?.value.String, name))
+            return row.Object.get("removedChecks").?.value.Integer;
+    }
+    return null;
+}
+
+fn findSizeReportRow(rows: std.json.Value, name: []const u8) ?std.json.ObjectMap {
+    for (rows.Array.toSliceConst()) |row| {
+        if (std.mem.eql(u8, row.Object.get("name").?.value.String, name)) return row.Object;
+    }
+    return null;
+}
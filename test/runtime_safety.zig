@@ -269,6 +269,113 @@ pub fn addCases(cases: *tests.CompareOutputContext) void {
         \\fn baz(a: i32) void { }
     );
 
+    cases.addRuntimeSafety("bounds check after the index changes in a loop",
+        \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
+        \\    @import("std").os.exit(126);
+        \\}
+        \\pub fn main() void {
+        \\    const a = [_]u8{1, 2, 3};
+        \\    _ = sumPairs(a);
+        \\}
+        \\fn sumPairs(a: []const u8) u8 {
+        \\    var total: u8 = 0;
+        \\    var i: usize = 0;
+        \\    while (i < a.len) : (i += 1) {
+        \\        total +%= a[i];
+        \\        i += 1;
+        \\        total +%= a[i];
+        \\    }
+        \\    return total;
+        \\}
+    );
+
+    cases.addRuntimeSafety("bounds check on a catch path that skips the earlier check",
+        \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
+        \\    @import("std").os.exit(126);
+        \\}
+        \\pub fn main() void {
+        \\    const a = [_]u8{1, 2, 3};
+        \\    _ = get(a, 5, true);
+        \\}
+        \\fn mayFail(fail: bool) !void {
+        \\    if (fail) return error.Fail;
+        \\}
+        \\fn get(a: []const u8, i: usize, fail: bool) u8 {
+        \\    const first = blk: {
+        \\        mayFail(fail) catch break :blk 0;
+        \\        break :blk a[i];
+        \\    };
+        \\    return first +% a[i];
+        \\}
+    );
+
+    cases.addRuntimeSafety("bounds check on the else path of a bounds test",
+        \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
+        \\    @import("std").os.exit(126);
+        \\}
+        \\pub fn main() void {
+        \\    const a = [_]u8{1, 2, 3};
+        \\    _ = get(a, 3);
+        \\}
+        \\fn get(a: []const u8, i: usize) u8 {
+        \\    if (i < a.len) {
+        \\        return a[i];
+        \\    } else {
+        \\        return a[i];
+        \\    }
+        \\}
+    );
+
+    cases.addRuntimeSafety("adding one to a value that was never bounded",
+        \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
+        \\    @import("std").os.exit(126);
+        \\}
+        \\pub fn main() !void {
+        \\    const a = [_]u8{1, 2, 3};
+        \\    const x = next(a, 1, @import("std").math.maxInt(usize));
+        \\    if (x == 0) return error.Whatever;
+        \\}
+        \\fn next(a: []const u8, i: usize, x: usize) usize {
+        \\    if (a[i] == 0) return 0;
+        \\    return x + 1;
+        \\}
+    );
+
+    cases.addRuntimeSafety("bounds check after the loop counter changes through a pointer",
+        \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
+        \\    @import("std").os.exit(126);
+        \\}
+        \\pub fn main() void {
+        \\    const a = [_]u8{1, 2, 3};
+        \\    _ = sum(a);
+        \\}
+        \\fn sum(a: []const u8) u8 {
+        \\    var total: u8 = 0;
+        \\    var i: usize = 0;
+        \\    const p = &i;
+        \\    while (i < a.len) : (i += 1) {
+        \\        p.* += 1;
+        \\        total +%= a[i];
+        \\    }
+        \\    return total;
+        \\}
+    );
+
+    cases.addRuntimeSafety("optional unwrap after a failed null test",
+        \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
+        \\    @import("std").os.exit(126);
+        \\}
+        \\pub fn main() void {
+        \\    _ = get(null);
+        \\}
+        \\fn get(opt: ?u8) u8 {
+        \\    if (opt != null) {
+        \\        return opt.? +% 1;
+        \\    }
+        \\    return opt.?;
+        \\}
+    );
+
     cases.addRuntimeSafety("integer addition overflow",
         \\pub fn panic(message: []const u8, stack_trace: ?*@import("builtin").StackTrace) noreturn {
         \\    @import("std").os.exit(126);
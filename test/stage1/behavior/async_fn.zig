@@ -1268,3 +1268,44 @@ test "spill target expr in a for loop, with a var decl in the loop body" {
     resume S.global_frame;
     resume S.global_frame;
 }
+
+test "locals in sibling blocks share frame storage" {
+    const S = struct {
+        var global_frame: anyframe = undefined;
+        var result: u32 = 0;
+
+        fn fill(buf: []u8, x: u8) u8 {
+            for (buf) |*b| b.* = x;
+            return buf[buf.len - 1];
+        }
+
+        fn work() void {
+            var outer: u8 = 100;
+            {
+                var first: [256]u8 = undefined;
+                result += fill(first[0..], 1);
+                suspend {
+                    global_frame = @frame();
+                }
+                result += first[0] + first[255];
+            }
+            {
+                var second: [256]u8 = undefined;
+                result += fill(second[0..], 2);
+                suspend {
+                    global_frame = @frame();
+                }
+                result += second[0] + second[255];
+            }
+            // Lives across both blocks, so it must not share with either.
+            result += outer;
+        }
+    };
+    comptime expect(@sizeOf(@Frame(S.work)) < 2 * 256);
+    _ = async S.work();
+    expect(S.result == 1);
+    resume S.global_frame;
+    expect(S.result == 1 + 2 + 2);
+    resume S.global_frame;
+    expect(S.result == 1 + 2 + 2 + 4 + 100);
+}
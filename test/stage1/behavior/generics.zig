@@ -149,3 +149,30 @@ test "array of generic fns" {
     expect(foos[0](true));
     expect(!foos[1](true));
 }
+
+fn sumItems(comptime T: type, items: []const T) T {
+    var total: T = 0;
+    for (items) |item| total +%= item;
+    return total;
+}
+
+fn sumU32(items: []const u32) u32 {
+    return sumItems(u32, items);
+}
+
+fn sumI32(items: []const i32) i32 {
+    return sumItems(i32, items);
+}
+
+test "generic instantiations that lower to the same code" {
+    // With -fdedup-fns these share one body, and so do their callers.
+    expect(sumItems(u32, [_]u32{ 1, 2, 3 }) == 6);
+    expect(sumItems(i32, [_]i32{ -1, 2, -3 }) == -2);
+    expect(sumU32([_]u32{ 0xffffffff, 2 }) == 1);
+    expect(sumI32([_]i32{ -1, -2 }) == -3);
+
+    var sum_u32: fn ([]const u32) u32 = sumU32;
+    var sum_i32: fn ([]const i32) i32 = sumI32;
+    expect(sum_u32([_]u32{4}) == 4);
+    expect(sum_i32([_]i32{-4}) == -4);
+}
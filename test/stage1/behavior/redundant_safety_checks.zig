@@ -0,0 +1,95 @@
+const std = @import("std");
+const expect = std.testing.expect;
+
+// These functions contain safety checks that an earlier check or a branch
+// condition already proves, which the compiler removes. They must still
+// compute the same results.
+
+fn addTwice(items: []const u8, i: usize) u8 {
+    return items[i] +% items[i];
+}
+
+test "repeated bounds check on the same index" {
+    const items = [_]u8{ 1, 2, 3 };
+    expect(addTwice(items[0..], 2) == 6);
+}
+
+fn getOrZero(items: []const u8, i: usize) u8 {
+    if (i < items.len) return items[i];
+    return 0;
+}
+
+fn getFromArray(items: [4]u8, i: usize) u8 {
+    if (i < 4) return items[i];
+    return 0;
+}
+
+test "bounds check after a bounds test" {
+    const items = [_]u8{ 1, 2, 3, 4 };
+    expect(getOrZero(items[0..], 1) == 2);
+    expect(getOrZero(items[0..], 4) == 0);
+    expect(getFromArray(items, 3) == 4);
+    expect(getFromArray(items, 4) == 0);
+}
+
+fn nextIndex(items: []const u8, i: usize) usize {
+    if (i < items.len) return i + 1;
+    return i;
+}
+
+test "adding one to an index known to be in bounds" {
+    const items = [_]u8{ 1, 2, 3 };
+    expect(nextIndex(items[0..], 2) == 3);
+    expect(nextIndex(items[0..], 3) == 3);
+}
+
+fn sumWithIndex(items: []const u8) u32 {
+    var total: u32 = 0;
+    for (items) |x, i| {
+        total += items[i];
+        total += x;
+    }
+    return total;
+}
+
+test "indexing with the for loop index capture" {
+    const items = [_]u8{ 1, 2, 3 };
+    expect(sumWithIndex(items[0..]) == 12);
+}
+
+fn sumWhile(items: []const u8) u32 {
+    var total: u32 = 0;
+    var i: usize = 0;
+    while (i < items.len) : (i += 1) {
+        total += items[i];
+    }
+    return total;
+}
+
+test "indexing with a while loop counter" {
+    const items = [_]u8{ 1, 2, 3 };
+    expect(sumWhile(items[0..]) == 6);
+}
+
+fn squareOrZero(opt: ?u8) u8 {
+    if (opt != null) return opt.? *% opt.?;
+    return 0;
+}
+
+test "optional unwrap after a null test" {
+    expect(squareOrZero(3) == 9);
+    expect(squareOrZero(null) == 0);
+}
+
+const Number = union {
+    int: u32,
+    float: f32,
+};
+
+fn doubleInt(n: Number) u32 {
+    return n.int + n.int;
+}
+
+test "repeated union field access" {
+    expect(doubleInt(Number{ .int = 21 }) == 42);
+}
@@ -19,10 +19,16 @@ pub fn addCases(cases: *tests.StandaloneContext) void {
     cases.addBuildFile("test/standalone/use_alias/build.zig");
     cases.addBuildFile("test/standalone/brace_expansion/build.zig");
     cases.addBuildFile("test/standalone/empty_env/build.zig");
+    cases.addBuildFile("test/standalone/cpu_features/build.zig");
     if (builtin.os == builtin.Os.linux) {
         // TODO hook up the DynLib API for windows using LoadLibraryA
         // TODO figure out how to make this work on darwin - probably libSystem has dlopen/dlsym in it
         cases.addBuildFile("test/standalone/load_dynamic_library/build.zig");
+        cases.addBuildFile("test/standalone/profile_guided/build.zig");
+        cases.addBuildFile("test/standalone/thin_lto/build.zig");
+        cases.addBuildFile("test/standalone/reduced_debug_info/build.zig");
+        cases.addBuildFile("test/standalone/icf/build.zig");
+        cases.addBuildFile("test/standalone/call_graph_profile/build.zig");
     }
 
     if (builtin.arch == builtin.Arch.x86_64) { // TODO add C ABI support for other architectures
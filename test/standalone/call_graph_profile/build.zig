@@ -0,0 +1,11 @@
+const Builder = @import("std").build.Builder;
+
+pub fn build(b: *Builder) void {
+    const exe = b.addExecutable("test", "main.zig");
+    exe.setBuildMode(.ReleaseFast);
+    exe.call_graph_profile = true;
+    exe.addCSourceFile("callee.c", [_][]const u8{});
+
+    const test_step = b.step("test", "Test the program");
+    test_step.dependOn(&exe.run().step);
+}
@@ -0,0 +1,13 @@
+// The padding keeps hot_callee at least 4 KiB away from any other object's
+// code unless the linker moves it next to its caller.
+void padding_before(void) {
+    __asm__ volatile(".fill 4096, 1, 0x90");
+}
+
+unsigned hot_callee(unsigned x) {
+    return x + 1;
+}
+
+void padding_after(void) {
+    __asm__ volatile(".fill 4096, 1, 0x90");
+}
@@ -0,0 +1,24 @@
+extern fn hot_callee(x: u32) u32;
+extern fn padding_before() void;
+extern fn padding_after() void;
+
+export fn hotCaller(n: u32) u32 {
+    var x: u32 = 0;
+    var i: u32 = 0;
+    while (i < n) : (i += 1) x = hot_callee(x);
+    return x;
+}
+
+pub fn main() !void {
+    // Called so that --gc-sections keeps the padding.
+    padding_before();
+    padding_after();
+    if (@noInlineCall(hotCaller, 1000) != 1000) return error.WrongResult;
+
+    // The call in the loop of hotCaller is the heaviest edge of the call
+    // graph, so the linker places the two functions next to each other.
+    const caller = @ptrToInt(hotCaller);
+    const callee = @ptrToInt(hot_callee);
+    const distance = if (callee > caller) callee - caller else caller - callee;
+    if (distance >= 4096) return error.NotOrderedByCallGraph;
+}
@@ -0,0 +1,13 @@
+const Builder = @import("std").build.Builder;
+
+pub fn build(b: *Builder) void {
+    // Only compiled, never run, so the host does not need AVX2.
+    const lib = b.addStaticLibrary("features", "features.zig");
+    lib.setTarget(.x86_64, .linux, .gnu);
+    lib.target_cpu = "x86-64";
+    lib.target_features = "+avx2,+sse4a,-sse4a";
+    lib.addCSourceFile("features.c", [_][]const u8{});
+
+    const test_step = b.step("test", "Test it");
+    test_step.dependOn(&lib.step);
+}
@@ -0,0 +1,11 @@
+#ifndef __AVX2__
+#error "-mattr=+avx2 was not applied to C code"
+#endif
+
+#ifdef __SSE4A__
+#error "-mattr=-sse4a did not override +sse4a in C code"
+#endif
+
+int features_c(void) {
+    return 1;
+}
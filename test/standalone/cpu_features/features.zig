@@ -0,0 +1,19 @@
+const builtin = @import("builtin");
+const std = @import("std");
+
+fn hasFeature(comptime name: []const u8) bool {
+    for (builtin.cpu_features) |feature| {
+        if (std.mem.eql(u8, feature, name)) return true;
+    }
+    return false;
+}
+
+comptime {
+    if (!std.mem.eql(u8, builtin.cpu, "x86-64")) @compileError("-mcpu was not applied");
+    if (!hasFeature("avx2")) @compileError("-mattr=+avx2 was not applied");
+    if (hasFeature("sse4a")) @compileError("-mattr=-sse4a did not override +sse4a");
+}
+
+export fn features_zig() c_int {
+    return 1;
+}
@@ -0,0 +1,69 @@
+const std = @import("std");
+const elf = std.elf;
+const mem = std.mem;
+
+extern fn add(a: c_int, b: c_int) c_int;
+extern fn plus(a: c_int, b: c_int) c_int;
+
+// Identical and never address-taken, like add and plus but emitted by Zig.
+export fn zigSum(a: u32, b: u32) u32 {
+    return a *% 3 +% b;
+}
+
+export fn zigTotal(a: u32, b: u32) u32 {
+    return a *% 3 +% b;
+}
+
+fn twice(x: u32) u32 {
+    return x *% 2;
+}
+
+fn double(x: u32) u32 {
+    return x *% 2;
+}
+
+var twice_addr: usize = undefined;
+var double_addr: usize = undefined;
+var operand: u32 = 21;
+
+pub fn main() !void {
+    const x = @ptrCast(*volatile u32, &operand).*;
+    if (add(40, 2) != 42 or plus(1, 1) != 2) return error.WrongSum;
+    if (zigSum(x, 1) != 64 or zigTotal(x, 2) != 65) return error.WrongSum;
+
+    // The stores and loads are volatile, so LLVM cannot fold the comparison
+    // of two distinct functions to false.
+    @ptrCast(*volatile usize, &twice_addr).* = @ptrToInt(twice);
+    @ptrCast(*volatile usize, &double_addr).* = @ptrToInt(double);
+    const twice_loaded = @ptrCast(*volatile usize, &twice_addr).*;
+    const double_loaded = @ptrCast(*volatile usize, &double_addr).*;
+    if (twice_loaded == double_loaded) return error.AddressTakenFunctionsFolded;
+    if (@noInlineCall(twice, x) != 42 or @noInlineCall(double, x) != 42) return error.WrongProduct;
+
+    // Safe ICF may only fold functions whose objects list their address
+    // significance: -faddrsig for the C object and the addrsig table Zig
+    // emits for its own. Check in the linked binary that both pairs folded.
+    var path_buf: [std.fs.MAX_PATH_BYTES]u8 = undefined;
+    const exe_path = try std.fs.selfExePath(&path_buf);
+    const bytes = try std.io.readFileAllocAligned(std.heap.direct_allocator, exe_path, @alignOf(elf.Ehdr));
+    defer std.heap.direct_allocator.free(bytes);
+
+    if (try symbolValue(bytes, "add") != try symbolValue(bytes, "plus")) return error.CFunctionsNotFolded;
+    if (try symbolValue(bytes, "zigSum") != try symbolValue(bytes, "zigTotal")) return error.ZigFunctionsNotFolded;
+}
+
+fn symbolValue(bytes: []align(@alignOf(elf.Ehdr)) const u8, name: []const u8) !u64 {
+    const ehdr = @ptrCast(*const elf.Ehdr, bytes.ptr);
+    const shdrs = @ptrCast([*]const elf.Shdr, @alignCast(@alignOf(elf.Shdr), bytes.ptr + @intCast(usize, ehdr.e_shoff)))[0..ehdr.e_shnum];
+    for (shdrs) |shdr| {
+        if (shdr.sh_type != elf.SHT_SYMTAB) continue;
+        const strtab = bytes[@intCast(usize, shdrs[shdr.sh_link].sh_offset)..];
+        const sym_count = @intCast(usize, shdr.sh_size / @sizeOf(elf.Sym));
+        const syms = @ptrCast([*]const elf.Sym, @alignCast(@alignOf(elf.Sym), bytes.ptr + @intCast(usize, shdr.sh_offset)))[0..sym_count];
+        for (syms) |sym| {
+            const sym_name = mem.toSliceConst(u8, @ptrCast([*]const u8, strtab.ptr + sym.st_name));
+            if (mem.eql(u8, sym_name, name)) return sym.st_value;
+        }
+    }
+    return error.SymbolNotFound;
+}
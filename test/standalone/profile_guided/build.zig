@@ -0,0 +1,16 @@
+const Builder = @import("std").build.Builder;
+
+pub fn build(b: *Builder) void {
+    const profile_dir = b.pathFromRoot("zig-cache");
+
+    const instrumented = b.addExecutable("hot", "main.zig");
+    instrumented.profile_generate_dir = profile_dir;
+    const record = instrumented.run();
+
+    const optimized = b.addExecutable("hot_pgo", "main.zig");
+    optimized.profile_use_path = b.fmt("{}/hot.zprof", profile_dir);
+    optimized.step.dependOn(&record.step);
+
+    const test_step = b.step("test", "Test the program");
+    test_step.dependOn(&optimized.run().step);
+}
@@ -0,0 +1,15 @@
+fn hot(x: u32) u32 {
+    return x *% 3;
+}
+
+fn cold(x: u32) u32 {
+    return x +% 1;
+}
+
+pub fn main() !void {
+    var i: u32 = 0;
+    var sum: u32 = 0;
+    while (i < 100) : (i += 1) sum +%= @noInlineCall(hot, i);
+    sum = @noInlineCall(cold, sum);
+    if (sum != 14851) return error.WrongSum;
+}
@@ -0,0 +1,13 @@
+const Builder = @import("std").build.Builder;
+
+pub fn build(b: *Builder) void {
+    const test_step = b.step("test", "Test the program");
+
+    const line_tables = b.addExecutable("line_tables", "main.zig");
+    line_tables.line_tables_only = true;
+    test_step.dependOn(&line_tables.run().step);
+
+    const split = b.addExecutable("split", "main.zig");
+    split.split_dwarf = true;
+    test_step.dependOn(&split.run().step);
+}
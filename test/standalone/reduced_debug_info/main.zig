@@ -0,0 +1,10 @@
+const std = @import("std");
+
+// Both modes must still resolve our own return addresses to file and line.
+pub fn main() !void {
+    var buf: [4096]u8 = undefined;
+    var stream = std.io.SliceOutStream.init(buf[0..]);
+    const debug_info = try std.debug.getSelfDebugInfo();
+    try std.debug.writeCurrentStackTrace(&stream.stream, debug_info, false, null);
+    if (std.mem.indexOf(u8, stream.getWritten(), "main.zig:8:") == null) return error.MissingLineInfo;
+}
@@ -0,0 +1,13 @@
+extern fn add(a: c_int, b: c_int) c_int;
+
+fn mul(a: c_int, b: c_int) c_int {
+    var result: c_int = 0;
+    var i: c_int = 0;
+    while (i < b) : (i += 1) result = add(result, a);
+    return result;
+}
+
+pub fn main() !void {
+    if (add(40, 2) != 42) return error.WrongSum;
+    if (mul(6, 7) != 42) return error.WrongProduct;
+}
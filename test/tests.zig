@@ -29,6 +29,7 @@ const TestTarget = struct {
     link_libc: bool = false,
     single_threaded: bool = false,
     disable_native: bool = false,
+    dedup_fns: bool = false,
 };
 
 const test_targets = [_]TestTarget{
@@ -39,6 +40,9 @@ const test_targets = [_]TestTarget{
     TestTarget{
         .single_threaded = true,
     },
+    TestTarget{
+        .dedup_fns = true,
+    },
 
     TestTarget{
         .target = Target{
@@ -435,14 +439,16 @@ pub fn addPkgTests(
 
         const these_tests = b.addTest(root_src);
         these_tests.setNamePrefix(b.fmt(
-            "{}-{}-{}-{}-{} ",
+            "{}-{}-{}-{}-{}{} ",
             name,
             triple_prefix,
             @tagName(test_target.mode),
             libc_prefix,
             if (test_target.single_threaded) "single" else "multi",
+            if (test_target.dedup_fns) "-dedup" else "",
         ));
         these_tests.single_threaded = test_target.single_threaded;
+        these_tests.dedup_fns = test_target.dedup_fns;
         these_tests.setFilter(test_filter);
         these_tests.setBuildMode(test_target.mode);
         these_tests.setTheTarget(test_target.target);
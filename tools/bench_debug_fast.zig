@@ -0,0 +1,80 @@
+// Times `zig test` of a file in the default Debug pipeline and with -fdebug-fast.
+// Building the test binary and running it are timed separately, and the fastest
+// of several runs is printed for each.
+//
+// zig run tools/bench_debug_fast.zig -- <zig-exe> [root-src] [runs]
+// root-src defaults to test/stage1/behavior.zig.
+
+const std = @import("std");
+const mem = std.mem;
+const ChildProcess = std.ChildProcess;
+
+const ns_per_ms = std.time.ns_per_s / std.time.ms_per_s;
+
+const Times = struct {
+    build_ns: u64,
+    run_ns: u64,
+};
+
+pub fn main() anyerror!void {
+    var arena = std.heap.ArenaAllocator.init(std.heap.direct_allocator);
+    defer arena.deinit();
+
+    const allocator = &arena.allocator;
+
+    const args = try std.process.argsAlloc(allocator);
+    if (args.len < 2) {
+        std.debug.warn("usage: bench_debug_fast <zig-exe> [root-src] [runs]\n");
+        return error.InvalidArgs;
+    }
+    const zig_exe = args[1];
+    const root_src = if (args.len > 2) args[2] else "test/stage1/behavior.zig";
+    const runs = if (args.len > 3) try std.fmt.parseInt(usize, args[3], 10) else 3;
+
+    // `echo` stands in for the test runner, so that zig only builds the binary
+    // and prints its path.
+    const debug = try bestTimes(allocator, [_][]const u8{
+        zig_exe,      "test",   root_src, "--cache", "off",
+        "--test-cmd", "echo",   "--test-cmd-bin",
+    }, runs);
+    const fast = try bestTimes(allocator, [_][]const u8{
+        zig_exe,      "test",   root_src, "--cache", "off",
+        "--test-cmd", "echo",   "--test-cmd-bin", "-fdebug-fast",
+    }, runs);
+
+    const stdout = &(try std.io.getStdOut()).outStream().stream;
+    try stdout.print("{}, best of {}\n", root_src, runs);
+    try stdout.print("              build      run\n");
+    try stdout.print("debug:        {} ms  {} ms\n", debug.build_ns / ns_per_ms, debug.run_ns / ns_per_ms);
+    try stdout.print("-fdebug-fast: {} ms  {} ms\n", fast.build_ns / ns_per_ms, fast.run_ns / ns_per_ms);
+}
+
+fn bestTimes(allocator: *mem.Allocator, build_argv: []const []const u8, runs: usize) !Times {
+    var best = Times{
+        .build_ns = std.math.maxInt(u64),
+        .run_ns = std.math.maxInt(u64),
+    };
+    var i: usize = 0;
+    while (i < runs) : (i += 1) {
+        var timer = try std.time.Timer.start();
+        const build_result = try execChecked(allocator, build_argv);
+        best.build_ns = std.math.min(best.build_ns, timer.lap());
+
+        const test_exe_path = mem.trim(u8, build_result.stdout, " \r\n");
+        _ = try execChecked(allocator, [_][]const u8{test_exe_path});
+        best.run_ns = std.math.min(best.run_ns, timer.lap());
+    }
+    return best;
+}
+
+fn execChecked(allocator: *mem.Allocator, argv: []const []const u8) !ChildProcess.ExecResult {
+    const result = try ChildProcess.exec(allocator, argv, null, null, 10 * 1024 * 1024);
+    switch (result.term) {
+        .Exited => |code| if (code != 0) {
+            std.debug.warn("{}\n", result.stderr);
+            return error.CommandFailed;
+        },
+        else => return error.CommandFailed,
+    }
+    return result;
+}
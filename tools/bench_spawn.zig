@@ -0,0 +1,67 @@
+// Measures what os_exec_process in stage1 pays per child with fork+execve versus
+// posix_spawn, from a parent with a large resident heap.
+//
+// zig run tools/bench_spawn.zig --library c -- [heap-MiB] [children]
+
+const std = @import("std");
+const c = std.c;
+
+extern "c" fn posix_spawn(
+    pid: *c_int,
+    path: [*]const u8,
+    file_actions: ?*const c_void,
+    attrp: ?*const c_void,
+    argv: [*]const ?[*]const u8,
+    envp: [*]const ?[*]const u8,
+) c_int;
+extern "c" fn _exit(code: c_int) noreturn;
+
+pub fn main() anyerror!void {
+    var arena = std.heap.ArenaAllocator.init(std.heap.direct_allocator);
+    defer arena.deinit();
+
+    const allocator = &arena.allocator;
+
+    const args = try std.process.argsAlloc(allocator);
+    const heap_mib = if (args.len > 1) try std.fmt.parseInt(usize, args[1], 10) else 2048;
+    const child_count = if (args.len > 2) try std.fmt.parseInt(usize, args[2], 10) else 200;
+
+    // Touch every page so that all of it is mapped when we fork.
+    const heap = try std.heap.direct_allocator.alloc(u8, heap_mib * 1024 * 1024);
+    defer std.heap.direct_allocator.free(heap);
+    std.mem.set(u8, heap, 0xaa);
+
+    const argv = [_]?[*]const u8{ c"/bin/true", null };
+    const envp = [_]?[*]const u8{null};
+
+    var timer = try std.time.Timer.start();
+    var i: usize = 0;
+    while (i < child_count) : (i += 1) {
+        const pid = c.fork();
+        if (pid == -1) return error.ForkFailed;
+        if (pid == 0) {
+            _ = c.execve(argv[0].?, &argv, &envp);
+            _exit(127);
+        }
+        try waitChild(pid);
+    }
+    const fork_ns = timer.lap();
+
+    i = 0;
+    while (i < child_count) : (i += 1) {
+        var pid: c_int = undefined;
+        if (posix_spawn(&pid, argv[0].?, null, null, &argv, &envp) != 0) return error.SpawnFailed;
+        try waitChild(pid);
+    }
+    const spawn_ns = timer.lap();
+
+    const stdout = &(try std.io.getStdOut()).outStream().stream;
+    try stdout.print("{} MiB heap, {} children\n", heap_mib, child_count);
+    try stdout.print("fork+execve: {} us per child\n", fork_ns / child_count / 1000);
+    try stdout.print("posix_spawn: {} us per child\n", spawn_ns / child_count / 1000);
+}
+
+fn waitChild(pid: c_int) !void {
+    var status: c_uint = undefined;
+    if (c.waitpid(pid, &status, 0) == -1) return error.WaitFailed;
+}